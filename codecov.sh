@@ -27,4 +27,19 @@ $SCRIBE --help >/dev/null 2>&1
 # all examples
 for x in examples/*; do echo "$SCRIBE $x"; $SCRIBE $x -s >/dev/null; rm $(basename ${x%.*}); done
 
+# native backend smoke check - these must not fall back to the C backend (say, because the prelude
+# gained something the native backend does not support) and must behave like the C builds
+for x in hello_world recursive_facto vec stringvec; do
+	echo "$SCRIBE examples/$x.sc -N"
+	if $SCRIBE examples/$x.sc -N 2>&1 | grep -q "native backend does not support"; then
+		echo "native backend smoke check failed: examples/$x.sc fell back to the C backend"
+		exit 1
+	fi
+	./$x > $x.native.out
+	$SCRIBE examples/$x.sc >/dev/null
+	./$x > $x.c.out
+	cmp -s $x.native.out $x.c.out || { echo "native backend smoke check failed: examples/$x.sc output differs"; exit 1; }
+	rm $x $x.native.out $x.c.out
+done
+
 cd $CWD
@@ -0,0 +1,62 @@
+let io = @import("std/io");
+let mem = @import("std/mem");
+let vec = @import("std/vec");
+let map = @import("std/map");
+let list = @import("std/list");
+let time = @import("std/c/time");
+
+let comptime REQUESTS: i64 = 2000;
+let comptime ITEMS: i64 = 1000;
+
+// the work done by one request of a server, using containers allocated from alloc
+let handle = fn(alloc: mem.Allocator, req: i64, free: i1): i64 {
+	let v = vec.newIn(i64, true, alloc);
+	let l = list.newIn(i64, true, alloc);
+	let d = map.newIn(i64, i64, alloc);
+	for let i: i64 = 0; i < ITEMS; ++i {
+		v.push(req + i);
+		l.push(req * i);
+		d.add(i, req - i);
+	}
+	let key = req % ITEMS;
+	let res = v[key] + l.back() + d.get(key);
+	if free {
+		v.deinit();
+		l.deinit();
+		d.deinit();
+	}
+	return res;
+};
+
+let main = fn(): i32 {
+	map.setInitCapacity(256);
+	io.println(REQUESTS, " requests, each with a vector, list and map of ", ITEMS, " items");
+
+	let start = time.clock();
+	let heapres: i64 = 0;
+	for let r: i64 = 0; r < REQUESTS; ++r { heapres += handle(mem.heap(), r, true); }
+	let heapms = time.msSince(start);
+
+	// nothing is freed individually, the whole request is released by reset()
+	let arena = mem.newArena(0);
+	defer arena.deinit();
+	start = time.clock();
+	let arenares: i64 = 0;
+	for let r: i64 = 0; r < REQUESTS; ++r {
+		arenares += handle(arena.allocator(), r, false);
+		arena.reset();
+	}
+	let arenams = time.msSince(start);
+
+	// list and map nodes are reused from the pool, vector and map table are malloc'd
+	let pool = mem.newPoolFor(map.KeyNode(i64, i64), 0);
+	defer pool.deinit();
+	start = time.clock();
+	let poolres: i64 = 0;
+	for let r: i64 = 0; r < REQUESTS; ++r { poolres += handle(pool.allocator(), r, true); }
+	let poolms = time.msSince(start);
+
+	io.println("heap: ", heapms, " ms, arena: ", arenams, " ms, pool: ", poolms, " ms (ok: ",
+		   heapres == arenares && heapres == poolres, ")");
+	return 0;
+};
@@ -0,0 +1,70 @@
+let io = @import("std/io");
+let mem = @import("std/mem");
+let vec = @import("std/vec");
+let map = @import("std/map");
+let list = @import("std/list");
+
+// a custom allocator which fails after a budget of bytes is used up
+let Budget = struct {
+	left: u64;
+	failed: u64;
+};
+
+let budgetAlloc = fn(state: *void, size: u64): *void {
+	let b = @as(@ptr(Budget), state);
+	if size > b.left {
+		++b.failed;
+		return nil;
+	}
+	b.left -= size;
+	return mem._malloc(size);
+};
+
+let budgetRealloc = fn(state: *void, data: *void, oldsz: u64, newsz: u64): *void {
+	let b = @as(@ptr(Budget), state);
+	if newsz > oldsz && newsz - oldsz > b.left {
+		++b.failed;
+		return nil;
+	}
+	b.left = b.left + oldsz - newsz;
+	return mem._realloc(data, newsz);
+};
+
+let budgetFree = fn(state: *void, data: *void, size: u64) {
+	let b = @as(@ptr(Budget), state);
+	b.left += size;
+	mem._free(data);
+};
+
+let main = fn(): i32 {
+	let budget = Budget{1048576, 0};
+	let custom = mem.newCustom(@as(@ptr(void), &budget), budgetAlloc, budgetRealloc, budgetFree);
+
+	// the histogram of a tracker does not tell the call sites apart, so each site gets its own
+	// tracker - all of them forward to (and are accumulated by) the total
+	let total = mem.newTracker(custom.allocator(), "total");
+	let vecsite = mem.newTracker(total.allocator(), "vector");
+	let mapsite = mem.newTracker(total.allocator(), "map");
+	let listsite = mem.newTracker(total.allocator(), "list");
+
+	let v = vec.newIn(i64, true, vecsite.allocator());
+	let d = map.newIn(i64, i64, mapsite.allocator());
+	let l = list.newIn(i64, true, listsite.allocator());
+	for let i: i64 = 0; i < 1000; ++i {
+		v.push(i);
+		d.add(i, i * i);
+		l.push(i);
+	}
+	let last: i64 = 999;
+	io.println("sum: ", v[last] + d.get(last) + l.back(), ", budget left: ", budget.left);
+	v.deinit();
+	d.deinit();
+	l.deinit();
+
+	vecsite.report();
+	mapsite.report();
+	listsite.report();
+	total.report();
+	io.println("live: ", total.live, ", budget left: ", budget.left, ", failed: ", budget.failed);
+	return 0;
+};
@@ -0,0 +1,100 @@
+let io = @import("std/io");
+let mem = @import("std/mem");
+let list = @import("std/list");
+let time = @import("std/c/time");
+
+let comptime ROUNDS: i64 = 200;
+let comptime ITEMS: i64 = 10000;
+
+// an event loop style queue: a burst of pushes at the back, then everything is drained from the
+// front, with a few items pushed back as they are processed
+let queueList = fn(l: &list.List(i64)): i64 {
+	let sum: i64 = 0;
+	for let r: i64 = 0; r < ROUNDS; ++r {
+		for let i: i64 = 0; i < ITEMS; ++i { l.push(i); }
+		while !l.isEmpty() {
+			let x = l.frontByVal();
+			l.popFront();
+			if x % 16 == 0 { l.pushVal(x + 1); }
+			sum += x;
+		}
+	}
+	return sum;
+};
+
+let queueDeque = fn(d: &list.Deque(i64)): i64 {
+	let sum: i64 = 0;
+	for let r: i64 = 0; r < ROUNDS; ++r {
+		for let i: i64 = 0; i < ITEMS; ++i { d.push(i); }
+		while !d.isEmpty() {
+			let x = d.frontByVal();
+			d.popFront();
+			if x % 16 == 0 { d.pushVal(x + 1); }
+			sum += x;
+		}
+	}
+	return sum;
+};
+
+// used as a stack: push and pop at the back
+let stackList = fn(l: &list.List(i64)): i64 {
+	let sum: i64 = 0;
+	for let r: i64 = 0; r < ROUNDS; ++r {
+		for let i: i64 = 0; i < ITEMS; ++i { l.push(i); }
+		while !l.isEmpty() {
+			sum += l.back();
+			l.pop();
+		}
+	}
+	return sum;
+};
+
+let stackDeque = fn(d: &list.Deque(i64)): i64 {
+	let sum: i64 = 0;
+	for let r: i64 = 0; r < ROUNDS; ++r {
+		for let i: i64 = 0; i < ITEMS; ++i { d.pushFront(i); }
+		while !d.isEmpty() {
+			sum += d.front();
+			d.popFront();
+		}
+	}
+	return sum;
+};
+
+let main = fn(): i32 {
+	io.println(ROUNDS, " rounds of ", ITEMS, " items");
+
+	let l = list.new(i64, true);
+	defer l.deinit();
+	let pool = mem.newPoolFor(list.Node(i64), 0);
+	defer pool.deinit();
+	let pl = list.newIn(i64, true, pool.allocator());
+	defer pl.deinit();
+	let d = list.newDeque(i64, true);
+	defer d.deinit();
+
+	let start = time.clock();
+	let lres = queueList(l);
+	let lms = time.msSince(start);
+	start = time.clock();
+	let plres = queueList(pl);
+	let plms = time.msSince(start);
+	start = time.clock();
+	let dres = queueDeque(d);
+	let dms = time.msSince(start);
+	io.println("queue: List ", lms, " ms, List (pool) ", plms, " ms, Deque ", dms, " ms (ok: ",
+		   lres == plres && lres == dres, ")");
+
+	start = time.clock();
+	lres = stackList(l);
+	lms = time.msSince(start);
+	start = time.clock();
+	plres = stackList(pl);
+	plms = time.msSince(start);
+	start = time.clock();
+	dres = stackDeque(d);
+	dms = time.msSince(start);
+	io.println("stack: List ", lms, " ms, List (pool) ", plms, " ms, Deque ", dms, " ms (ok: ",
+		   lres == plres && lres == dres, ")");
+	return 0;
+};
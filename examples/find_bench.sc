@@ -0,0 +1,75 @@
+let io = @import("std/io");
+let time = @import("std/c/time");
+let string = @import("std/string");
+
+let comptime LINES: i64 = 100000;
+let comptime ROUNDS: i64 = 20;
+
+// the byte by byte search which StringRef.find() used to do
+let naiveFind = fn(s: StringRef, other: StringRef): u64 {
+	if s.length == 0 || other.length == 0 || other.length > s.length { return STRING_NPOS; }
+	for let i: u64 = 0; i + other.length <= s.length; ++i {
+		let found = true;
+		for let j: u64 = 0; j < other.length; ++j {
+			if s.data[i + j] != other.data[j] {
+				found = false;
+				break;
+			}
+		}
+		if found { return i; }
+	}
+	return STRING_NPOS;
+};
+
+let naiveRFind = fn(s: StringRef, other: StringRef): u64 {
+	if s.length == 0 || other.length == 0 || other.length > s.length { return STRING_NPOS; }
+	let i = s.length - other.length + 1;
+	while i > 0 {
+		--i;
+		let found = true;
+		for let j: u64 = 0; j < other.length; ++j {
+			if s.data[i + j] != other.data[j] {
+				found = false;
+				break;
+			}
+		}
+		if found { return i; }
+	}
+	return STRING_NPOS;
+};
+
+// each round searches from a different offset, so that the compiler cannot hoist the search
+let bench = fn(logs: StringRef, needle: StringRef) {
+	let start = time.clock();
+	let naive: u64 = 0;
+	for let r: i64 = 0; r < ROUNDS; ++r { naive = naiveFind(logs.subRef(r, STRING_NPOS), needle); }
+	let naivems = time.msSince(start);
+	start = time.clock();
+	let res: u64 = 0;
+	for let r: i64 = 0; r < ROUNDS; ++r { res = logs.subRef(r, STRING_NPOS).find(needle); }
+	let findms = time.msSince(start);
+	start = time.clock();
+	let rres: u64 = 0;
+	for let r: i64 = 0; r < ROUNDS; ++r { rres = logs.subRef(0, logs.len() - r).rfind(needle); }
+	let rfindms = time.msSince(start);
+	let ok = res == naive && rres == naiveRFind(logs.subRef(0, logs.len() - ROUNDS + 1), needle);
+	io.println("'", needle, "': naive ", naivems, " ms, find ", findms, " ms, rfind ", rfindms,
+		   " ms (", res, ", ", rres, ", ok: ", ok, ")");
+};
+
+let main = fn(): i32 {
+	let b = string.newBuilder();
+	defer b.deinit();
+	for let i: i64 = 0; i < LINES; ++i {
+		b.add("2024-01-01 12:00:00 [INFO] worker ", i % 16, " served request ", i, " in ", i % 1000, " us\n");
+	}
+	b.add("2024-01-01 12:00:01 [ERROR] worker 3 failed: connection reset\n");
+	let logs = b.ref();
+	io.println("searching ", logs.len(), " bytes, ", ROUNDS, " times");
+	bench(logs, "[ERROR]");
+	bench(logs, "connection refused");
+	bench(logs, "!");
+	bench(logs, "served request 99999 ");
+	bench(logs, "2024-01-01 12:00:00 [INFO] worker 7 served request 7 ");
+	return 0;
+};
@@ -0,0 +1,50 @@
+let io = @import("std/io");
+let mem = @import("std/mem");
+let time = @import("std/c/time");
+let hashing = @import("std/hashing");
+
+let comptime TOTAL: u64 = 134217728; // bytes hashed per benchmark
+
+let gbPerSec = fn(bytes: u64, start: time.clock_t): f64 {
+	let secs = @as(f64, time.clock() - start) / @as(f64, time.CLOCKS_PER_SEC);
+	if secs <= 0.0 { secs = 0.000001; }
+	return @as(f64, bytes) / secs / 1000000000.0;
+};
+
+let benchBytes = fn(buf: *const i8, size: u64) {
+	let sum: u64 = 0;
+	let start = time.clock();
+	let off: u64 = 0;
+	for let done: u64 = 0; done < TOTAL; done += size {
+		// vary the start so that the compiler cannot hoist the hash out of the loop
+		sum += hashing.bytes(@as(@ptr(i8), @as(u64, buf) + off), size);
+		off = (off + 1) & 7;
+	}
+	io.println("bytes(", size, "): ", gbPerSec(TOTAL, start), " GB/s (", sum & 255, ")");
+};
+
+let benchInteger = fn() {
+	let sum: u64 = 0;
+	let comptime count: u64 = TOTAL / 8;
+	let start = time.clock();
+	for let i: u64 = 0; i < count; ++i {
+		sum += hashing.integer(i);
+	}
+	io.println("integer: ", gbPerSec(TOTAL, start), " GB/s (", sum & 255, ")");
+};
+
+let main = fn(): i32 {
+	let comptime size: u64 = 1048576;
+	let buf = mem.alloc(i8, size + 8);
+	defer mem.free(i8, buf);
+	for let i: u64 = 0; i < size + 8; ++i {
+		buf[i] = @as(i8, i * 31);
+	}
+	benchBytes(buf, 8);
+	benchBytes(buf, 16);
+	benchBytes(buf, 64);
+	benchBytes(buf, 1024);
+	benchBytes(buf, size);
+	benchInteger();
+	return 0;
+};
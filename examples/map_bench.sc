@@ -0,0 +1,43 @@
+let io = @import("std/io");
+let map = @import("std/map");
+let time = @import("std/c/time");
+
+let comptime N: i64 = 200000;
+
+let benchDict = fn() {
+	let m = map.new(i64, i64);
+	defer m.deinit();
+	let start = time.clock();
+	for let i: i64 = 0; i < N; ++i {
+		m.add(i * 7, i);
+	}
+	let ins = time.msSince(start);
+	start = time.clock();
+	let found: i64 = 0;
+	for let i: i64 = 0; i < N * 7; ++i {
+		if m.find(i) { ++found; }
+	}
+	io.println("Dict:    insert ", ins, " ms, lookup ", time.msSince(start), " ms, found ", found);
+};
+
+let benchFlat = fn() {
+	let m = map.newFlat(i64, i64);
+	defer m.deinit();
+	let start = time.clock();
+	for let i: i64 = 0; i < N; ++i {
+		m.add(i * 7, i);
+	}
+	let ins = time.msSince(start);
+	start = time.clock();
+	let found: i64 = 0;
+	for let i: i64 = 0; i < N * 7; ++i {
+		if m.find(i) { ++found; }
+	}
+	io.println("FlatMap: insert ", ins, " ms, lookup ", time.msSince(start), " ms, found ", found);
+};
+
+let main = fn(): i32 {
+	benchDict();
+	benchFlat();
+	return 0;
+};
@@ -0,0 +1,97 @@
+let io = @import("std/io");
+let mem = @import("std/mem");
+let vec = @import("std/vec");
+let time = @import("std/c/time");
+let sorting = @import("std/sorting");
+
+let comptime COUNT: u64 = 1000000;
+
+let static RNG: u64 = 88172645463325252;
+
+// xorshift64
+let rand = fn(): u64 {
+	RNG ^= RNG << 13;
+	RNG ^= RNG >> 7;
+	RNG ^= RNG << 17;
+	return RNG;
+};
+
+let fill = fn(v: &vec.Vec(i32), pattern: i32) {
+	v.clear();
+	for let i: u64 = 0; i < COUNT; ++i {
+		let r = rand();
+		let x = @as(i32, r);
+		if pattern == 1 { x = i; }
+		elif pattern == 2 { x = COUNT - i; }
+		elif pattern == 3 { x = r % 16; }
+		elif pattern == 4 { x = i % 1000; }
+		elif pattern == 5 && i % 100 != 0 { x = i; }
+		v.push(x);
+	}
+};
+
+let copy = fn(dst: &vec.Vec(i32), src: &vec.Vec(i32)) {
+	dst.clear();
+	dst.reserve(src.len());
+	mem.cpy(dst.data, src.data, src.len() * @sizeOf(i32));
+	dst.length = src.len();
+};
+
+let isSorted = fn(v: &vec.Vec(i32)): i1 {
+	for let i: u64 = 1; i < v.len(); ++i {
+		if v[i - 1] > v[i] { return false; }
+	}
+	return true;
+};
+
+let same = fn(a: &vec.Vec(i32), b: &vec.Vec(i32)): i1 {
+	return a.len() == b.len() && mem.cmp(a.data, b.data, a.len() * @sizeOf(i32)) == 0;
+};
+
+let bench = fn(name: StringRef, pattern: i32) {
+	let base = vec.new(i32, true);
+	defer base.deinit();
+	let v = vec.new(i32, true);
+	defer v.deinit();
+	let res = vec.new(i32, true);
+	defer res.deinit();
+	fill(base, pattern);
+
+	copy(res, base);
+	let start = time.clock();
+	res.smoothSort(sorting.i32Cmp);
+	let smoothms = time.msSince(start);
+	let ok = isSorted(res);
+
+	copy(v, base);
+	start = time.clock();
+	v.sort(sorting.i32Cmp);
+	let sortms = time.msSince(start);
+	ok = ok && same(v, res);
+
+	copy(v, base);
+	start = time.clock();
+	v.sortAsc();
+	let ascms = time.msSince(start);
+	ok = ok && same(v, res);
+
+	copy(v, base);
+	start = time.clock();
+	v.radixSort();
+	let radixms = time.msSince(start);
+	ok = ok && same(v, res);
+
+	io.println(name, ": smoothSort(cmp) ", smoothms, " ms, sort(cmp) ", sortms, " ms, sortAsc() ",
+		   ascms, " ms, radixSort() ", radixms, " ms (ok: ", ok, ")");
+};
+
+let main = fn(): i32 {
+	io.println("sorting ", COUNT, " i32s");
+	bench("random", 0);
+	bench("sorted", 1);
+	bench("reversed", 2);
+	bench("16 values", 3);
+	bench("sawtooth", 4);
+	bench("1% unsorted", 5);
+	return 0;
+};
@@ -0,0 +1,56 @@
+let io = @import("std/io");
+let time = @import("std/c/time");
+let string = @import("std/string");
+
+let comptime N: i64 = 200000;
+
+// a new string for each log line
+let benchFrom = fn() {
+	let total: u64 = 0;
+	let start = time.clock();
+	for let i: i64 = 0; i < N; ++i {
+		let line = string.from("[INFO] ", "request #", i, " served in ", 0.25, " ms by worker ", i % 16);
+		total += line.len();
+		line.deinit();
+	}
+	io.println("string.from():  ", time.msSince(start), " ms (", total, " bytes)");
+};
+
+// one string, appended to char by char
+let benchAppendChar = fn() {
+	let s = string.new();
+	defer s.deinit();
+	let start = time.clock();
+	for let i: i64 = 0; i < N * 64; ++i {
+		s.appendChar('a');
+	}
+	io.println("appendChar():   ", time.msSince(start), " ms (", s.len(), " bytes)");
+};
+
+// one builder, reset for each log line
+let benchBuilder = fn() {
+	let total: u64 = 0;
+	let b = string.newBuilder();
+	defer b.deinit();
+	b.reserve(128);
+	let start = time.clock();
+	for let i: i64 = 0; i < N; ++i {
+		b.reset();
+		b.add("[INFO] ", "request #", i, " served in ", 0.25, " ms by worker ", i % 16);
+		total += b.len();
+	}
+	io.println("StringBuilder:  ", time.msSince(start), " ms (", total, " bytes)");
+};
+
+let main = fn(): i32 {
+	let b = string.newBuilder();
+	defer b.deinit();
+	b.add("short").add(' ', 42);
+	let s = b.take();
+	defer s.deinit();
+	io.println(s, " (inline: ", s.isInline(), ")");
+	benchFrom();
+	benchAppendChar();
+	benchBuilder();
+	return 0;
+};
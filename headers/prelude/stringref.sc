@@ -1,6 +1,7 @@
 // this is a prelude file - it is ALWAYS imported before the invoked program
 
 let c = @import("std/c");
+let core = @import("std/core");
 let hashing = @import("std/hashing");
 
 let comptime global STRING_NPOS: const u64 = -1;
@@ -50,7 +51,7 @@ let isEmpty in const StringRef = inline fn(): i1 {
 };
 
 let hash in const StringRef = inline fn(): u64 {
-	return hashing.cStr(self.data, self.length);
+	return hashing.bytes(self.data, self.length);
 };
 
 let __assn__ in StringRef = fn(other: StringRef): &self {
@@ -73,69 +74,358 @@ let __ne__ in const StringRef = inline fn(other: StringRef): i1 {
 	return !(self == other);
 };
 
+// Substring search
+// Single bytes are found using memchr/memrchr. Longer strings use a first-last byte filter: the first and
+// last bytes of other are compared at 8 candidate positions at once (bytes of a u64), and only
+// the positions where both match are compared fully.
+
+let comptime FIND_LSBS: u64 = 0x0101010101010101;
+let comptime FIND_MSBS: u64 = 0x8080808080808080;
+
+// high bit is set in the bytes of x which are zero
+// (exact for the lowest zero byte, the bytes above it can be false positives)
+let zeroBytes = inline fn(x: u64): u64 {
+	return (x - FIND_LSBS) & ~x & FIND_MSBS;
+};
+
+// data + idx need not be aligned for u64
+let loadWord = inline fn(data: *const i8, idx: u64): u64 {
+	let v: u64 = 0;
+	c.memcpy(@as(@ptr(i8), &v), @as(@ptr(i8), @as(u64, data) + idx), 8);
+	return v;
+};
+
+// index of the lowest/highest byte of mask (not zero) which has its high bit set
+let lowestByte = fn(mask: u64): u64 {
+	let n: u64 = 0;
+	if (mask & 0xffffffff) == 0 {
+		n += 4;
+		mask >>= 32;
+	}
+	if (mask & 0xffff) == 0 {
+		n += 2;
+		mask >>= 16;
+	}
+	if (mask & 0xff) == 0 { n += 1; }
+	return n;
+};
+let highestByte = fn(mask: u64): u64 {
+	let n: u64 = 0;
+	if mask >> 32 {
+		n += 4;
+		mask >>= 32;
+	}
+	if mask >> 16 {
+		n += 2;
+		mask >>= 16;
+	}
+	if mask >> 8 { n += 1; }
+	return n;
+};
+
+// bytes i to i + 7 of self at which other may begin
+let findCandidates in const StringRef = inline fn(other: &const StringRef, first: u64, last: u64,
+						  i: u64): u64 {
+	return zeroBytes(loadWord(self.data, i) ^ first) &
+	       zeroBytes(loadWord(self.data, i + other.length - 1) ^ last);
+};
+
+let matchesAt in const StringRef = inline fn(other: &const StringRef, i: u64): i1 {
+	return c.memcmp(&self.data[i], other.data, other.length) == 0;
+};
+
 let find in const StringRef = fn(other: StringRef): u64 {
-	let slen = self.len();
-	let olen = other.len();
+	let slen = self.length;
+	let olen = other.length;
 	if slen == 0 || olen == 0 || olen > slen { return STRING_NPOS; }
-	let pos: u64 = STRING_NPOS;
-	for let i: u64 = 0; i < slen; ++i {
-		if self.data[i] != *other.data { continue; }
-		let found = true;
-		for let j: u64 = 0; j < olen; ++j {
-			if i + j >= slen || self.data[i + j] != other.data[j] {
-				found = false;
-				break;
-			}
+	if olen == 1 {
+		let p = c.memchr(self.data, other.data[0], slen);
+		if @as(u64, p) == nil { return STRING_NPOS; }
+		return @as(u64, p) - @as(u64, self.data);
+	}
+	let first = FIND_LSBS * @as(u64, @as(u8, other.data[0]));
+	let last = FIND_LSBS * @as(u64, @as(u8, other.data[olen - 1]));
+	let end = slen - olen + 1; // other can begin at [0, end)
+	let i: u64 = 0;
+	while i + 8 <= end {
+		let mask = self.findCandidates(other, first, last, i);
+		while mask {
+			let pos = i + lowestByte(mask);
+			if self.matchesAt(other, pos) { return pos; }
+			mask &= mask - 1;
 		}
-		if !found { continue; }
-		pos = i;
-		break;
+		i += 8;
+	}
+	while i < end {
+		if self.matchesAt(other, i) { return i; }
+		++i;
+	}
+	return STRING_NPOS;
+};
+
+let rfindByte in const StringRef = fn(ch: i8): u64 {
+	inline if core.currentOS == core.os.Apple || core.currentOS == core.os.Windows {
+		let i = self.length;
+		while i > 0 {
+			--i;
+			if self.data[i] == ch { return i; }
+		}
+		return STRING_NPOS;
+	} else {
+		let p = c.memrchr(self.data, ch, self.length);
+		if @as(u64, p) == nil { return STRING_NPOS; }
+		return @as(u64, p) - @as(u64, self.data);
 	}
-	return pos;
 };
 
 let rfind in const StringRef = fn(other: StringRef): u64 {
-	let slen = self.len();
-	let olen = other.len();
+	let slen = self.length;
+	let olen = other.length;
 	if slen == 0 || olen == 0 || olen > slen { return STRING_NPOS; }
-	let pos: u64 = STRING_NPOS;
-	let i: u64 = slen - 1, j: u64 = olen - 1;
-	let found = false;
-	while i >= 0 && j >= 0 {
-		if self.data[i] != other.data[j] {
-			if i == 0 { break; }
-			--i;
-			found = false;
-			continue;
+	if olen == 1 {
+		return self.rfindByte(other.data[0]);
+	}
+	let first = FIND_LSBS * @as(u64, @as(u8, other.data[0]));
+	let last = FIND_LSBS * @as(u64, @as(u8, other.data[olen - 1]));
+	let i = slen - olen + 1; // other can begin at [0, i)
+	while i >= 8 {
+		i -= 8;
+		let mask = self.findCandidates(other, first, last, i);
+		while mask {
+			let b = highestByte(mask);
+			if self.matchesAt(other, i + b) { return i + b; }
+			mask &= ~(@as(u64, 128) << (b * 8));
 		}
-		found = true;
-		if j == 0 { pos = i; }
-		if i == 0 || j == 0 { break; }
+	}
+	while i > 0 {
 		--i;
-		--j;
+		if self.matchesAt(other, i) { return i; }
 	}
-	return pos;
+	return STRING_NPOS;
 };
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 // Conversion Functions
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
+// Parsers work directly on the span of the StringRef and follow the semantics of std::from_chars():
+// - no leading whitespace or '+' is accepted, and there is no base prefix (0x, 0)
+// - the longest valid prefix is parsed, ParseResult.len is the number of chars used
+// - res is only written when err is ParseErr.OK
+// - on ParseErr.INVALID (no number at the start), len is 0
+// - on ParseErr.RANGE (the number does not fit in res), len covers the whole number
+
+let global ParseErr = enum : i8 {
+	OK,
+	INVALID,
+	RANGE,
+};
+
+let global ParseResult = struct {
+	len: u64;
+	err: @enumTagTy(ParseErr);
+};
+
+// value of ch as a digit in base, or base if it is not a valid digit
+let digitVal = inline fn(ch: i8, base: u64): u64 {
+	let d = base;
+	if ch >= '0' && ch <= '9' { d = @as(u64, ch - '0'); }
+	elif ch >= 'a' && ch <= 'z' { d = @as(u64, ch - 'a') + 10; }
+	elif ch >= 'A' && ch <= 'Z' { d = @as(u64, ch - 'A') + 10; }
+	if d >= base { return base; }
+	return d;
+};
+
+// parses the digits at [start, length) into res which must not exceed max (base: 2 to 36)
+let parseDigits in const StringRef = fn(start: u64, base: u64, max: u64, res: &u64): ParseResult {
+	let i = start;
+	let v: u64 = 0;
+	let overflow = false;
+	let limit = max / base;
+	while i < self.length {
+		let d = digitVal(self.data[i], base);
+		if d == base { break; }
+		if v > limit || v * base > max - d { overflow = true; }
+		else { v = v * base + d; }
+		++i;
+	}
+	if i == start { return ParseResult{0, ParseErr.INVALID}; }
+	if overflow { return ParseResult{i, ParseErr.RANGE}; }
+	res = v;
+	return ParseResult{i, ParseErr.OK};
+};
+
+let parseUInt in const StringRef = fn(res: &u64, base: i32): ParseResult {
+	if base < 2 || base > 36 { return ParseResult{0, ParseErr.INVALID}; }
+	return self.parseDigits(0, base, STRING_NPOS, res);
+};
+
+let parseInt in const StringRef = fn(res: &i64, base: i32): ParseResult {
+	if base < 2 || base > 36 { return ParseResult{0, ParseErr.INVALID}; }
+	let neg = self.length > 0 && self.data[0] == '-';
+	let max: u64 = 9223372036854775807;
+	let v: u64 = 0;
+	let pr = self.parseDigits(@as(u64, neg), base, max + @as(u64, neg), v);
+	if pr.err == ParseErr.OK {
+		if neg { res = @as(i64, @as(u64, 0) - v); }
+		else { res = v; }
+	}
+	return pr;
+};
+
+// 10^e for e in [0, 22] - every power and product on the way is exactly representable in f64
+// (no static table: the prelude is part of every program and the native backend has no f64 data)
+let pow10Flt = fn(e: u64): f64 {
+	let res: f64 = 1.0;
+	let p: f64 = 10.0;
+	while e > 0 {
+		if e & 1 { res *= p; }
+		p *= p;
+		e >>= 1;
+	}
+	return res;
+};
+
+// case insensitive check for a (lowercase) word at start
+let hasWordAt in const StringRef = fn(start: u64, word: StringRef): i1 {
+	if start + word.length > self.length { return false; }
+	for let i: u64 = 0; i < word.length; ++i {
+		let ch = self.data[start + i];
+		if ch >= 'A' && ch <= 'Z' { ch = ch - 'A' + 'a'; }
+		if ch != word.data[i] { return false; }
+	}
+	return true;
+};
+
+// decimal floats: [-]digits[.digits][(e|E)[+|-]digits], inf, infinity, nan
+// Numbers with at most 19 significant digits, a value below 2^53 and an exponent in [-22, 22] are
+// computed exactly here (Clinger's fast path). Others are given to strtod() - via a stack copy, so
+// spans of 1024 chars or more are rejected as ParseErr.INVALID.
+let parseFlt in const StringRef = fn(res: &f64): ParseResult {
+	let i: u64 = 0;
+	let neg = self.length > 0 && self.data[0] == '-';
+	if neg { ++i; }
+	if self.hasWordAt(i, "infinity") || self.hasWordAt(i, "inf") {
+		let inf = 1.0 / 0.0;
+		if neg { inf = -inf; }
+		res = inf;
+		if self.hasWordAt(i, "infinity") { return ParseResult{i + 8, ParseErr.OK}; }
+		return ParseResult{i + 3, ParseErr.OK};
+	}
+	if self.hasWordAt(i, "nan") {
+		res = 0.0 / 0.0;
+		return ParseResult{i + 3, ParseErr.OK};
+	}
+	let mantissa: u64 = 0;
+	let sigdigits: u64 = 0; // significant digits seen
+	let exp10: i64 = 0;
+	let digits: u64 = 0;
+	let nonzero = false;
+	while i < self.length && self.data[i] >= '0' && self.data[i] <= '9' {
+		if sigdigits < 19 {
+			mantissa = mantissa * 10 + @as(u64, self.data[i] - '0');
+			if mantissa > 0 { ++sigdigits; }
+		} else {
+			++exp10;
+			++sigdigits;
+		}
+		++i;
+		++digits;
+	}
+	if i < self.length && self.data[i] == '.' {
+		++i;
+		while i < self.length && self.data[i] >= '0' && self.data[i] <= '9' {
+			if sigdigits < 19 {
+				mantissa = mantissa * 10 + @as(u64, self.data[i] - '0');
+				if mantissa > 0 { ++sigdigits; }
+				--exp10;
+			} else {
+				++sigdigits;
+			}
+			++i;
+			++digits;
+		}
+	}
+	if digits == 0 { return ParseResult{0, ParseErr.INVALID}; }
+	if i < self.length && (self.data[i] == 'e' || self.data[i] == 'E') {
+		let j = i + 1;
+		let eneg = j < self.length && self.data[j] == '-';
+		if j < self.length && (self.data[j] == '-' || self.data[j] == '+') { ++j; }
+		let e: u64 = 0;
+		let edigits: u64 = 0;
+		while j < self.length && self.data[j] >= '0' && self.data[j] <= '9' {
+			if e < 100000 { e = e * 10 + @as(u64, self.data[j] - '0'); }
+			++j;
+			++edigits;
+		}
+		// without digits, the 'e' is not part of the number
+		if edigits > 0 {
+			if eneg { exp10 -= @as(i64, e); }
+			else { exp10 += @as(i64, e); }
+			i = j;
+		}
+	}
+	let v: f64 = 0.0;
+	if sigdigits <= 19 && mantissa <= 9007199254740992 && exp10 >= -22 && exp10 <= 22 {
+		v = @as(f64, mantissa);
+		if exp10 < 0 { v = v / pow10Flt(-exp10); }
+		else { v = v * pow10Flt(exp10); }
+		if neg { v = -v; }
+	} else {
+		if i >= 1024 { return ParseResult{0, ParseErr.INVALID}; }
+		let tmp: @array(i8, 1024);
+		c.memcpy(tmp, self.data, i);
+		tmp[i] = '\0';
+		v = c.strtod(tmp, nil);
+		let zero = 0.0;
+		if v - v != zero || (v == zero && mantissa > 0) { return ParseResult{i, ParseErr.RANGE}; }
+	}
+	res = v;
+	return ParseResult{i, ParseErr.OK};
+};
+
+// Convenience functions, as lenient as atoll()/atof() were: leading whitespace and a '+' sign are
+// skipped, numbers out of range saturate, and 0 is returned if there is no number.
+// Use the parse*() functions above for the strict from_chars() behavior.
+
+// self without the leading whitespace and '+' sign (but not "+-")
+let numStart in const StringRef = fn(): StringRef {
+	let i: u64 = 0;
+	while i < self.length && (self.data[i] == ' ' || (self.data[i] >= '\t' && self.data[i] <= '\r')) {
+		++i;
+	}
+	if i + 1 < self.length && self.data[i] == '+' && self.data[i + 1] != '-' { ++i; }
+	return self.subRef(i, STRING_NPOS);
+};
+
 let int in const StringRef = fn(): i64 {
-	let tmp: @array(i8, 1024);
-	c.strncpy(tmp, self.data, self.length);
-	tmp[self.length] = '\0';
-	return c.atoll(tmp);
+	let s = self.numStart();
+	let res: i64 = 0;
+	let pr = s.parseInt(res, 10);
+	if pr.err == ParseErr.RANGE {
+		let max: i64 = 9223372036854775807;
+		if s.data[0] == '-' { return -max - 1; }
+		return max;
+	}
+	return res;
 };
 let uint in const StringRef = fn(): u64 {
-	let tmp: @array(i8, 1024);
-	c.strncpy(tmp, self.data, self.length);
-	tmp[self.length] = '\0';
-	return c.atoull(tmp);
+	let res: u64 = 0;
+	let pr = self.numStart().parseUInt(res, 10);
+	if pr.err == ParseErr.RANGE { return STRING_NPOS; } // u64 max
+	return res;
 };
 let flt in const StringRef = fn(): f64 {
-	let tmp: @array(i8, 1024);
-	c.strncpy(tmp, self.data, self.length);
-	tmp[self.length] = '\0';
-	return c.atof(tmp);
-};
\ No newline at end of file
+	let s = self.numStart();
+	let res: f64 = 0.0;
+	let pr = s.parseFlt(res);
+	if pr.err == ParseErr.RANGE {
+		// strtod() gives the saturated value (+-HUGE_VAL, or 0 on underflow), and len is below
+		// 1024 here as only its path reports RANGE
+		let tmp: @array(i8, 1024);
+		c.memcpy(tmp, s.data, pr.len);
+		tmp[pr.len] = '\0';
+		res = c.strtod(tmp, nil);
+	}
+	return res;
+};
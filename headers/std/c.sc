@@ -34,6 +34,11 @@ let strlen = extern[strlen, "<string.h>"] fn(data: *const i8): u64;
 let strcmp = extern[strcmp, "<string.h>"] fn(lhs: *const i8, rhs: *const i8): i32;
 let strcpy = extern[strcpy, "<string.h>"] fn(dest: *i8, src: *const i8): *i8;
 let strncmp = extern[strncmp, "<string.h>"] fn(lhs: *const i8, rhs: *const i8, count: u64): i32;
+let memchr = extern[memchr, "<string.h>"] fn(data: *const i8, ch: i32, count: u64): *const i8;
+// not available on Apple/Windows
+let memrchr = extern[memrchr, "<string.h>"] fn(data: *const i8, ch: i32, count: u64): *const i8;
+let memcpy = extern[memcpy, "<string.h>"] fn(dest: *i8, src: *const i8, count: u64): *i8;
+let memcmp = extern[memcmp, "<string.h>"] fn(lhs: *const i8, rhs: *const i8, count: u64): i32;
 let strncpy = extern[strncpy, "<string.h>"] fn(dest: *i8, src: *const i8, count: u64): *i8;
 let getenv = extern[getenv, "<stdlib.h>"] fn(name: *const i8): *const i8; // in C, actually returns *i8
 let setenv = extern[setenv, "<stdlib.h>"] fn(name: *const i8, val: *const i8, overwrite: i1): i32;
@@ -46,6 +51,7 @@ let _wexitstatus = extern[WEXITSTATUS, "<stdlib.h>"] fn(status: i32): i32;
 let atoll = extern[atoll, "<stdlib.h>"] fn(str: *const i8): i64;
 let atoull = extern[atoull, "<stdlib.h>"] fn(str: *const i8): u64;
 let atof =  extern[atof, "<stdlib.h>"] fn(str: *const i8): f64;
+let strtod = extern[strtod, "<stdlib.h>"] fn(str: *const i8, end: **i8): f64;
 
 let getTypeSpecifier = inline fn(comptime ty: type): *const i8 {
 	inline if @isEqualTy(ty, i1) || @isEqualTy(ty, i16) || @isEqualTy(ty, i32) {
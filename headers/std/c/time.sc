@@ -1,6 +1,8 @@
 let ctype = @import("std/c/types");
 
 let comptime time_t = ctype.long;
+let comptime clock_t = ctype.long;
+let comptime CLOCKS_PER_SEC: clock_t = 1000000; // as required by POSIX
 
 let tm = extern[struct tm, "<time.h>"] struct {
 	tm_sec: i32;
@@ -16,6 +18,11 @@ let tm = extern[struct tm, "<time.h>"] struct {
 	tm_zone: *const i8;
 };
 
+let clock = extern[clock, "<time.h>"] fn(): clock_t;
+// milliseconds of processor time since start (a value returned by clock())
+let msSince = fn(start: clock_t): f64 {
+	return @as(f64, clock() - start) * 1000.0 / @as(f64, CLOCKS_PER_SEC);
+};
 let time = extern[time, "<time.h>"] fn(timer: *const time_t): time_t;
 let localtime = extern[localtime, "<time.h>"] fn(timer: *const time_t): *tm;
 let strftime = extern[strftime, "<time.h>"] fn(str: *i8, count: u64, format: *const i8, time: *const tm): u64;
@@ -46,12 +46,12 @@ let allToRef = fn(data: ...&const any): StringRef {
 	let comptime len = @valen();
 	inline if len == 1 && @isCString(data[0]) {
 		return string.getRefCStr(data[0]);
-	} elif len == 1 && @isEqualTy(data[0], string.String) {
-		return data[0].ref();
 	} elif len == 1 && @isEqualTy(data[0], StringRef) {
 		return data[0];
 	} else {
+		// Strings are copied too - a (short) String's ref() points into the String itself
 		let errstr = string.new();
+		defer errstr.deinit(); // push() copies it
 		inline for let comptime i = 0; i < len; ++i {
 			errstr.append(data[i]); // String.append() is a generic function
 		}
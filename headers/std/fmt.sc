@@ -0,0 +1,533 @@
+// Allocation free formatting of numbers into caller provided buffers
+//
+// Integers are written two digits at a time using a table of digit pairs.
+// Floats use Grisu2 (Printing Floating-Point Numbers Quickly and Accurately with Integers,
+// Florian Loitsch, 2010) which produces the shortest (or very nearly so) digits that still read
+// back as the same value. Implementation follows https://github.com/miloyip/dtoa-benchmark.
+//
+// None of the functions write a null terminator.
+//
+// The native backend has no floating point support, so programs which use the float functions
+// fall back to the C backend. This includes every program importing std/string (appendFlt()),
+// same as before this file existed.
+
+let mem = @import("std/mem");
+
+let comptime INT_MAX_LEN: const u64 = 20; // -9223372036854775808, 18446744073709551615
+let comptime FLT_MAX_LEN: const u64 = 40; // enough for both writeFltShortest() and writeFltFixed()
+
+let comptime DIGIT_PAIRS = "00010203040506070809101112131415161718192021222324252627282930313233343536373839404142434445464748495051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Integers
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+// number of decimal digits in data
+let uintLen = fn(data: u64): u64 {
+	let n: u64 = 1;
+	let p: u64 = 10;
+	while n < 20 && data >= p {
+		++n;
+		p *= 10;
+	}
+	return n;
+};
+
+let intLen = inline fn(data: i64): u64 {
+	if data >= 0 { return uintLen(data); }
+	return uintLen(@as(u64, 0) - @as(u64, data)) + 1;
+};
+
+let writeUInt = fn(buf: *i8, data: u64): u64 {
+	let n = uintLen(data);
+	let pos = n;
+	while data >= 100 {
+		let q = data / 100;
+		let r = (data - q * 100) * 2;
+		pos -= 2;
+		buf[pos] = DIGIT_PAIRS.data[r];
+		buf[pos + 1] = DIGIT_PAIRS.data[r + 1];
+		data = q;
+	}
+	if data >= 10 {
+		buf[0] = DIGIT_PAIRS.data[data * 2];
+		buf[1] = DIGIT_PAIRS.data[data * 2 + 1];
+	} else {
+		buf[0] = @as(i8, data) + '0';
+	}
+	return n;
+};
+
+let writeInt = fn(buf: *i8, data: i64): u64 {
+	if data >= 0 { return writeUInt(buf, data); }
+	buf[0] = '-';
+	// works for i64min as well
+	return writeUInt(&buf[1], @as(u64, 0) - @as(u64, data)) + 1;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Grisu2
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+let comptime HIDDEN_BIT: u64 = 0x0010000000000000;
+let comptime SIGNIFICAND_MASK: u64 = 0x000fffffffffffff;
+let comptime LO32: u64 = 0xffffffff;
+
+// floating point number f * 2^e
+let DiyFp = struct {
+	f: u64;
+	e: i32;
+};
+
+let static cachedpowers_f: @array(u64, 87);
+let static cachedpowers_e: @array(i32, 87);
+let static pow10: @array(u64, 20);
+let static tables_inited = false;
+
+let setCachedPower = fn(idx: u64, f: u64, e: i32) {
+	cachedpowers_f[idx] = f;
+	cachedpowers_e[idx] = e;
+};
+
+// 10^k for k = -348, -340, ..., 340
+let initTables = fn() {
+	if tables_inited { return; }
+	setCachedPower(0, 0xfa8fd5a0081c0288, -1220);
+	setCachedPower(1, 0xbaaee17fa23ebf76, -1193);
+	setCachedPower(2, 0x8b16fb203055ac76, -1166);
+	setCachedPower(3, 0xcf42894a5dce35ea, -1140);
+	setCachedPower(4, 0x9a6bb0aa55653b2d, -1113);
+	setCachedPower(5, 0xe61acf033d1a45df, -1087);
+	setCachedPower(6, 0xab70fe17c79ac6ca, -1060);
+	setCachedPower(7, 0xff77b1fcbebcdc4f, -1034);
+	setCachedPower(8, 0xbe5691ef416bd60c, -1007);
+	setCachedPower(9, 0x8dd01fad907ffc3c, -980);
+	setCachedPower(10, 0xd3515c2831559a83, -954);
+	setCachedPower(11, 0x9d71ac8fada6c9b5, -927);
+	setCachedPower(12, 0xea9c227723ee8bcb, -901);
+	setCachedPower(13, 0xaecc49914078536d, -874);
+	setCachedPower(14, 0x823c12795db6ce57, -847);
+	setCachedPower(15, 0xc21094364dfb5637, -821);
+	setCachedPower(16, 0x9096ea6f3848984f, -794);
+	setCachedPower(17, 0xd77485cb25823ac7, -768);
+	setCachedPower(18, 0xa086cfcd97bf97f4, -741);
+	setCachedPower(19, 0xef340a98172aace5, -715);
+	setCachedPower(20, 0xb23867fb2a35b28e, -688);
+	setCachedPower(21, 0x84c8d4dfd2c63f3b, -661);
+	setCachedPower(22, 0xc5dd44271ad3cdba, -635);
+	setCachedPower(23, 0x936b9fcebb25c996, -608);
+	setCachedPower(24, 0xdbac6c247d62a584, -582);
+	setCachedPower(25, 0xa3ab66580d5fdaf6, -555);
+	setCachedPower(26, 0xf3e2f893dec3f126, -529);
+	setCachedPower(27, 0xb5b5ada8aaff80b8, -502);
+	setCachedPower(28, 0x87625f056c7c4a8b, -475);
+	setCachedPower(29, 0xc9bcff6034c13053, -449);
+	setCachedPower(30, 0x964e858c91ba2655, -422);
+	setCachedPower(31, 0xdff9772470297ebd, -396);
+	setCachedPower(32, 0xa6dfbd9fb8e5b88f, -369);
+	setCachedPower(33, 0xf8a95fcf88747d94, -343);
+	setCachedPower(34, 0xb94470938fa89bcf, -316);
+	setCachedPower(35, 0x8a08f0f8bf0f156b, -289);
+	setCachedPower(36, 0xcdb02555653131b6, -263);
+	setCachedPower(37, 0x993fe2c6d07b7fac, -236);
+	setCachedPower(38, 0xe45c10c42a2b3b06, -210);
+	setCachedPower(39, 0xaa242499697392d3, -183);
+	setCachedPower(40, 0xfd87b5f28300ca0e, -157);
+	setCachedPower(41, 0xbce5086492111aeb, -130);
+	setCachedPower(42, 0x8cbccc096f5088cc, -103);
+	setCachedPower(43, 0xd1b71758e219652c, -77);
+	setCachedPower(44, 0x9c40000000000000, -50);
+	setCachedPower(45, 0xe8d4a51000000000, -24);
+	setCachedPower(46, 0xad78ebc5ac620000, 3);
+	setCachedPower(47, 0x813f3978f8940984, 30);
+	setCachedPower(48, 0xc097ce7bc90715b3, 56);
+	setCachedPower(49, 0x8f7e32ce7bea5c70, 83);
+	setCachedPower(50, 0xd5d238a4abe98068, 109);
+	setCachedPower(51, 0x9f4f2726179a2245, 136);
+	setCachedPower(52, 0xed63a231d4c4fb27, 162);
+	setCachedPower(53, 0xb0de65388cc8ada8, 189);
+	setCachedPower(54, 0x83c7088e1aab65db, 216);
+	setCachedPower(55, 0xc45d1df942711d9a, 242);
+	setCachedPower(56, 0x924d692ca61be758, 269);
+	setCachedPower(57, 0xda01ee641a708dea, 295);
+	setCachedPower(58, 0xa26da3999aef774a, 322);
+	setCachedPower(59, 0xf209787bb47d6b85, 348);
+	setCachedPower(60, 0xb454e4a179dd1877, 375);
+	setCachedPower(61, 0x865b86925b9bc5c2, 402);
+	setCachedPower(62, 0xc83553c5c8965d3d, 428);
+	setCachedPower(63, 0x952ab45cfa97a0b3, 455);
+	setCachedPower(64, 0xde469fbd99a05fe3, 481);
+	setCachedPower(65, 0xa59bc234db398c25, 508);
+	setCachedPower(66, 0xf6c69a72a3989f5c, 534);
+	setCachedPower(67, 0xb7dcbf5354e9bece, 561);
+	setCachedPower(68, 0x88fcf317f22241e2, 588);
+	setCachedPower(69, 0xcc20ce9bd35c78a5, 614);
+	setCachedPower(70, 0x98165af37b2153df, 641);
+	setCachedPower(71, 0xe2a0b5dc971f303a, 667);
+	setCachedPower(72, 0xa8d9d1535ce3b396, 694);
+	setCachedPower(73, 0xfb9b7cd9a4a7443c, 720);
+	setCachedPower(74, 0xbb764c4ca7a44410, 747);
+	setCachedPower(75, 0x8bab8eefb6409c1a, 774);
+	setCachedPower(76, 0xd01fef10a657842c, 800);
+	setCachedPower(77, 0x9b10a4e5e9913129, 827);
+	setCachedPower(78, 0xe7109bfba19c0c9d, 853);
+	setCachedPower(79, 0xac2820d9623bf429, 880);
+	setCachedPower(80, 0x80444b5e7aa7cf85, 907);
+	setCachedPower(81, 0xbf21e44003acdd2d, 933);
+	setCachedPower(82, 0x8e679c2f5e44ff8f, 960);
+	setCachedPower(83, 0xd433179d9c8cb841, 986);
+	setCachedPower(84, 0x9e19db92b4e31ba9, 1013);
+	setCachedPower(85, 0xeb96bf6ebadf77d9, 1039);
+	setCachedPower(86, 0xaf87023b9bf0ee6b, 1066);
+	pow10[0] = 1;
+	for let i: u64 = 1; i < 20; ++i {
+		pow10[i] = pow10[i - 1] * 10;
+	}
+	tables_inited = true;
+};
+
+// upper 64 bits of the product (rounded)
+let mulDiy = fn(x: DiyFp, y: DiyFp): DiyFp {
+	let xh = x.f >> 32;
+	let xl = x.f & LO32;
+	let yh = y.f >> 32;
+	let yl = y.f & LO32;
+	let hh = xh * yh;
+	let lh = xl * yh;
+	let hl = xh * yl;
+	let ll = xl * yl;
+	let tmp = (ll >> 32) + (hl & LO32) + (lh & LO32);
+	tmp += @as(u64, 1) << 31; // round
+	return DiyFp{hh + (hl >> 32) + (lh >> 32) + (tmp >> 32), x.e + y.e + 64};
+};
+
+// moves the last digit closer to the actual value, as long as it stays in the safe interval
+let grisuRound = fn(buf: *i8, len: u64, delta: u64, rest: u64, tenkappa: u64, wpw: u64) {
+	while rest < wpw && delta - rest >= tenkappa &&
+	      (rest + tenkappa < wpw || wpw - rest > rest + tenkappa - wpw) {
+		--buf[len - 1];
+		rest += tenkappa;
+	}
+};
+
+let digitGen = fn(w: DiyFp, mp: DiyFp, delta: u64, buf: *i8, k: &i32): u64 {
+	let shift = @as(u64, -mp.e);
+	let one = @as(u64, 1) << shift;
+	let wpw = mp.f - w.f;
+	let p1 = mp.f >> shift;
+	let p2 = mp.f & (one - 1);
+	let kappa = @as(i32, uintLen(p1));
+	let len: u64 = 0;
+	while kappa > 0 {
+		let p = pow10[kappa - 1];
+		let d = p1 / p;
+		p1 -= d * p;
+		if d || len { buf[len++] = @as(i8, d) + '0'; }
+		--kappa;
+		let tmp = (p1 << shift) + p2;
+		if tmp <= delta {
+			k += kappa;
+			grisuRound(buf, len, delta, tmp, pow10[kappa] << shift, wpw);
+			return len;
+		}
+	}
+	while true {
+		p2 *= 10;
+		delta *= 10;
+		let d = p2 >> shift;
+		if d || len { buf[len++] = @as(i8, d) + '0'; }
+		p2 &= one - 1;
+		--kappa;
+		if p2 < delta {
+			k += kappa;
+			let mult: u64 = 0;
+			if -kappa < 20 { mult = pow10[-kappa]; }
+			grisuRound(buf, len, delta, p2, one, wpw * mult);
+			return len;
+		}
+	}
+	return len;
+};
+
+// digits of data (finite and > 0) are written to buf (at least 18 bytes),
+// such that data = digits * 10^k, returns number of digits
+let grisu2 = fn(data: f64, buf: *i8, k: &i32): u64 {
+	initTables();
+	let bits = *@as(@ptr(u64), &data);
+	let biased = (bits >> 52) & 2047;
+	let v = DiyFp{bits & SIGNIFICAND_MASK, -1074};
+	if biased != 0 {
+		v.f += HIDDEN_BIT;
+		v.e = @as(i32, biased) - 1075;
+	}
+
+	// boundaries of the interval of numbers which round to data, with the same exponent
+	let wp = DiyFp{(v.f << 1) + 1, v.e - 1};
+	while (wp.f & (HIDDEN_BIT << 1)) == 0 {
+		wp.f <<= 1;
+		--wp.e;
+	}
+	wp.f <<= 10;
+	wp.e -= 10;
+	let wm = DiyFp{(v.f << 1) - 1, v.e - 1};
+	if v.f == HIDDEN_BIT {
+		wm.f = (v.f << 2) - 1;
+		wm.e = v.e - 2;
+	}
+	wm.f <<= @as(u64, wm.e - wp.e);
+	wm.e = wp.e;
+
+	// cached power c = 10^-k such that the exponent of wp * c is in [-60, -32]
+	let dk = @as(f64, -61 - wp.e) * 0.30102999566398114 + 347.0;
+	let ik = @as(i32, dk);
+	if dk - @as(f64, ik) > 0.0 { ++ik; }
+	let idx = @as(u64, (ik >> 3) + 1);
+	k = 348 - @as(i32, idx << 3);
+	let cmk = DiyFp{cachedpowers_f[idx], cachedpowers_e[idx]};
+
+	while (v.f & (@as(u64, 1) << 63)) == 0 {
+		v.f <<= 1;
+		--v.e;
+	}
+	let w = mulDiy(v, cmk);
+	let up = mulDiy(wp, cmk);
+	let lo = mulDiy(wm, cmk);
+	++lo.f;
+	--up.f;
+	return digitGen(w, up, up.f - lo.f, buf, k);
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Floats
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+// writes nan, inf, -inf - returns 0 if data is finite
+let writeFltSpecial = fn(buf: *i8, data: f64): u64 {
+	let n: u64 = 0;
+	if data != data {
+		buf[0] = 'n';
+		buf[1] = 'a';
+		buf[2] = 'n';
+		return 3;
+	}
+	if data - data == 0.0 { return 0; }
+	if data < 0.0 { buf[n++] = '-'; }
+	buf[n++] = 'i';
+	buf[n++] = 'n';
+	buf[n++] = 'f';
+	return n;
+};
+
+let writeExponent = fn(buf: *i8, e: i32): u64 {
+	buf[0] = 'e';
+	if e < 0 {
+		buf[1] = '-';
+		return writeUInt(&buf[2], -e) + 2;
+	}
+	return writeUInt(&buf[1], e) + 1;
+};
+
+// shortest representation that reads back as data: 1.5, 0.001, 1e+30 -> 1e30, 1.25e-7
+let writeFltShortest = fn(buf: *i8, data: f64): u64 {
+	let n = writeFltSpecial(buf, data);
+	if n > 0 { return n; }
+	if data < 0.0 || (data == 0.0 && 1.0 / data < 0.0) {
+		buf[n++] = '-';
+		data = -data;
+	}
+	if data == 0.0 {
+		buf[n++] = '0';
+		buf[n++] = '.';
+		buf[n++] = '0';
+		return n;
+	}
+	let digits = @array(i8, 24);
+	let k: i32 = 0;
+	let len = @as(i32, grisu2(data, digits, k));
+	let kk = len + k; // 10^(kk - 1) <= data < 10^kk
+	if k >= 0 && kk <= 21 { // 1234e7 -> 12340000000.0
+		mem.cpy(&buf[n], digits, len);
+		n += len;
+		for let i = 0; i < k; ++i { buf[n++] = '0'; }
+		buf[n++] = '.';
+		buf[n++] = '0';
+	} elif kk > 0 && kk <= 21 { // 1234e-2 -> 12.34
+		mem.cpy(&buf[n], digits, kk);
+		n += kk;
+		buf[n++] = '.';
+		mem.cpy(&buf[n], &digits[kk], len - kk);
+		n += len - kk;
+	} elif kk > -6 && kk <= 0 { // 1234e-6 -> 0.001234
+		buf[n++] = '0';
+		buf[n++] = '.';
+		for let i = kk; i < 0; ++i { buf[n++] = '0'; }
+		mem.cpy(&buf[n], digits, len);
+		n += len;
+	} else { // 1234e30 -> 1.234e33
+		buf[n++] = digits[0];
+		if len > 1 {
+			buf[n++] = '.';
+			mem.cpy(&buf[n], &digits[1], len - 1);
+			n += len - 1;
+		}
+		n += writeExponent(&buf[n], kk - 1);
+	}
+	return n;
+};
+
+// same as printf("%.*f", precision, data), except that 0 is returned (and nothing is written)
+// if data is not finite, precision > 17, or the digits are not certain - for which the caller
+// must use printf instead
+// The digits come from grisu2(), which are (at most) half an ulp away from the exact value that
+// printf uses, so they are only certain when ulp < 10^-precision and they do not lie close to
+// a rounding boundary.
+let writeFltFixed = fn(buf: *i8, data: f64, precision: i32): u64 {
+	if precision < 0 || precision > 17 || data != data { return 0; }
+	initTables();
+	let n: u64 = 0;
+	let bits = *@as(@ptr(u64), &data);
+	let neg = (bits >> 63) != 0;
+	if neg { data = -data; }
+	let biased = (bits >> 52) & 2047;
+	let ulpbits: u64 = 0;
+	if biased > 52 { ulpbits = (biased - 52) << 52; }
+	let ulp = *@as(@ptr(f64), &ulpbits);
+	let scale = @as(f64, pow10[precision]);
+	if ulp * scale >= 1.0 { return 0; } // also true for inf
+	let digits = @array(i8, 24);
+	let k: i32 = 0;
+	let len: i32 = 1;
+	if data == 0.0 {
+		digits[0] = '0';
+	} else {
+		len = @as(i32, grisu2(data, digits, k));
+	}
+	let kk = len + k;
+	let intlen: i32 = 1;
+	if kk > 1 { intlen = kk; }
+	let total = intlen + precision;
+	let res = @array(i8, 40);
+	for let j: i32 = 0; j < total; ++j {
+		let idx = j + kk - intlen;
+		if idx >= 0 && idx < len {
+			res[j] = digits[idx];
+		} else {
+			res[j] = '0';
+		}
+	}
+	// round to nearest, based on the digits after the last one printed
+	let roundup = false;
+	let idx = total + kk - intlen;
+	if idx >= 0 && idx < len {
+		let rest: u64 = 0;
+		for let j = idx; j < len; ++j {
+			rest = rest * 10 + @as(u64, digits[j] - '0');
+		}
+		let half = 5 * pow10[len - idx - 1];
+		let diff = half - rest;
+		if rest > half {
+			roundup = true;
+			diff = rest - half;
+		}
+		// the exact value could be on the other side of the boundary
+		if @as(f64, diff) / (scale * @as(f64, pow10[len - idx])) <= ulp { return 0; }
+	}
+	let carry = false;
+	if roundup {
+		let j = total - 1;
+		carry = true;
+		while j >= 0 && carry {
+			if res[j] == '9' {
+				res[j] = '0';
+			} else {
+				++res[j];
+				carry = false;
+			}
+			--j;
+		}
+	}
+	if neg { buf[n++] = '-'; }
+	if carry { buf[n++] = '1'; }
+	mem.cpy(&buf[n], res, intlen);
+	n += intlen;
+	if precision > 0 {
+		buf[n++] = '.';
+		mem.cpy(&buf[n], &res[intlen], precision);
+		n += precision;
+	}
+	return n;
+};
+
+// precision < 0 => shortest representation, else fixed number of digits after the decimal point
+// returns 0 if data must be formatted using printf instead (see writeFltFixed())
+let writeFlt = inline fn(buf: *i8, data: f64, precision: i32): u64 {
+	if precision < 0 { return writeFltShortest(buf, data); }
+	return writeFltFixed(buf, data, precision);
+};
+
+inline if @isMainSrc() {
+
+let io = @import("std/io");
+
+// double with the given bits - there are no exponent literals, and float literals are f32
+let fromBits = fn(bits: u64): f64 {
+	let res: f64 = 0.0;
+	mem.cpy(&res, &bits, 8);
+	return res;
+};
+
+// buf[0, len) == expected
+let matches = fn(buf: *const i8, len: u64, expected: StringRef): i1 {
+	return len == expected.len() && mem.cmp(buf, expected.data, len) == 0;
+};
+
+let main = fn(): i32 {
+	let buf = @array(i8, 41); // FLT_MAX_LEN + 1
+
+	let zero: u64 = 0;
+	let umax: u64 = ~zero;
+	let imin: i64 = -9223372036854775807 - 1;
+	let ineg: i64 = -1205;
+	let ok = matches(buf, writeUInt(buf, zero), "0") && matches(buf, writeInt(buf, 0), "0");
+	ok = ok && matches(buf, writeUInt(buf, umax), "18446744073709551615");
+	ok = ok && matches(buf, writeInt(buf, imin), "-9223372036854775808");
+	ok = ok && matches(buf, writeInt(buf, ineg), "-1205");
+	ok = ok && uintLen(umax) == INT_MAX_LEN && intLen(imin) == INT_MAX_LEN;
+	io.println("writeInt()/writeUInt() (ok: ", ok, ")");
+
+	// shortest digits
+	let f1 = fromBits(0x3fb999999999999a);
+	let f2: f64 = 100.0;
+	let f3: f64 = -0.0;
+	let f4 = fromBits(0x46293e5939a08cea);
+	let f5 = fromBits(0x3e80c6f7a0b5ed8d);
+	let f6 = fromBits(0x3f5437c5692b3cc5);
+	let f7 = fromBits(0x7fefffffffffffff); // largest
+	let f8 = fromBits(1); // smallest denormal
+	let f9 = fromBits(0x40fe240c9fbe76c9);
+	ok = matches(buf, writeFlt(buf, f1, -1), "0.1") && matches(buf, writeFlt(buf, f2, -1), "100.0");
+	ok = ok && matches(buf, writeFlt(buf, f3, -1), "-0.0");
+	ok = ok && matches(buf, writeFlt(buf, f4, -1), "1e30");
+	ok = ok && matches(buf, writeFlt(buf, f5, -1), "1.25e-7");
+	ok = ok && matches(buf, writeFlt(buf, f6, -1), "0.001234");
+	ok = ok && matches(buf, writeFlt(buf, f7, -1), "1.7976931348623157e308");
+	ok = ok && matches(buf, writeFlt(buf, f8, -1), "5e-324");
+	ok = ok && matches(buf, writeFlt(buf, f9, -1), "123456.789");
+	io.println("writeFlt() shortest (ok: ", ok, ")");
+
+	// fixed digits - 0 means the caller has to use printf
+	let g1 = fromBits(0x400921f9f01b866e);
+	let g2 = fromBits(0xc0934a456d5cfaad);
+	let g3 = fromBits(0x408f3fff2e48e8a7);
+	let g4: f64 = 2.5; // tie
+	let g5 = fromBits(0x3ff0147ae147ae14); // 1.005, really 1.00499999999999989...
+	let g6 = fromBits(0x7e37e43c8800759c); // 1e300
+	ok = matches(buf, writeFlt(buf, g1, 2), "3.14") && matches(buf, writeFlt(buf, g2, 3), "-1234.568");
+	ok = ok && matches(buf, writeFlt(buf, g3, 3), "1000.000");
+	ok = ok && matches(buf, writeFlt(buf, zero, 3), "0.000");
+	ok = ok && writeFlt(buf, g4, 0) == 0 && writeFlt(buf, g5, 2) == 0 && writeFlt(buf, g6, 2) == 0;
+	io.println("writeFlt() fixed (ok: ", ok, ")");
+	return 0;
+};
+
+}
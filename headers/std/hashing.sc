@@ -1,22 +1,118 @@
-let cStr = fn(key: *const i8, count: u64): u64 {
-	let h: u64 = 2166136261;
-	while count >= 8 {
-		h = (h ^ ((((*@as(@ptr(u32), key)) << 5) | ((*@as(@ptr(u32), key)) >> 27)) ^ *@as(@ptr(u32), @as(u64, key) + 4))) * 709607;
-		count -= 8;
-		key = @as(@ptr(i8), @as(u64, key) + 8);
-	}
-	if count & 4 {
-		h = (h ^ *@as(@ptr(u16), key)) * 709607;
-		key = @as(@ptr(i8), @as(u64, key) + 2);
-		h = (h ^ *@as(@ptr(u16), key)) * 709607;
-		key = @as(@ptr(i8), @as(u64, key) + 2);
-	}
-	if count & 2 {
-		h = (h ^ *@as(@ptr(u16), key)) * 709607;
-		key = @as(@ptr(i8), @as(u64, key) + 2);
-	}
-	if count & 1 {
-		h = (h ^ *key) * 709607;
+// Non cryptographic hash functions
+// Byte spans are hashed using wyhash (final version 4): https://github.com/wangyi-fudan/wyhash
+//
+// All hashes depend on a seed (default: 0) which can be changed using setSeed() - say, with a
+// random value at startup - so that the hash values (and collisions) cannot be predicted.
+// The seed must not change while any hash value computed with the previous seed is still in use.
+
+// not std/mem - that needs the rest of the prelude, which imports this file
+let c = @import("std/c");
+
+let comptime WYP0: u64 = 0xa0761d6478bd642f;
+let comptime WYP1: u64 = 0xe7037ed1a0b428db;
+let comptime WYP2: u64 = 0x8ebc6af09c88c6e3;
+let comptime WYP3: u64 = 0x589965cc75374cc3;
+
+let static SEED: u64 = 0;
+
+let setSeed = fn(seed: u64) {
+	SEED = seed;
+};
+
+let getSeed = fn(): u64 {
+	return SEED;
+};
+
+// 64x64 -> 128 bit multiplication in the C prelude (unsigned __int128), the native backend lowers
+// it to a single mul - emulating it with 32 bit halves made bytes() slower than the hash it replaced
+let mum128 = extern[_sc_mum] fn(a: *u64, b: *u64);
+
+// a becomes the low half and b the high half of the product
+let mum = inline fn(a: &u64, b: &u64) {
+	mum128(&a, &b);
+};
+
+// xor of both halves of the 128 bit product of a and b
+let mix = inline fn(a: u64, b: u64): u64 {
+	mum(a, b);
+	return a ^ b;
+};
+
+// unaligned loads go through memcpy() - compilers turn that into a plain load
+let read8 = inline fn(key: *const i8, off: u64): u64 {
+	let v: u64 = 0;
+	c.memcpy(@as(@ptr(i8), &v), @as(@ptr(i8), @as(u64, key) + off), 8);
+	return v;
+};
+
+let read4 = inline fn(key: *const i8, off: u64): u64 {
+	let v: u32 = 0;
+	c.memcpy(@as(@ptr(i8), &v), @as(@ptr(i8), @as(u64, key) + off), 4);
+	return v;
+};
+
+// 1 to 3 bytes
+let read3 = inline fn(key: *const i8, count: u64): u64 {
+	let p = @as(@ptr(u8), key);
+	return (@as(u64, p[0]) << 16) | (@as(u64, p[count >> 1]) << 8) | @as(u64, p[count - 1]);
+};
+
+let bytesSeeded = fn(key: *const i8, count: u64, seed: u64): u64 {
+	let a: u64 = 0;
+	let b: u64 = 0;
+	seed ^= mix(seed ^ WYP0, WYP1);
+	if count <= 16 {
+		if count >= 4 {
+			let off = (count >> 3) << 2;
+			a = (read4(key, 0) << 32) | read4(key, off);
+			b = (read4(key, count - 4) << 32) | read4(key, count - 4 - off);
+		} elif count > 0 {
+			a = read3(key, count);
+		}
+	} else {
+		let i = count;
+		let p: u64 = 0;
+		if i > 48 {
+			let see1 = seed;
+			let see2 = seed;
+			while i > 48 {
+				seed = mix(read8(key, p) ^ WYP1, read8(key, p + 8) ^ seed);
+				see1 = mix(read8(key, p + 16) ^ WYP2, read8(key, p + 24) ^ see1);
+				see2 = mix(read8(key, p + 32) ^ WYP3, read8(key, p + 40) ^ see2);
+				p += 48;
+				i -= 48;
+			}
+			seed ^= see1 ^ see2;
+		}
+		while i > 16 {
+			seed = mix(read8(key, p) ^ WYP1, read8(key, p + 8) ^ seed);
+			p += 16;
+			i -= 16;
+		}
+		a = read8(key, p + i - 16);
+		b = read8(key, p + i - 8);
 	}
-	return h ^ (h >> 16);
+	a ^= WYP1;
+	b ^= seed;
+	mum(a, b);
+	return mix(a ^ WYP0 ^ count, b ^ WYP1);
+};
+
+// hash of count bytes starting at key
+let bytes = fn(key: *const i8, count: u64): u64 {
+	return bytesSeeded(key, count, SEED);
+};
+
+// kept for compatibility, same as bytes()
+let cStr = fn(key: *const i8, count: u64): u64 {
+	return bytesSeeded(key, count, SEED);
+};
+
+let integerSeeded = inline fn(key: u64, seed: u64): u64 {
+	return mix(key ^ WYP0, seed ^ WYP1);
+};
+
+// mixes the bits of an integer key so that the low bits are usable as a table index
+let integer = fn(key: u64): u64 {
+	return mix(key ^ WYP0, SEED ^ WYP1);
 };
@@ -1,4 +1,5 @@
 let c = @import("std/c");
+let numfmt = @import("std/fmt");
 let string = @import("std/string");
 
 let stdin = c.stdin;
@@ -14,7 +15,26 @@ let fprint = fn(f: *c.FILE, data: ...&const any): i32 {
 		} elif @isEqualTy(data[i], StringRef) {
 			sum += c.fprintf(f, r"%.*s", data[i].len(), data[i].cStr());
 		} elif @isFlt(data[i]) {
-			sum += c.fprintf(f, c.getTypeSpecifier(@typeOf(data[i])), string.getPrecision(), data[i]);
+			let buf = @array(i8, 41); // numfmt.FLT_MAX_LEN + 1
+			let n = numfmt.writeFlt(buf, data[i], string.getPrecision());
+			if n > 0 {
+				buf[n] = 0;
+				c.fputs(buf, f);
+				sum += n;
+			} else {
+				sum += c.fprintf(f, r"%.*lf", string.getPrecision(), data[i]);
+			}
+		} elif @isInt(data[i]) && !@isEqualTy(data[i], i1) && !@isEqualTy(data[i], i8) {
+			let buf = @array(i8, 21); // numfmt.INT_MAX_LEN + 1
+			let n: u64 = 0;
+			inline if @isIntSigned(data[i]) {
+				n = numfmt.writeInt(buf, data[i]);
+			} else {
+				n = numfmt.writeUInt(buf, data[i]);
+			}
+			buf[n] = 0;
+			c.fputs(buf, f);
+			sum += n;
 		} elif @isPrimitiveOrPtr(data[i]) {
 			sum += c.fprintf(f, c.getTypeSpecifier(@typeOf(data[i])), data[i]);
 		} else {
@@ -68,11 +88,12 @@ let printf in c.FILE = inline fn(fmt: *const i8, data: ...&const any): i32 {
 };
 let read in c.FILE = fn(buf: &string.String): i64 {
 	buf.deinit();
+	let data: *i8 = nil;
 	let bufsz: u64 = 0;
-	let sz = c.getline(&buf.getBuf(), &bufsz, &self);
-	if sz > 0 {
-		buf.length = sz;
-		buf.capacity = buf.length + 1;
+	let sz = c.getline(&data, &bufsz, &self);
+	if @as(u64, data) != nil {
+		buf.adopt(data, 0, bufsz);
+		if sz > 0 { buf.length = sz; }
 	}
 	return sz;
 };
@@ -16,6 +16,7 @@ let List = struct<T> {
 	end: *Node(T);
 	length: u64;
 	managed: i1;
+	allocator: mem.Allocator; // for the nodes
 };
 
 let init in List = fn(managed: i1) {
@@ -23,6 +24,7 @@ let init in List = fn(managed: i1) {
 	self.end = nil;
 	self.length = 0;
 	self.managed = managed;
+	self.allocator = mem.heap();
 };
 
 let deinit in List = fn() {
@@ -32,18 +34,25 @@ let deinit in List = fn() {
 	inline if !@isPrimitive(self.T) {
 		if self.managed { tmp.data.deinit(); }
 	}
-		mem.free(Node(self.T), tmp);
+		self.allocator.free(Node(self.T), tmp, 1);
 	}
 	self.start = self.end = nil;
 	self.length = 0;
 };
 
 let new = inline fn(comptime T: type, managed: i1): List(T) {
-	return List(T){nil, nil, 0, managed};
+	return List(T){nil, nil, 0, managed, mem.heap()};
+};
+
+// the nodes are allocated from alloc - a pool (see mem.newPoolFor(list.Node(T), ...)) avoids
+// a malloc() and free() per push and pop
+let newIn = inline fn(comptime T: type, managed: i1, alloc: mem.Allocator): List(T) {
+	return List(T){nil, nil, 0, managed, alloc};
 };
 
 let push in List = fn(data: &const self.T): self {
-	let newnode = mem.alloc(Node(self.T), 1);
+	// zeroed, since the assignment below calls T's __assn__ (if any) on newnode.data
+	let newnode = self.allocator.calloc(Node(self.T), 1);
 	newnode.data = data;
 	newnode.prev = nil;
 	newnode.next = nil;
@@ -69,21 +78,34 @@ let pop in List = fn(): self {
 		if self.managed { self.end.data.deinit(); }
 	}
 	if @as(u64, self.start) == @as(u64, self.end) {
-		mem.free(Node(self.T), self.end);
+		self.allocator.free(Node(self.T), self.end, 1);
 		self.start = self.end = nil;
 		return self;
 	}
 	let tmp = self.end;
 	self.end = self.end.prev;
 	self.end.next = nil;
-	mem.free(Node(self.T), tmp);
+	self.allocator.free(Node(self.T), tmp, 1);
+	return self;
+};
+
+let popFront in List = fn(): self {
+	if @as(u64, self.start) == nil { return self; }
+	--self.length;
+	inline if !@isPrimitive(self.T) {
+		if self.managed { self.start.data.deinit(); }
+	}
+	let tmp = self.start;
+	self.start = self.start.next;
+	if @as(u64, self.start) == nil { self.end = nil; }
+	else { self.start.prev = nil; }
+	self.allocator.free(Node(self.T), tmp, 1);
 	return self;
 };
 
+// deinit() leaves an empty list with the same allocator
 let clear in List = inline fn() {
-	let tmp = self.managed;
 	self.deinit();
-	self.init(tmp);
 };
 
 let setManaged in List = fn(managed: i1): self {
@@ -119,6 +141,266 @@ let str in const List = fn(): string.String {
 	return res;
 };
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Deque - unrolled linked list
+// The elements are stored in blocks of DEQUE_BLOCK_SIZE bytes, so pushing and popping at either
+// end only allocates (or frees) once per block, and up to DEQUE_SPARE_BLOCKS emptied blocks are
+// kept for reuse - a queue which stays around the same size does not allocate at all.
+// Like Vec, the elements are moved in (shallow copied) by push.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+let comptime DEQUE_BLOCK_SIZE: u64 = 1024; // bytes of elements per block
+let comptime DEQUE_BLOCK_MIN: u64 = 8; // elements per block, for large types
+let comptime DEQUE_SPARE_BLOCKS: u64 = 4;
+let comptime DEQUE_HEADER_SIZE: u64 = 32; // @sizeOf(DequeBlock) rounded up to mem.MAX_ALIGN
+
+// the elements follow the header in the same allocation
+let DequeBlock = struct<T> {
+	prev: *Self;
+	next: *Self;
+	items: *T;
+};
+
+let Deque = struct<T> {
+	first: *DequeBlock(T);
+	last: *DequeBlock(T);
+	head: u64; // index of the front element in first
+	tail: u64; // index after the back element in last
+	length: u64;
+	perblock: u64;
+	spare: *DequeBlock(T); // emptied blocks, linked by next
+	spares: u64;
+	managed: i1;
+	allocator: mem.Allocator; // for the blocks
+};
+
+let newDequeIn = inline fn(comptime T: type, managed: i1, alloc: mem.Allocator): Deque(T) {
+	let comptime sz = @sizeOf(T);
+	let perblock = DEQUE_BLOCK_SIZE / sz;
+	if perblock < DEQUE_BLOCK_MIN { perblock = DEQUE_BLOCK_MIN; }
+	return Deque(T){nil, nil, 0, 0, 0, perblock, nil, 0, managed, alloc};
+};
+
+let newDeque = inline fn(comptime T: type, managed: i1): Deque(T) {
+	return newDequeIn(T, managed, mem.heap());
+};
+
+let blockBytes in const Deque = inline fn(): u64 {
+	return DEQUE_HEADER_SIZE + self.perblock * @sizeOf(self.T);
+};
+
+let getBlock in Deque = fn(): *DequeBlock(self.T) {
+	let blk = self.spare;
+	if @as(u64, blk) != nil {
+		self.spare = blk.next;
+		--self.spares;
+	} else {
+		blk = @as(@ptr(DequeBlock(self.T)), self.allocator.allocBytes(self.blockBytes()));
+		blk.items = @as(@ptr(self.T), @as(u64, blk) + DEQUE_HEADER_SIZE);
+	}
+	blk.prev = nil;
+	blk.next = nil;
+	return blk;
+};
+
+let putBlock in Deque = fn(blk: *DequeBlock(self.T)) {
+	if self.spares >= DEQUE_SPARE_BLOCKS {
+		self.allocator.freeBytes(@as(@ptr(void), blk), self.blockBytes());
+		return;
+	}
+	blk.next = self.spare;
+	self.spare = blk;
+	++self.spares;
+};
+
+// the first block starts in the middle so that both ends can grow in it
+let start in Deque = fn() {
+	self.first = self.last = self.getBlock();
+	self.head = self.tail = self.perblock / 2;
+};
+
+let deinitItems in Deque = fn() {
+	inline if !@isPrimitiveOrPtr(self.T) {
+		if !self.managed { return; }
+		let blk = self.first;
+		let i = self.head;
+		for let n: u64 = 0; n < self.length; ++n {
+			if i == self.perblock {
+				blk = blk.next;
+				i = 0;
+			}
+			blk.items[i++].deinit();
+		}
+	}
+};
+
+let deinit in Deque = fn() {
+	self.deinitItems();
+	let blk = self.first;
+	while @as(u64, blk) != nil {
+		let next = blk.next;
+		self.allocator.freeBytes(@as(@ptr(void), blk), self.blockBytes());
+		blk = next;
+	}
+	while @as(u64, self.spare) != nil {
+		let next = self.spare.next;
+		self.allocator.freeBytes(@as(@ptr(void), self.spare), self.blockBytes());
+		self.spare = next;
+	}
+	self.first = self.last = nil;
+	self.head = self.tail = self.length = self.spares = 0;
+};
+
+// removes all elements, the blocks are kept as spares (up to DEQUE_SPARE_BLOCKS)
+let clear in Deque = fn() {
+	self.deinitItems();
+	while @as(u64, self.first) != nil {
+		let next = self.first.next;
+		self.putBlock(self.first);
+		self.first = next;
+	}
+	self.last = nil;
+	self.head = self.tail = self.length = 0;
+};
+
+let push in Deque = fn(data: &const self.T): self {
+	if @as(u64, self.last) == nil {
+		self.start();
+	} elif self.tail == self.perblock {
+		let blk = self.getBlock();
+		blk.prev = self.last;
+		self.last.next = blk;
+		self.last = blk;
+		self.tail = 0;
+	}
+	mem.cpy(&self.last.items[self.tail++], &data, @sizeOf(self.T));
+	++self.length;
+	return self;
+};
+
+let pushVal in Deque = inline fn(data: self.T): self {
+	return self.push(data);
+};
+
+let pushFront in Deque = fn(data: &const self.T): self {
+	if @as(u64, self.first) == nil {
+		self.start();
+	} elif self.head == 0 {
+		let blk = self.getBlock();
+		blk.next = self.first;
+		self.first.prev = blk;
+		self.first = blk;
+		self.head = self.perblock;
+	}
+	mem.cpy(&self.first.items[--self.head], &data, @sizeOf(self.T));
+	++self.length;
+	return self;
+};
+
+let pushFrontVal in Deque = inline fn(data: self.T): self {
+	return self.pushFront(data);
+};
+
+// an emptied deque keeps its block, with both ends in the middle again
+let pop in Deque = fn(): self {
+	if self.length == 0 { return self; }
+	--self.tail;
+	inline if !@isPrimitiveOrPtr(self.T) {
+		if self.managed { self.last.items[self.tail].deinit(); }
+	}
+	if --self.length == 0 {
+		self.head = self.tail = self.perblock / 2;
+	} elif self.tail == 0 {
+		let blk = self.last;
+		self.last = blk.prev;
+		self.last.next = nil;
+		self.putBlock(blk);
+		self.tail = self.perblock;
+	}
+	return self;
+};
+
+let popFront in Deque = fn(): self {
+	if self.length == 0 { return self; }
+	inline if !@isPrimitiveOrPtr(self.T) {
+		if self.managed { self.first.items[self.head].deinit(); }
+	}
+	++self.head;
+	if --self.length == 0 {
+		self.head = self.tail = self.perblock / 2;
+	} elif self.head == self.perblock {
+		let blk = self.first;
+		self.first = blk.next;
+		self.first.prev = nil;
+		self.putBlock(blk);
+		self.head = 0;
+	}
+	return self;
+};
+
+let setManaged in Deque = fn(managed: i1): self {
+	self.managed = managed;
+	return self;
+};
+
+let front in Deque = inline fn(): &self.T { return self.first.items[self.head]; };
+let frontByVal in const Deque = inline fn(): self.T { return self.first.items[self.head]; };
+let back in Deque = inline fn(): &self.T { return self.last.items[self.tail - 1]; };
+let backByVal in const Deque = inline fn(): self.T { return self.last.items[self.tail - 1]; };
+
+// walks the blocks from the nearer end - O(idx / elements per block)
+let __subscr__ in Deque = fn(idx: u64): &self.T {
+	if idx < self.length / 2 {
+		let i = self.head + idx;
+		let blk = self.first;
+		while i >= self.perblock {
+			blk = blk.next;
+			i -= self.perblock;
+		}
+		return blk.items[i];
+	}
+	let fromback = self.length - 1 - idx; // elements after idx
+	let blk = self.last;
+	let i = self.tail - 1;
+	while fromback > i {
+		fromback -= i + 1;
+		blk = blk.prev;
+		i = self.perblock - 1;
+	}
+	return blk.items[i - fromback];
+};
+
+let doEach in Deque = fn(cb: any, args: ...&any) {
+	let blk = self.first;
+	let i = self.head;
+	for let n: u64 = 0; n < self.length; ++n {
+		if i == self.perblock {
+			blk = blk.next;
+			i = 0;
+		}
+		cb(blk.items[i++], args);
+	}
+};
+
+let len in const Deque = inline fn(): u64 { return self.length; };
+let isEmpty in const Deque = inline fn(): i1 { return self.length == 0; };
+
+let str in const Deque = fn(): string.String {
+	let res = string.from("[");
+	let blk = self.first;
+	let i = self.head;
+	for let n: u64 = 0; n < self.length; ++n {
+		if i == self.perblock {
+			blk = blk.next;
+			i = 0;
+		}
+		res += blk.items[i++];
+		if n < self.length - 1 { res.appendRef(", "); }
+	}
+	res.appendRef("]");
+	return res;
+};
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 // Usage
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -139,6 +421,17 @@ let main = fn(): i32 {
 		l.pop();
 		io.println("count: ", l.len(), "; list: ", l);
 	}
+	let d = newDeque(i32, true);
+	defer d.deinit();
+	for let i = 0; i < 10; ++i {
+		if i % 2 == 0 { d.push(i); }
+		else { d.pushFront(i); }
+		io.println("count: ", d.len(), "; deque: ", d);
+	}
+	for let i = 0; i < 5; ++i {
+		d.popFront();
+		io.println("count: ", d.len(), "; deque: ", d);
+	}
 	return 0;
 };
 
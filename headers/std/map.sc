@@ -16,7 +16,18 @@ let setInitCapacity = fn(cap: u64) {
 
 let hash = fn(of: &const any, args: ...&const any): u64 {
 	inline if @isCString(of) {
-		return hashing.cStr(of, c.strlen(of));
+		return hashing.bytes(of, c.strlen(of));
+	} elif @isFlt(of) {
+		// hash the bit pattern - converting to u64 would give 1.25 and 1.5 the same hash
+		let bits: u64 = 0;
+		let comptime sz = @sizeOf(@typeOf(of));
+		mem.cpy(&bits, &of, sz);
+		// -0.0 == 0.0, so they must hash the same
+		let comptime signbit: u64 = 1 << (sz * 8 - 1);
+		if bits == signbit { bits = 0; }
+		return hashing.integer(bits);
+	} elif @isPrimitiveOrPtr(of) {
+		return hashing.integer(@as(u64, of));
 	} else {
 		return of.hash(args);
 	}
@@ -61,14 +72,15 @@ let Dict = struct<K, V> {
 	table: **KeyNode(K, V);
 	length: u64;
 	capacity: u64;
-	growth_threshold: f64;
-	growth_factor: f64;
+	growth_threshold: u64; // max average chain length before growing
+	growth_factor: u64;
 	value: *V;
 	emptyvalue: V; // used as fallback value for when get() did not find anything
+	allocator: mem.Allocator; // for the table and the key nodes
 };
 
-let newKeyNode = fn(comptime K: type, comptime V: type, k: &const K, v: &const V): *KeyNode(K, V) {
-	let node = mem.calloc(KeyNode(K, V), 1);
+let newKeyNode = fn(comptime K: type, comptime V: type, alloc: &mem.Allocator, k: &const K, v: &const V): *KeyNode(K, V) {
+	let node = alloc.calloc(KeyNode(K, V), 1);
 	node.next = nil;
 	// no need to zero the key/val as calloc takes care of that
 	setData(K, node.key, k);
@@ -76,30 +88,36 @@ let newKeyNode = fn(comptime K: type, comptime V: type, k: &const K, v: &const V
 	return node;
 };
 
-let deleteKeyNode = fn(comptime K: type, comptime V: type, node: *KeyNode(K, V)) {
+let deleteKeyNode = fn(comptime K: type, comptime V: type, alloc: &mem.Allocator, node: *KeyNode(K, V)) {
 	if @as(u64, node.next) {
-		deleteKeyNode(K, V, node.next);
+		deleteKeyNode(K, V, alloc, node.next);
 	}
 	deleteData(K, node.key);
 	deleteData(V, node.value);
-	mem.free(KeyNode(K, V), node);
+	alloc.free(KeyNode(K, V), node, 1);
 };
 
-let new = fn(comptime K: type, comptime V: type): Dict(K, V) {
-	let table = mem.calloc(@ptr(KeyNode(K, V)), INIT_CAPACITY);
+// the table and the key nodes are allocated from alloc (C string keys/values are still copied
+// to the heap)
+let newIn = fn(comptime K: type, comptime V: type, alloc: mem.Allocator): Dict(K, V) {
+	let table = alloc.calloc(@ptr(KeyNode(K, V)), INIT_CAPACITY);
 	let emptyval: V;
 	let comptime sz = @sizeOf(V);
 	mem.set(&emptyval, 0, sz);
-	return Dict(K, V){table, 0, INIT_CAPACITY, 2.0, 10, nil, emptyval};
+	return Dict(K, V){table, 0, INIT_CAPACITY, 2, 10, nil, emptyval, alloc};
+};
+
+let new = fn(comptime K: type, comptime V: type): Dict(K, V) {
+	return newIn(K, V, mem.heap());
 };
 
 let deinit in Dict = fn() {
 	for let i = 0; i < self.capacity; ++i {
 		if @as(u64, self.table[i]) {
-			deleteKeyNode(self.K, self.V, self.table[i]);
+			deleteKeyNode(self.K, self.V, self.allocator, self.table[i]);
 		}
 	}
-	mem.free(@ptr(KeyNode(self.K, self.V)), self.table);
+	self.allocator.free(@ptr(KeyNode(self.K, self.V)), self.table, self.capacity);
 	self.table = nil;
 	self.capacity = 0;
 };
@@ -107,7 +125,7 @@ let deinit in Dict = fn() {
 let clear in Dict = fn() {
 	self.deinit();
 	self.capacity = 1024;
-	self.table = mem.calloc(@ptr(KeyNode(self.K, self.V)), self.capacity);
+	self.table = self.allocator.calloc(@ptr(KeyNode(self.K, self.V)), self.capacity);
 };
 
 let reinsertWhenResizing in Dict = fn(k2: *KeyNode(self.K, self.V)) {
@@ -126,7 +144,7 @@ let reinsertWhenResizing in Dict = fn(k2: *KeyNode(self.K, self.V)) {
 let resize in Dict = fn(newsz: u64) {
 	let ocap = self.capacity;
 	let old = self.table;
-	self.table = mem.calloc(@ptr(KeyNode(self.K, self.V)), newsz);
+	self.table = self.allocator.calloc(@ptr(KeyNode(self.K, self.V)), newsz);
 	self.capacity = newsz;
 	for let i = 0; i < ocap; ++i {
 		let k = old[i];
@@ -137,18 +155,18 @@ let resize in Dict = fn(newsz: u64) {
 			k = next;
 		}
 	}
-	mem.free(@ptr(KeyNode(self.K, self.V)), old);
+	self.allocator.free(@ptr(KeyNode(self.K, self.V)), old, ocap);
 };
 
 let add in Dict = fn(key: &const self.K, val: &const self.V): i32 {
 	let n = hash(key) % self.capacity;
 	if @as(u64, self.table[n]) == nil {
-		let f = @as(f64, self.length) / @as(f64, self.capacity);
-		if f > self.growth_threshold {
+		// integer form of length / capacity > growth_threshold
+		if self.length > self.capacity * self.growth_threshold {
 			self.resize(self.capacity * self.growth_factor);
 			return self.add(key, val);
 		}
-		self.table[n] = newKeyNode(self.K, self.V, key, val);
+		self.table[n] = newKeyNode(self.K, self.V, self.allocator, key, val);
 		self.value = &self.table[n].value;
 		++self.length;
 		return 0;
@@ -162,7 +180,7 @@ let add in Dict = fn(key: &const self.K, val: &const self.V): i32 {
 		k = k.next;
 	}
 	++self.length;
-	let k2 = newKeyNode(self.K, self.V, key, val);
+	let k2 = newKeyNode(self.K, self.V, self.allocator, key, val);
 	k2.next = self.table[n];
 	self.table[n] = k2;
 	self.value = &k2.value;
@@ -214,6 +232,236 @@ let len in const Dict = inline fn(): u64 {
 	return self.length;
 };
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Open addressing HashMap (SwissTable style)
+//
+// Each slot has a control byte which is either CTRL_EMPTY or the low 7 bits of the key's hash.
+// Lookups check 8 control bytes at once (SWAR, in a u64), so keys are compared only in the slots
+// whose control byte matches. The control bytes of the first 8 slots are mirrored after the last
+// slot, so a group can be loaded at any slot without wrapping around.
+// Capacity is a power of two and slots are probed linearly, which allows removal by shifting
+// the following entries back - there are no tombstones.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+let comptime CTRL_EMPTY: u8 = 128;
+let comptime GROUP_LSBS: u64 = 0x0101010101010101;
+
+// bytes of group which are equal to h2 (the high bit of each matching byte is set)
+// may have false positives (never false negatives), the keys must be compared anyway
+let groupMatch = inline fn(group: u64, h2: u64): u64 {
+	let x = group ^ (GROUP_LSBS * h2);
+	return (x - GROUP_LSBS) & ~x & (GROUP_LSBS << 7);
+};
+
+let groupEmpty = inline fn(group: u64): u64 {
+	return group & (GROUP_LSBS << 7);
+};
+
+// index of the lowest byte which has its high bit set (mask must not be zero)
+let groupLowest = fn(mask: u64): u64 {
+	let n: u64 = 0;
+	if (mask & 4294967295) == 0 {
+		n += 4;
+		mask >>= 32;
+	}
+	if (mask & 65535) == 0 {
+		n += 2;
+		mask >>= 16;
+	}
+	if (mask & 255) == 0 {
+		n += 1;
+	}
+	return n;
+};
+
+let FlatMap = struct<K, V> {
+	ctrl: *u8; // capacity + 8 control bytes
+	keys: *K;
+	values: *V;
+	length: u64;
+	capacity: u64; // zero or a power of two
+	value: *V;
+	emptyvalue: V; // used as fallback value for when get() did not find anything
+};
+
+let newFlat = fn(comptime K: type, comptime V: type): FlatMap(K, V) {
+	let emptyval: V;
+	let comptime sz = @sizeOf(V);
+	mem.set(&emptyval, 0, sz);
+	return FlatMap(K, V){nil, nil, nil, 0, 0, nil, emptyval};
+};
+
+let deinit in FlatMap = fn() {
+	for let i: u64 = 0; i < self.capacity; ++i {
+		if self.ctrl[i] & CTRL_EMPTY { continue; }
+		deleteData(self.K, self.keys[i]);
+		deleteData(self.V, self.values[i]);
+	}
+	mem.free(u8, self.ctrl);
+	mem.free(self.K, self.keys);
+	mem.free(self.V, self.values);
+	self.ctrl = nil;
+	self.keys = nil;
+	self.values = nil;
+	self.length = 0;
+	self.capacity = 0;
+};
+
+let clear in FlatMap = fn() {
+	self.deinit();
+};
+
+// pos is not 8 byte aligned, so load through memcpy()
+let loadGroup in const FlatMap = inline fn(pos: u64): u64 {
+	let group: u64 = 0;
+	mem.cpy(&group, @as(@ptr(u8), @as(u64, self.ctrl) + pos), 8);
+	return group;
+};
+
+let setCtrl in FlatMap = inline fn(idx: u64, ctrl: u8) {
+	self.ctrl[idx] = ctrl;
+	if idx < 8 {
+		self.ctrl[self.capacity + idx] = ctrl;
+	}
+};
+
+// slot of the key, capacity if the key does not exist
+let findSlot in FlatMap = fn(key: &const self.K, h: u64): u64 {
+	if self.capacity == 0 { return 0; }
+	let mask = self.capacity - 1;
+	let h2 = h & 127;
+	let pos = (h >> 7) & mask;
+	while true {
+		let group = self.loadGroup(pos);
+		let m = groupMatch(group, h2);
+		while m {
+			let idx = (pos + groupLowest(m)) & mask;
+			if self.ctrl[idx] == h2 && cmp(self.K, self.keys[idx], key) {
+				return idx;
+			}
+			m &= m - 1;
+		}
+		// a key is never beyond the first empty slot after its position
+		if groupEmpty(group) { break; }
+		pos = (pos + 8) & mask;
+	}
+	return self.capacity;
+};
+
+// first empty slot starting at the position of hash h
+let emptySlot in FlatMap = fn(h: u64): u64 {
+	let mask = self.capacity - 1;
+	let pos = (h >> 7) & mask;
+	let m = groupEmpty(self.loadGroup(pos));
+	while m == 0 {
+		pos = (pos + 8) & mask;
+		m = groupEmpty(self.loadGroup(pos));
+	}
+	return (pos + groupLowest(m)) & mask;
+};
+
+let resize in FlatMap = fn(newcap: u64) {
+	let octrl = self.ctrl;
+	let okeys = self.keys;
+	let ovalues = self.values;
+	let ocap = self.capacity;
+	let comptime ksz = @sizeOf(self.K);
+	let comptime vsz = @sizeOf(self.V);
+	self.ctrl = mem.alloc(u8, newcap + 8);
+	mem.set(self.ctrl, CTRL_EMPTY, newcap + 8);
+	self.keys = mem.alloc(self.K, newcap);
+	self.values = mem.alloc(self.V, newcap);
+	self.capacity = newcap;
+	for let i: u64 = 0; i < ocap; ++i {
+		if octrl[i] & CTRL_EMPTY { continue; }
+		let h = hash(okeys[i]);
+		let idx = self.emptySlot(h);
+		self.setCtrl(idx, @as(u8, h & 127));
+		mem.cpy(&self.keys[idx], &okeys[i], ksz);
+		mem.cpy(&self.values[idx], &ovalues[i], vsz);
+	}
+	mem.free(u8, octrl);
+	mem.free(self.K, okeys);
+	mem.free(self.V, ovalues);
+};
+
+let add in FlatMap = fn(key: &const self.K, val: &const self.V): i32 {
+	let h = hash(key);
+	let idx = self.findSlot(key, h);
+	if idx < self.capacity {
+		self.value = &self.values[idx];
+		return 1;
+	}
+	// max load factor is 7/8
+	if (self.length + 1) * 8 > self.capacity * 7 {
+		if self.capacity == 0 {
+			self.resize(16);
+		} else {
+			self.resize(self.capacity * 2);
+		}
+	}
+	idx = self.emptySlot(h);
+	self.setCtrl(idx, @as(u8, h & 127));
+	setData(self.K, self.keys[idx], key);
+	setData(self.V, self.values[idx], val);
+	self.value = &self.values[idx];
+	++self.length;
+	return 0;
+};
+
+let find in FlatMap = fn(key: &const self.K): i1 {
+	let idx = self.findSlot(key, hash(key));
+	if idx >= self.capacity { return false; }
+	self.value = &self.values[idx];
+	return true;
+};
+
+let get in FlatMap = fn(key: &const self.K): &self.V {
+	let idx = self.findSlot(key, hash(key));
+	if idx >= self.capacity { return self.emptyvalue; }
+	self.value = &self.values[idx];
+	return self.values[idx];
+};
+
+let remove in FlatMap = fn(key: &const self.K): i1 {
+	let idx = self.findSlot(key, hash(key));
+	if idx >= self.capacity { return false; }
+	deleteData(self.K, self.keys[idx]);
+	deleteData(self.V, self.values[idx]);
+	let comptime ksz = @sizeOf(self.K);
+	let comptime vsz = @sizeOf(self.V);
+	let mask = self.capacity - 1;
+	let j = idx;
+	// shift back the entries after the removed one, till an empty slot
+	while true {
+		j = (j + 1) & mask;
+		if self.ctrl[j] & CTRL_EMPTY { break; }
+		// an entry stays if its home slot is in (idx, j]
+		let home = (hash(self.keys[j]) >> 7) & mask;
+		if ((j - home) & mask) < ((j - idx) & mask) { continue; }
+		self.setCtrl(idx, self.ctrl[j]);
+		mem.cpy(&self.keys[idx], &self.keys[j], ksz);
+		mem.cpy(&self.values[idx], &self.values[j], vsz);
+		idx = j;
+	}
+	self.setCtrl(idx, CTRL_EMPTY);
+	--self.length;
+	return true;
+};
+
+let getKeys in const FlatMap = fn(): vec.Vec(self.K) {
+	let keys = vec.new(self.K, true);
+	for let i: u64 = 0; i < self.capacity; ++i {
+		if self.ctrl[i] & CTRL_EMPTY { continue; }
+		keys.push(self.keys[i]);
+	}
+	return keys;
+};
+
+let len in const FlatMap = inline fn(): u64 {
+	return self.length;
+};
+
 inline if @isMainSrc() {
 
 let io = @import("std/io");
@@ -222,7 +470,7 @@ let string = @import("std/string");
 let main = fn(): i32 {
 	let dict1 = new(@ptr(i8), i32);
 	defer dict1.deinit();
-	let k = "ABC";
+	let k = r"ABC";
 	let v = 10;
 	dict1.add(k, v);
 	if dict1.find(k) {
@@ -242,6 +490,33 @@ let main = fn(): i32 {
 	if !dict2.find(v2) {
 		io.println("not found ", v2);
 	}
+
+	let flat = newFlat(i64, i64);
+	defer flat.deinit();
+	for let i: i64 = 0; i < 1000; ++i {
+		flat.add(i, i * i);
+	}
+	// removing every other key shifts the entries after them back
+	let removed = 0;
+	for let i: i64 = 0; i < 1000; i += 2 {
+		if flat.remove(i) { ++removed; }
+	}
+	// (keys are passed by reference, so literals need a variable)
+	let k4: i64 = 4;
+	let k5: i64 = 5;
+	let k6: i64 = 6;
+	let v4: i64 = 40;
+	let ok = removed == 500 && flat.len() == 500 && !flat.remove(k4);
+	for let i: i64 = 0; i < 1000; ++i {
+		if i % 2 == 0 {
+			if flat.find(i) { ok = false; }
+		} elif !flat.find(i) || flat.get(i) != i * i {
+			ok = false;
+		}
+	}
+	flat.add(k4, v4);
+	io.println("flat map: ", flat.len(), " entries, 4 = ", flat.get(k4), ", 5 = ", flat.get(k5),
+		   ", 6 = ", flat.get(k6), " (ok: ", ok, ")");
 	return 0;
 };
 
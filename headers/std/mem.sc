@@ -2,11 +2,14 @@
  * These are the memory management functions from C
  */
 
+let c = @import("std/c");
+
 let _malloc = extern[malloc, "<stdlib.h>"] fn(size: u64): *void;
 let _calloc = extern[calloc, "<stdlib.h>"] fn(count: u64, sz: u64): *void;
 let _realloc = extern[realloc, "<stdlib.h>"] fn(data: *void, newsz: u64): *void;
 let _free = extern[free, "<stdlib.h>"] fn(data: *void);
 let _memcpy = extern[memcpy, "<string.h>"] fn(dest: *void, src: *const void, count: u64): *void;
+let _memmove = extern[memmove, "<string.h>"] fn(dest: *void, src: *const void, count: u64): *void;
 let _memset = extern[memset, "<string.h>"] fn(dest: *void, ch: i32, count: u64): *void;
 let _memcmp = extern[memcmp, "<string.h>"] fn(lhs: *const void, rhs: *const void, count: u64): i32;
 
@@ -28,29 +31,507 @@ let free = inline fn(comptime T: type, data: *T) {
 let cpy = inline fn(dest: any, src: const any, count: u64): any {
 	return @as(@typeOf(dest), _memcpy(@as(@ptr(void), dest), @as(@ptr(void), src), count));
 };
+// same as cpy(), but dest and src can overlap
+let move = inline fn(dest: any, src: const any, count: u64): any {
+	return @as(@typeOf(dest), _memmove(@as(@ptr(void), dest), @as(@ptr(void), src), count));
+};
 let set = inline fn(dest: any, ch: i32, count: u64): any {
 	return @as(@typeOf(dest), _memset(@as(@ptr(void), dest), ch, count));
 };
 let cmp = inline fn(lhs: const any, rhs: const any, count: u64): i32 {
 	return _memcmp(@as(@ptr(void), lhs), @as(@ptr(void), rhs), count);
 };
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Arena - bump allocator
+// Allocating is just an increment of an offset, and everything allocated from an arena is
+// released at once by reset() or deinit(). Only the most recent allocation can be freed or grown
+// in place - free() of anything else is a no-op.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+let comptime MAX_ALIGN: u64 = 16; // alignment of arena and pool allocations (same as malloc)
+let comptime ARENA_BLOCK_SIZE: u64 = 64 * 1024;
+let comptime ARENA_HEADER_SIZE: u64 = 32; // @sizeOf(ArenaBlock) rounded up to MAX_ALIGN
+
+let alignUp = inline fn(size: u64): u64 {
+	return (size + MAX_ALIGN - 1) & ~(MAX_ALIGN - 1);
+};
+
+// the usable memory of a block follows its header
+let ArenaBlock = struct {
+	prev: *Self;
+	size: u64;
+	used: u64;
+};
+
+let Arena = struct {
+	block: *ArenaBlock;
+	blocksz: u64;
+	last: u64; // offset of the most recent allocation in block
+};
+
+// blocksz is the size of the memory blocks requested from malloc (0 for ARENA_BLOCK_SIZE),
+// allocations larger than that get a block of their own
+let newArena = fn(blocksz: u64): Arena {
+	if blocksz == 0 { blocksz = ARENA_BLOCK_SIZE; }
+	return Arena{nil, blocksz, 0};
+};
+
+let deinit in Arena = fn() {
+	while @as(u64, self.block) != nil {
+		let prev = self.block.prev;
+		_free(@as(@ptr(void), self.block));
+		self.block = prev;
+	}
+	self.last = 0;
+};
+
+// releases all allocations, keeping the most recent block for reuse
+let reset in Arena = fn() {
+	if @as(u64, self.block) == nil { return; }
+	let prev = self.block.prev;
+	while @as(u64, prev) != nil {
+		let tmp = prev.prev;
+		_free(@as(@ptr(void), prev));
+		prev = tmp;
+	}
+	self.block.prev = nil;
+	self.block.used = 0;
+	self.last = 0;
+};
+
+let blockData = inline fn(block: *ArenaBlock): u64 {
+	return @as(u64, block) + ARENA_HEADER_SIZE;
+};
+
+let addBlock in Arena = fn(size: u64) {
+	let sz = self.blocksz;
+	if sz < size { sz = size; }
+	let block = @as(@ptr(ArenaBlock), _malloc(ARENA_HEADER_SIZE + sz));
+	block.prev = self.block;
+	block.size = sz;
+	block.used = 0;
+	self.block = block;
+};
+
+let alloc in Arena = fn(size: u64): *void {
+	size = alignUp(size);
+	if @as(u64, self.block) == nil || self.block.used + size > self.block.size {
+		self.addBlock(size);
+	}
+	self.last = self.block.used;
+	self.block.used += size;
+	return @as(@ptr(void), blockData(self.block) + self.last);
+};
+
+let isLast in Arena = inline fn(data: *void): i1 {
+	return @as(u64, self.block) != nil && @as(u64, data) == blockData(self.block) + self.last;
+};
+
+let realloc in Arena = fn(data: *void, oldsz: u64, newsz: u64): *void {
+	if @as(u64, data) == nil { return self.alloc(newsz); }
+	if self.isLast(data) && self.last + alignUp(newsz) <= self.block.size {
+		self.block.used = self.last + alignUp(newsz);
+		return data;
+	}
+	let res = self.alloc(newsz);
+	if oldsz > newsz { oldsz = newsz; }
+	_memcpy(res, data, oldsz);
+	return res;
+};
+
+let free in Arena = fn(data: *void, size: u64) {
+	if self.isLast(data) { self.block.used = self.last; }
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Pool - fixed size slots, for nodes of linked containers
+// Freed slots go to a free list from which they are reused, and the slots are carved out of large
+// chunks so that nodes are close to each other in memory. Allocations larger than a slot are
+// passed on to malloc().
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+let comptime POOL_CHUNK_SLOTS: u64 = 256;
+
+let PoolSlot = struct {
+	next: *Self;
+};
+
+let Pool = struct {
+	chunks: *PoolSlot; // linked through the first slot of each chunk
+	freelist: *PoolSlot;
+	slotsz: u64;
+	perchunk: u64;
+};
+
+// perchunk is the number of slots allocated at once (0 for POOL_CHUNK_SLOTS)
+let newPool = fn(slotsz: u64, perchunk: u64): Pool {
+	if slotsz < @sizeOf(PoolSlot) { slotsz = @sizeOf(PoolSlot); }
+	if perchunk == 0 { perchunk = POOL_CHUNK_SLOTS; }
+	return Pool{nil, nil, alignUp(slotsz), perchunk};
+};
+
+// creates a pool whose slots fit one T
+let newPoolFor = inline fn(comptime T: type, perchunk: u64): Pool {
+	return newPool(@sizeOf(T), perchunk);
+};
+
+let deinit in Pool = fn() {
+	while @as(u64, self.chunks) != nil {
+		let next = self.chunks.next;
+		_free(@as(@ptr(void), self.chunks));
+		self.chunks = next;
+	}
+	self.freelist = nil;
+};
+
+// puts the slots of a chunk on the free list, in order of their addresses
+let freeChunk in Pool = fn(chunk: *PoolSlot) {
+	for let i = self.perchunk; i > 0; --i {
+		let slot = @as(@ptr(PoolSlot), @as(u64, chunk) + i * self.slotsz);
+		slot.next = self.freelist;
+		self.freelist = slot;
+	}
+};
+
+// releases all slots (but not the allocations which were passed on to malloc)
+let reset in Pool = fn() {
+	self.freelist = nil;
+	let chunk = self.chunks;
+	while @as(u64, chunk) != nil {
+		self.freeChunk(chunk);
+		chunk = chunk.next;
+	}
+};
+
+let alloc in Pool = fn(size: u64): *void {
+	if size > self.slotsz { return _malloc(size); }
+	if @as(u64, self.freelist) == nil {
+		let chunk = @as(@ptr(PoolSlot), _malloc(self.slotsz * (self.perchunk + 1)));
+		chunk.next = self.chunks;
+		self.chunks = chunk;
+		self.freeChunk(chunk);
+	}
+	let slot = self.freelist;
+	self.freelist = slot.next;
+	return @as(@ptr(void), slot);
+};
+
+let free in Pool = fn(data: *void, size: u64) {
+	if @as(u64, data) == nil { return; }
+	if size > self.slotsz {
+		_free(data);
+		return;
+	}
+	let slot = @as(@ptr(PoolSlot), data);
+	slot.next = self.freelist;
+	self.freelist = slot;
+};
+
+let realloc in Pool = fn(data: *void, oldsz: u64, newsz: u64): *void {
+	if @as(u64, data) == nil { return self.alloc(newsz); }
+	if oldsz > self.slotsz && newsz > self.slotsz { return _realloc(data, newsz); }
+	if oldsz <= self.slotsz && newsz <= self.slotsz { return data; }
+	let res = self.alloc(newsz);
+	if oldsz > newsz { oldsz = newsz; }
+	_memcpy(res, data, oldsz);
+	self.free(data, oldsz);
+	return res;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Allocator - handle to the allocator used by a container
+// The zero value is the heap (malloc/free). The arena, pool or custom allocator must outlive
+// the handle.
+// Unlike the functions above, realloc() and free() take the current size of the allocation.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+let AllocKind = enum : u8 {
+	HEAP,
+	ARENA,
+	POOL,
+	CUSTOM,
+};
+
+let Allocator = struct {
+	kind: @enumTagTy(AllocKind);
+	impl: *void;
+};
+
+let __assn__ in Allocator = fn(other: &const self): &self {
+	cpy(&self, &other, @sizeOf(self));
+	return self;
+};
+
+let heap = inline fn(): Allocator {
+	return Allocator{AllocKind.HEAP, nil};
+};
+
+let allocator in Arena = fn(): Allocator {
+	return Allocator{AllocKind.ARENA, @as(@ptr(void), &self)};
+};
+
+let allocator in Pool = fn(): Allocator {
+	return Allocator{AllocKind.POOL, @as(@ptr(void), &self)};
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// CustomAlloc - allocator implemented outside this module
+// Every call goes through the function pointers, with state as the first argument. The sizes
+// given to reallocFn and freeFn are the ones that were requested for the allocation.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+let CustomAlloc = struct {
+	state: *void;
+	allocFn: fn(state: *void, size: u64): *void;
+	reallocFn: fn(state: *void, data: *void, oldsz: u64, newsz: u64): *void;
+	freeFn: fn(state: *void, data: *void, size: u64);
+};
+
+let __assn__ in CustomAlloc = fn(other: &const self): &self {
+	cpy(&self, &other, @sizeOf(self));
+	return self;
+};
+
+let newCustom = fn(state: *void, allocFn: fn(state: *void, size: u64): *void,
+		   reallocFn: fn(state: *void, data: *void, oldsz: u64, newsz: u64): *void,
+		   freeFn: fn(state: *void, data: *void, size: u64)): CustomAlloc {
+	return CustomAlloc{state, allocFn, reallocFn, freeFn};
+};
+
+// the custom allocator must not move while the returned allocator is in use
+let allocator in CustomAlloc = fn(): Allocator {
+	return Allocator{AllocKind.CUSTOM, @as(@ptr(void), &self)};
+};
+
+let allocBytes in Allocator = fn(size: u64): *void {
+	if self.kind == AllocKind.ARENA {
+		let arena = @as(@ptr(Arena), self.impl);
+		return arena.alloc(size);
+	} elif self.kind == AllocKind.POOL {
+		let pool = @as(@ptr(Pool), self.impl);
+		return pool.alloc(size);
+	} elif self.kind == AllocKind.CUSTOM {
+		let custom = @as(@ptr(CustomAlloc), self.impl);
+		let f = custom.allocFn;
+		return f(custom.state, size);
+	}
+	return _malloc(size);
+};
+
+let reallocBytes in Allocator = fn(data: *void, oldsz: u64, newsz: u64): *void {
+	if self.kind == AllocKind.ARENA {
+		let arena = @as(@ptr(Arena), self.impl);
+		return arena.realloc(data, oldsz, newsz);
+	} elif self.kind == AllocKind.POOL {
+		let pool = @as(@ptr(Pool), self.impl);
+		return pool.realloc(data, oldsz, newsz);
+	} elif self.kind == AllocKind.CUSTOM {
+		let custom = @as(@ptr(CustomAlloc), self.impl);
+		let f = custom.reallocFn;
+		return f(custom.state, data, oldsz, newsz);
+	}
+	return _realloc(data, newsz);
+};
+
+let freeBytes in Allocator = fn(data: *void, size: u64) {
+	if self.kind == AllocKind.ARENA {
+		let arena = @as(@ptr(Arena), self.impl);
+		arena.free(data, size);
+	} elif self.kind == AllocKind.POOL {
+		let pool = @as(@ptr(Pool), self.impl);
+		pool.free(data, size);
+	} elif self.kind == AllocKind.CUSTOM {
+		let custom = @as(@ptr(CustomAlloc), self.impl);
+		let f = custom.freeFn;
+		f(custom.state, data, size);
+	} else {
+		_free(data);
+	}
+};
+
+let alloc in Allocator = inline fn(comptime T: type, count: u64): *T {
+	return @as(@ptr(T), self.allocBytes(@sizeOf(T) * count));
+};
+let calloc in Allocator = inline fn(comptime T: type, count: u64): *T {
+	if self.kind == AllocKind.HEAP { return @as(@ptr(T), _calloc(count, @sizeOf(T))); }
+	return @as(@ptr(T), _memset(self.allocBytes(@sizeOf(T) * count), 0, @sizeOf(T) * count));
+};
+let realloc in Allocator = inline fn(comptime T: type, data: *T, oldcount: u64, count: u64): *T {
+	let comptime sz = @sizeOf(T);
+	return @as(@ptr(T), self.reallocBytes(@as(@ptr(void), data), sz * oldcount, sz * count));
+};
+let free in Allocator = inline fn(comptime T: type, data: *T, count: u64) {
+	self.freeBytes(@as(@ptr(void), data), @sizeOf(T) * count);
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Tracker - allocation statistics
+// Forwards everything to its parent allocator and counts what passes through it: live and peak
+// bytes, number of calls and a histogram of the requested sizes.
+// For statistics per call site, give each site its own tracker with the allocator of a common
+// tracker as the parent - which then accumulates the totals of all of them.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+let comptime TRACK_BUCKETS: u64 = 32;
+
+let Tracker = struct {
+	parent: Allocator;
+	iface: CustomAlloc;
+	name: StringRef;
+	live: u64;
+	peak: u64;
+	total: u64;
+	allocs: u64;
+	reallocs: u64;
+	frees: u64;
+	// sizes[0] counts empty requests, sizes[i] the ones in [2^(i-1), 2^i),
+	// the last bucket also counts everything larger
+	sizes: @array(u64, TRACK_BUCKETS);
+};
+
+let sizeBucket = fn(size: u64): u64 {
+	let b: u64 = 0;
+	while size > 0 && b < TRACK_BUCKETS - 1 {
+		size >>= 1;
+		++b;
+	}
+	return b;
+};
+
+let record in Tracker = fn(oldsz: u64, newsz: u64) {
+	self.live = self.live - oldsz + newsz;
+	if self.live > self.peak { self.peak = self.live; }
+	if newsz > oldsz { self.total += newsz - oldsz; }
+	++self.sizes[sizeBucket(newsz)];
+};
+
+let trackerAlloc = fn(state: *void, size: u64): *void {
+	let t = @as(@ptr(Tracker), state);
+	++t.allocs;
+	t.record(0, size);
+	return t.parent.allocBytes(size);
+};
+
+let trackerRealloc = fn(state: *void, data: *void, oldsz: u64, newsz: u64): *void {
+	let t = @as(@ptr(Tracker), state);
+	// containers grow from nothing with a realloc
+	if oldsz == 0 { ++t.allocs; }
+	else { ++t.reallocs; }
+	t.record(oldsz, newsz);
+	return t.parent.reallocBytes(data, oldsz, newsz);
+};
+
+let trackerFree = fn(state: *void, data: *void, size: u64) {
+	let t = @as(@ptr(Tracker), state);
+	++t.frees;
+	t.live -= size;
+	t.parent.freeBytes(data, size);
+};
+
+let newTracker = fn(parent: Allocator, name: StringRef): Tracker {
+	let t: Tracker;
+	set(&t, 0, @sizeOf(Tracker));
+	t.parent = parent;
+	t.iface = newCustom(nil, trackerAlloc, trackerRealloc, trackerFree);
+	t.name = name;
+	return t;
+};
+
+// the tracker must not move while the returned allocator is in use
+let allocator in Tracker = fn(): Allocator {
+	self.iface.state = @as(@ptr(void), &self);
+	return self.iface.allocator();
+};
+
+// clears the counters, except the live bytes which are still allocated
+let reset in Tracker = fn() {
+	self.peak = self.live;
+	self.total = 0;
+	self.allocs = 0;
+	self.reallocs = 0;
+	self.frees = 0;
+	set(&self.sizes[0], 0, @sizeOf(u64) * TRACK_BUCKETS);
+};
+
+// writes the counters and the (non empty) histogram buckets to stderr
+let report in const Tracker = fn() {
+	c.fprintf(c.stderr, r"%.*s: live: %lu, peak: %lu, total: %lu bytes; allocs: %lu, reallocs: %lu, frees: %lu\n",
+		  @as(i32, self.name.length), self.name.data, self.live, self.peak, self.total,
+		  self.allocs, self.reallocs, self.frees);
+	for let i: u64 = 0; i < TRACK_BUCKETS; ++i {
+		if self.sizes[i] == 0 { continue; }
+		let lo: u64 = 0;
+		let hi: u64 = 0;
+		if i > 0 {
+			lo = @as(u64, 1) << (i - 1);
+			hi = (lo << 1) - 1;
+		}
+		if i == TRACK_BUCKETS - 1 {
+			c.fprintf(c.stderr, r"  %10lu +          : %lu\n", lo, self.sizes[i]);
+		} else {
+			c.fprintf(c.stderr, r"  %10lu - %10lu: %lu\n", lo, hi, self.sizes[i]);
+		}
+	}
+};
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 // Tests
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
 inline if @isMainSrc() {
 
+let io = @import("std/io");
+
 let main = fn(): i32 {
-	let v = malloc(i32, 20);
+	let v = alloc(i32, 20);
 	defer free(i32, v);
 	for let i = 0; i < 20; ++i {
 		v[i] = i;
 	}
-	let v2 = malloc(i64, 20);
+	let v2 = alloc(i64, 20);
 	defer free(i64, v2);
 	for let i = 0; i < 20; ++i {
 		v2[i] = i;
 	}
+
+	let arena = newArena(256);
+	defer arena.deinit();
+	let a = arena.alloc(10);
+	let b = arena.alloc(10);
+	let ok = (@as(u64, b) - @as(u64, a)) == MAX_ALIGN;
+	// only the most recent allocation grows in place, or is freed
+	ok = ok && @as(u64, arena.realloc(b, 10, 100)) == @as(u64, b);
+	ok = ok && @as(u64, arena.realloc(a, 10, 20)) != @as(u64, a);
+	arena.free(b, 100);
+	// larger than a block - gets a block of its own
+	let big = arena.alloc(1000);
+	ok = ok && (@as(u64, big) % MAX_ALIGN) == 0;
+	// reset() keeps the most recent block
+	arena.reset();
+	ok = ok && @as(u64, arena.alloc(10)) == @as(u64, big);
+	io.println("arena (ok: ", ok, ")");
+
+	let pool = newPool(24, 4);
+	defer pool.deinit();
+	let s1 = pool.alloc(24);
+	let s2 = pool.alloc(24);
+	// slots are rounded up to MAX_ALIGN and handed out in order of their addresses
+	ok = (@as(u64, s2) - @as(u64, s1)) == 32;
+	// freed slots are reused first
+	pool.free(s1, 24);
+	ok = ok && @as(u64, pool.alloc(24)) == @as(u64, s1);
+	// more slots than a chunk has
+	for let i = 0; i < 10; ++i {
+		pool.alloc(24);
+	}
+	// larger than a slot - moved to malloc
+	let r = pool.realloc(s2, 24, 100);
+	ok = ok && @as(u64, r) != @as(u64, s2);
+	pool.free(r, 100);
+	pool.reset();
+	ok = ok && @as(u64, pool.alloc(24)) != nil;
+	io.println("pool (ok: ", ok, ")");
 	return 0;
 };
 
@@ -6,13 +6,15 @@
 let c = @import("std/c");
 let mem = @import("std/mem");
 let vec = @import("std/vec"); // required for vec.str() and str.delim()
-let utils = @import("std/utils");
+let fmt = @import("std/fmt");
 let hashing = @import("std/hashing");
 
 let comptime NPOS: const u64 = STRING_NPOS;
 
 let float_precision = 3;
 
+// digits after the decimal point when formatting floats
+// negative => shortest representation that reads back as the same value
 let setPrecision = inline fn(digits: const i32) {
 	float_precision = digits;
 };
@@ -23,70 +25,121 @@ let getPrecision = inline fn(): i32 {
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 // String Type
+//
+// Short strings (up to INLINE_CAP - 1 chars) need no allocation - they are stored in the bytes of
+// the data and capacity fields themselves. A heap string always has HEAP_FLAG set in capacity,
+// whose top byte is the last byte of the inline buffer and is therefore always 0 for an inline
+// string (the buffer is null terminated). The buffer is computed by buf() whenever required, so
+// that a String can still be moved around by copying its bytes.
+// A StringRef/cStr() of an inline string points into the String, so it is only valid as long as
+// that String is not moved or destroyed.
+// Heap buffers grow geometrically, so repeated appends are amortized O(1).
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
+let comptime INLINE_CAP: const u64 = 16; // including null terminator
+let comptime HEAP_FLAG: const u64 = 0x8000000000000000;
+
 let String = struct {
-	data: *i8;
+	data: *i8; // heap buffer / first half of the inline buffer
+	capacity: u64; // heap capacity (with null terminator) | HEAP_FLAG / second half of the inline buffer
 	length: u64;
-	capacity: u64;
 };
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 // Creation/Deletion Functions
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
+let isInline in const String = inline fn(): i1 {
+	return (self.capacity & HEAP_FLAG) == 0;
+};
+
+// the (inline or heap) buffer of the string
+let buf in const String = inline fn(): *i8 {
+	if (self.capacity & HEAP_FLAG) == 0 { return @as(@ptr(i8), @as(u64, &self)); }
+	return self.data;
+};
+
 let deinit in String = fn() {
-	if @as(u64, self.data) == nil { return; }
-	mem.free(i8, self.data);
-	self.length = 0;
-	self.capacity = 0;
+	if self.capacity & HEAP_FLAG { mem.free(i8, self.data); }
 	self.data = nil;
+	self.capacity = 0;
+	self.length = 0;
 };
 
 let new = inline fn(): String {
 	return String{nil, 0, 0};
 };
 
-let reserve in String = fn(sz: u64): self {
-	if self.capacity >= sz { return self; }
-	if self.capacity == 0 {
-		self.data = mem.alloc(i8, sz + 1);
+// takes ownership of the heap buffer data (cap bytes, null terminated at len)
+let adopt in String = fn(data: *i8, len: u64, cap: u64) {
+	self.deinit();
+	self.data = data;
+	self.capacity = cap | HEAP_FLAG;
+	self.length = len;
+};
+
+// moves the string to a heap buffer of (at least) cap bytes
+let growTo in String = fn(cap: u64) {
+	if (self.capacity & HEAP_FLAG) == 0 {
+		let d = mem.alloc(i8, cap);
+		mem.cpy(d, self.buf(), self.length + 1);
+		self.data = d;
 	} else {
-		self.data = mem.realloc(i8, self.data, sz + 1);
+		self.data = mem.realloc(i8, self.data, cap);
 	}
-	self.capacity = sz + 1; // for null terminator
-	mem.set(self.data, 0, self.capacity);
-	return self;
+	self.capacity = cap | HEAP_FLAG;
 };
 
-let withCap = fn(capacity: u64): String {
-	let res = String{nil, 0, 0};
-	return res.reserve(capacity);
+// ensures space for count more chars (and the null terminator)
+let growFor in String = fn(count: u64) {
+	let need = self.length + count + 1;
+	if (self.capacity & HEAP_FLAG) == 0 {
+		if need <= INLINE_CAP { return; }
+		if need < INLINE_CAP * 2 { need = INLINE_CAP * 2; }
+		self.growTo(need);
+		return;
+	}
+	let cap = self.capacity & ~HEAP_FLAG;
+	if need <= cap { return; }
+	if need < cap * 2 { need = cap * 2; }
+	self.growTo(need);
 };
 
-let fromCStr = fn(data: *const i8): String {
-	let count = c.strlen(data) + 1; // + 1 for null terminator
+// ensures capacity for sz chars, the unused part of the buffer is zeroed
+let reserve in String = fn(sz: u64): self {
+	if (self.capacity & HEAP_FLAG) == 0 {
+		if sz < INLINE_CAP {
+			mem.set(&self.buf()[self.length], 0, INLINE_CAP - self.length);
+			return self;
+		}
+	} elif (self.capacity & ~HEAP_FLAG) > sz {
+		return self;
+	}
+	self.growTo(sz + 1); // for null terminator
+	mem.set(&self.data[self.length], 0, (self.capacity & ~HEAP_FLAG) - self.length);
+	return self;
+};
+
+let withCap = fn(capacity: u64): String {
 	let res = new();
-	res.data = mem.alloc(i8, count);
-	mem.cpy(res.data, data, count);
-	res.data[count - 1] = 0;
-	res.length = count - 1;
-	res.capacity = count;
-	return res;
+	return res.reserve(capacity);
 };
 
 // when using this, ensure that count < strlen(data)
 let fromSubCStr = fn(data: *const i8, count: u64): String {
-	count = count + 1; // + 1 for null terminator
 	let res = new();
-	res.data = mem.alloc(i8, count);
-	mem.cpy(res.data, data, count);
-	res.data[count - 1] = 0; // set null terminator at the end
-	res.length = count - 1;
-	res.capacity = count;
+	res.growFor(count);
+	let b = res.buf();
+	mem.cpy(b, data, count);
+	b[count] = 0; // set null terminator at the end
+	res.length = count;
 	return res;
 };
 
+let fromCStr = inline fn(data: *const i8): String {
+	return fromSubCStr(data, c.strlen(data));
+};
+
 let fromStringRef = inline fn(data: StringRef): String {
 	return fromSubCStr(data.data, data.length);
 };
@@ -105,17 +158,16 @@ let str in const StringRef = fn(): String {
 // Core Utility Functions
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
-let getBuf in String = inline fn(): *&i8 {
-	return self.data;
+let getBuf in String = inline fn(): *i8 {
+	return self.buf();
 };
 
 let setLen in String = inline fn(len: u64) {
 	self.length = len;
 };
 
-let cStr in const String = fn(): *const i8 {
-	if @as(u64, self.data) == nil { return r""; }
-	return self.data;
+let cStr in const String = inline fn(): *const i8 {
+	return self.buf();
 };
 
 let len in const String = inline fn(): u64 {
@@ -123,7 +175,8 @@ let len in const String = inline fn(): u64 {
 };
 
 let cap in const String = inline fn(): u64 {
-	return self.capacity;
+	if (self.capacity & HEAP_FLAG) == 0 { return INLINE_CAP; }
+	return self.capacity & ~HEAP_FLAG;
 };
 
 let isEmpty in const String = inline fn(): i1 {
@@ -132,21 +185,22 @@ let isEmpty in const String = inline fn(): i1 {
 
 let clear in String = fn() {
 	if self.length == 0 { return; }
-	mem.set(self.data, 0, self.length);
+	mem.set(self.buf(), 0, self.length);
 	self.length = 0;
 };
 
 let copy in const String = inline fn(): String {
-	return fromCStr(self.data);
+	return fromSubCStr(self.buf(), self.length);
 };
 
 let hash in const String = inline fn(): u64 {
-	return hashing.cStr(self.data, self.length);
+	return hashing.bytes(self.buf(), self.length);
 };
 
 let subString in const String = fn(start: u64, count: u64): String {
 	if start >= self.length { return new(); }
-	return fromSubCStr(&self.data[start], count);
+	if count > self.length - start { count = self.length - start; }
+	return fromSubCStr(&self.buf()[start], count);
 };
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -154,7 +208,7 @@ let subString in const String = fn(start: u64, count: u64): String {
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
 let ref in const String = inline fn(): StringRef {
-	return StringRef{self.data, self.length};
+	return StringRef{self.buf(), self.length};
 };
 
 let subRef in const String = inline fn(start: u64, count: u64): StringRef {
@@ -170,15 +224,10 @@ let isSpace in const i8 = inline fn(): i1 {
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
 let appendChar in String = fn(ch: i8): &String {
-	if self.capacity == 0 {
-		self.capacity = 2;
-		self.data = mem.alloc(i8, self.capacity);
-	} elif self.capacity < self.length + 2 {
-		self.capacity = self.capacity * 2;
-		self.data = mem.realloc(i8, self.data, self.capacity);
-	}
-	self.data[self.length++] = ch;
-	self.data[self.length] = 0;
+	self.growFor(1);
+	let b = self.buf();
+	b[self.length++] = ch;
+	b[self.length] = 0;
 	return self;
 };
 
@@ -186,16 +235,11 @@ let appendCStr in String = fn(other: *const i8, count: u64): &String {
 	if @as(u64, other) == nil { return self; }
 	if !count || count == NPOS { count = c.strlen(other); }
 	if !count { return self; }
-	if self.capacity == 0 {
-		self.capacity = count + 1;
-		self.data = mem.alloc(i8, self.capacity);
-	} elif self.capacity < self.length + count + 1 {
-		self.capacity = self.length + count + 1;
-		self.data = mem.realloc(i8, self.data, self.capacity);
-	}
-	mem.cpy(&self.data[self.length], other, count);
+	self.growFor(count);
+	let b = self.buf();
+	mem.cpy(&b[self.length], other, count);
 	self.length += count;
-	self.data[self.length] = 0;
+	b[self.length] = 0;
 	return self;
 };
 
@@ -204,47 +248,32 @@ let appendRef in String = inline fn(other: StringRef): &String {
 };
 
 let appendInt in String = fn(data: i64): &String {
-	let otherlen = utils.countIntDigits(data);
-	if self.capacity == 0 {
-		self.capacity = otherlen + 1;
-		self.data = mem.alloc(i8, self.capacity);
-	} elif self.capacity < self.length + otherlen + 1 {
-		self.capacity = self.length + otherlen + 1;
-		self.data = mem.realloc(i8, self.data, self.capacity);
-	}
-	c.snprintf(&self.data[self.length], otherlen + 1, r"%lld", data);
-	self.length += otherlen;
-	self.data[self.length] = 0;
+	self.growFor(fmt.intLen(data));
+	let b = self.buf();
+	self.length += fmt.writeInt(&b[self.length], data);
+	b[self.length] = 0;
 	return self;
 };
 
 let appendUInt in String = fn(data: u64): &String {
-	let otherlen = utils.countUIntDigits(data);
-	if self.capacity == 0 {
-		self.capacity = otherlen + 1;
-		self.data = mem.alloc(i8, self.capacity);
-	} elif self.capacity < self.length + otherlen + 1 {
-		self.capacity = self.length + otherlen + 1;
-		self.data = mem.realloc(i8, self.data, self.capacity);
-	}
-	c.snprintf(&self.data[self.length], otherlen + 1, r"%llu", data);
-	self.length += otherlen;
-	self.data[self.length] = 0;
+	self.growFor(fmt.uintLen(data));
+	let b = self.buf();
+	self.length += fmt.writeUInt(&b[self.length], data);
+	b[self.length] = 0;
 	return self;
 };
 
+// uses the precision set by setPrecision()
 let appendFlt in String = fn(data: f64): &String {
-	let otherlen = utils.countIntDigits(data) + getPrecision() + 1;
-	if self.capacity == 0 {
-		self.capacity = otherlen + 1;
-		self.data = mem.alloc(i8, self.capacity);
-	} elif self.capacity < self.length + otherlen + 1 {
-		self.capacity = self.length + otherlen + 1;
-		self.data = mem.realloc(i8, self.data, self.capacity);
-	}
-	c.snprintf(&self.data[self.length], otherlen + 1, r"%.*lf", getPrecision(), data);
-	self.length += otherlen;
-	self.data[self.length] = 0;
+	let tmp = @array(i8, 40); // fmt.FLT_MAX_LEN
+	let n = fmt.writeFlt(tmp, data, getPrecision());
+	if n > 0 { return self.appendCStr(tmp, n); }
+	// fmt cannot give the exact digits printf would (see fmt.writeFltFixed())
+	n = c.snprintf(nil, 0, r"%.*lf", getPrecision(), data);
+	self.growFor(n);
+	let b = self.buf();
+	c.snprintf(&b[self.length], n + 1, r"%.*lf", getPrecision(), data);
+	self.length += n;
 	return self;
 };
 
@@ -266,11 +295,11 @@ let append in String = fn(data: ...&const any): &String {
 		} elif @isFlt(data[i]) {
 			self.appendFlt(data[i]);
 		} elif @isEqualTy(data[i], String) {
-			self.appendCStr(data[i].data, data[i].length);
+			self.appendCStr(data[i].cStr(), data[i].length);
 		} else { // just attempt to convert the data to string and append that
 			let s = data[i].str();
 			defer s.deinit();
-			self.appendCStr(s.data, s.length);
+			self.appendCStr(s.cStr(), s.length);
 		}
 	}
 	return self; // this exists only to avoid warning by C compiler about non-void return
@@ -288,10 +317,9 @@ let from = inline fn(data: ...&const any): String {
 
 let erase in String = fn(idx: u64): i1 {
 	if self.length <= idx { return false; }
-	for let i = idx; i < self.length; ++i {
-		// this works since length = capacity - 1, always
-		self.data[i] = self.data[i + 1];
-	}
+	let b = self.buf();
+	// moves the null terminator as well
+	mem.move(&b[idx], &b[idx + 1], self.length - idx);
 	--self.length;
 	return true;
 };
@@ -304,15 +332,16 @@ let __assn__ in String = fn(other: &const any): &String {
 
 let __add__ in const String = fn(other: &const String): String {
 	let res = withCap(self.length + other.length);
+	let b = res.buf();
 	if self.length > 0 {
-		mem.cpy(res.data, self.data, self.length);
+		mem.cpy(b, self.buf(), self.length);
 		res.length = self.length;
 	}
 	if other.length > 0 {
-		mem.cpy(&res.data[res.length], other.data, other.length);
+		mem.cpy(&b[res.length], other.buf(), other.length);
 		res.length += other.length;
 	}
-	res.data[res.length] = 0;
+	b[res.length] = 0;
 	return res;
 };
 
@@ -321,7 +350,8 @@ let __add_assn__ in String = inline fn(other: &const any): &String {
 };
 
 let __subscr__ in String = inline fn(idx: u64): &i8 {
-	return self.data[idx];
+	let b = self.buf();
+	return b[idx];
 };
 
 let __eq__ in const String = fn(other: &const String): i1 {
@@ -343,13 +373,14 @@ let rfind in const String = inline fn(other: StringRef): u64 {
 
 let delim in const String = fn(ch: i8): vec.Vec(String) {
 	let res = vec.new(String, true);
+	let b = self.buf();
 	let last = 0;
 	for let i = 0; i < self.length; ++i {
-		if self.data[i] == ch && i >= last {
+		if b[i] == ch && i >= last {
 			if i == last {
 				res.push(new());
 			} else {
-				res.push(fromSubCStr(&self.data[last], i - last));
+				res.push(fromSubCStr(&b[last], i - last));
 			}
 			last = i + 1;
 			continue;
@@ -359,21 +390,22 @@ let delim in const String = fn(ch: i8): vec.Vec(String) {
 		if self.length == last {
 			res.push(new());
 		} else {
-			res.push(fromSubCStr(&self.data[last], self.length - last));
+			res.push(fromSubCStr(&b[last], self.length - last));
 		}
 	}
 	return res;
 };
 
 let trim in String = fn() {
+	let b = self.buf();
 	while self.length > 0 {
-		if !self.data[0].isSpace() { break; }
+		if !b[0].isSpace() { break; }
 		self.erase(0);
 	}
 	let i: u64 = 0;
 	if self.length > 0 { i = self.length - 1; }
 	while i > 0 {
-		if !self.data[i].isSpace() { break; }
+		if !b[i].isSpace() { break; }
 		self.erase(i);
 		--i;
 	}
@@ -383,44 +415,36 @@ let trim in String = fn() {
 // Conversion Functions
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
+// lenient like atoll()/atof(), use ref().parse*() for error reporting and other bases
 let int in const String = inline fn(): i64 {
-	return c.atoll(self.cStr());
+	return self.ref().int();
 };
 let uint in const String = inline fn(): u64 {
-	return c.atoull(self.cStr());
+	return self.ref().uint();
 };
 let flt in const String = inline fn(): f64 {
-	return c.atof(self.cStr());
+	return self.ref().flt();
 };
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 // str() Functions
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
-let iToStr = fn(comptime T: type, data: &const T): String {
-	let length = utils.countIntDigits(data);
-	let res = withCap(length);
-	// + 1 because snprintf includes space for null terminator
-	// which is also taken care of by withCap()
-	c.snprintf(res.getBuf(), length + 1, c.getTypeSpecifier(T), data);
+let iToStr = inline fn(data: i64): String {
+	let res = new();
+	res.appendInt(data);
 	return res;
 };
 
-let uToStr = fn(comptime T: type, data: &const T): String {
-	let length = utils.countUIntDigits(data);
-	let res = withCap(length);
-	// + 1 because snprintf includes space for null terminator
-	// which is also taken care of by withCap()
-	c.snprintf(res.getBuf(), length + 1, c.getTypeSpecifier(T), data);
+let uToStr = inline fn(data: u64): String {
+	let res = new();
+	res.appendUInt(data);
 	return res;
 };
 
-let fToStr = fn(comptime T: type, data: &const T): String {
-	let length = utils.countIntDigits(data) + getPrecision() + 1; // + 1 for decimal point
-	let res = withCap(length);
-	// + 1 because snprintf includes space for null terminator
-	// which is also taken care of by withCap()
-	c.snprintf(res.getBuf(), length + 1, c.getTypeSpecifier(T), getPrecision(), data);
+let fToStr = inline fn(data: f64): String {
+	let res = new();
+	res.appendFlt(data);
 	return res;
 };
 
@@ -428,18 +452,18 @@ let str in const i1 = fn(): String {
 	if self == true { return from("true"); }
 	return from("false");
 };
-let str in const i8 = inline fn(): String { return iToStr(i8, self); };
-let str in const i16 = inline fn(): String { return iToStr(i16, self); };
-let str in const i32 = inline fn(): String { return iToStr(i32, self); };
-let str in const i64 = inline fn(): String { return iToStr(i64, self); };
+let str in const i8 = inline fn(): String { return from(self); };
+let str in const i16 = inline fn(): String { return iToStr(self); };
+let str in const i32 = inline fn(): String { return iToStr(self); };
+let str in const i64 = inline fn(): String { return iToStr(self); };
 
-let str in const u8 = inline fn(): String { return uToStr(u8, self); };
-let str in const u16 = inline fn(): String { return uToStr(u16, self); };
-let str in const u32 = inline fn(): String { return uToStr(u32, self); };
-let str in const u64 = inline fn(): String { return uToStr(u64, self); };
+let str in const u8 = inline fn(): String { return uToStr(self); };
+let str in const u16 = inline fn(): String { return uToStr(self); };
+let str in const u32 = inline fn(): String { return uToStr(self); };
+let str in const u64 = inline fn(): String { return uToStr(self); };
 
-let str in const f32 = inline fn(): String { return fToStr(f32, self); };
-let str in const f64 = inline fn(): String { return fToStr(f64, self); };
+let str in const f32 = inline fn(): String { return fToStr(self); };
+let str in const f64 = inline fn(): String { return fToStr(self); };
 
 let str in const vec.Vec = fn(): String {
 	let res = from("[");
@@ -464,6 +488,69 @@ let str in const c.ioctl.winsize = fn(): String {
 	return res;
 };
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// StringBuilder
+//
+// Reusable buffer for building strings. reset() keeps the allocated memory, so building many
+// strings (say, log lines) with the same builder stops allocating after the first few.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+let StringBuilder = struct {
+	res: String;
+};
+
+let newBuilder = inline fn(): StringBuilder {
+	return StringBuilder{new()};
+};
+
+let deinit in StringBuilder = inline fn() {
+	self.res.deinit();
+};
+
+// ensures capacity for sz chars in total
+let reserve in StringBuilder = fn(sz: u64): &StringBuilder {
+	if self.res.cap() <= sz { self.res.growTo(sz + 1); }
+	return self;
+};
+
+let add in StringBuilder = inline fn(data: ...&const any): &StringBuilder {
+	self.res.append(data);
+	return self;
+};
+
+// empties the builder, retaining its memory
+let reset in StringBuilder = inline fn() {
+	self.res.length = 0;
+	self.res.buf()[0] = 0;
+};
+
+let len in const StringBuilder = inline fn(): u64 {
+	return self.res.length;
+};
+
+let cStr in const StringBuilder = inline fn(): *const i8 {
+	return self.res.cStr();
+};
+
+// valid until the builder is modified
+let ref in const StringBuilder = inline fn(): StringRef {
+	return self.res.ref();
+};
+
+// copy of the built string
+let str in const StringBuilder = inline fn(): String {
+	return self.res.copy();
+};
+
+// moves the built string out of the builder, which is then empty (and has no memory)
+let take in StringBuilder = fn(): String {
+	let res = self.res;
+	self.res.data = nil;
+	self.res.capacity = 0;
+	self.res.length = 0;
+	return res;
+};
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 // Tests
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -475,6 +562,33 @@ let main = fn(): i32 {
 	let str2 = new();
 	defer str.deinit();
 	defer str2.deinit();
+
+	// strict parsers - the longest valid prefix, like std::from_chars()
+	let i: i64 = 0;
+	let u: u64 = 0;
+	let f: f64 = 0.0;
+	let pr1 = "-1234xyz".parseInt(i, 10);
+	let ok = pr1.err == ParseErr.OK && pr1.len == 5 && i == -1234;
+	let pr2 = "ff".parseUInt(u, 16);
+	ok = ok && pr2.err == ParseErr.OK && u == 255;
+	let pr3 = "18446744073709551616".parseUInt(u, 10);
+	ok = ok && pr3.err == ParseErr.RANGE && pr3.len == 20 && u == 255;
+	let pr4 = " 1".parseInt(i, 10);
+	ok = ok && pr4.err == ParseErr.INVALID && pr4.len == 0;
+	let pr5 = "1.5e3,".parseFlt(f);
+	ok = ok && pr5.err == ParseErr.OK && pr5.len == 5 && f == 1500.0;
+	// printed with c.puts() - std/io imports this file
+	let res1 = from("parse*() (ok: ", ok, ")");
+	defer res1.deinit();
+	c.puts(res1.cStr());
+
+	// lenient conversions - like atoll()/atof(), but saturating
+	str2 = " +42";
+	ok = str2.int() == 42 && "-x".int() == 0 && "99999999999999999999".int() == 9223372036854775807;
+	ok = ok && "99999999999999999999".uint() == NPOS && "\t-2.5e0".flt() == -2.5;
+	let res2 = from("int()/uint()/flt() (ok: ", ok, ")");
+	defer res2.deinit();
+	c.puts(res2.cStr());
 	return 0;
 };
 
@@ -7,6 +7,7 @@ let Vec = struct<T> {
 	length: u64;
 	data: *T;
 	managed: i1;
+	allocator: mem.Allocator;
 };
 
 let init in Vec = fn(managed: i1) {
@@ -14,9 +15,10 @@ let init in Vec = fn(managed: i1) {
 	self.length = 0;
 	self.data = nil;
 	self.managed = managed;
+	self.allocator = mem.heap();
 };
 let deinit in Vec = fn() {
-	defer mem.free(self.T, self.data);
+	defer self.allocator.free(self.T, self.data, self.capacity);
 	if !self.managed || @isPrimitive(self.T) { return; }
 	for let i: u64 = 0; i < self.length; ++i {
 		inline if !@isPrimitiveOrPtr(self.T) {
@@ -27,31 +29,34 @@ let deinit in Vec = fn() {
 
 // a function with a comptime argument is guaranteed to be specialized
 let new = inline fn(comptime T: type, managed: i1): Vec(T) {
-	return Vec(T){0, 0, nil, managed};
+	return Vec(T){0, 0, nil, managed, mem.heap()};
+};
+
+// the vector's buffer is allocated from alloc (say, an arena)
+let newIn = inline fn(comptime T: type, managed: i1, alloc: mem.Allocator): Vec(T) {
+	return Vec(T){0, 0, nil, managed, alloc};
 };
 
 let reserve in Vec = fn(sz: u64): self {
 	if self.capacity >= sz { return self; }
-	if self.capacity == 0 {
-		self.data = mem.alloc(self.T, sz);
-	} else {
-		self.data = mem.realloc(self.T, self.data, sz);
-	}
+	self.data = self.allocator.realloc(self.T, self.data, self.capacity, sz);
 	self.capacity = sz;
 	return self;
 };
 
+// doubles the capacity
+let grow in Vec = fn() {
+	let newcap = self.capacity * 2;
+	if newcap == 0 { newcap = 1; }
+	self.data = self.allocator.realloc(self.T, self.data, self.capacity, newcap);
+	self.capacity = newcap;
+};
+
 // a function inside a struct which has at least one field of type 'type' has to be specialized (generic)
 // in return type, since Vec(self.T) would be self referencing, it must not be used
 let push in Vec = fn(d: &const self.T): self {
 	let comptime sz = @sizeOf(self.T);
-	if self.capacity == 0 {
-		self.capacity = 1;
-		self.data = mem.alloc(self.T, 1);
-	} elif self.length >= self.capacity {
-		self.capacity *= 2;
-		self.data = mem.realloc(self.T, self.data, self.capacity);
-	}
+	if self.length >= self.capacity { self.grow(); }
 	mem.cpy(&self.data[self.length++], &d, sz);
 	return self;
 };
@@ -67,10 +72,7 @@ let emplace in Vec = fn(args: ...&const any): self {
 
 let insert in Vec = fn(d: &const self.T, idx: u64): self {
 	if idx >= self.length { return self.push(d); }
-	if self.length >= self.capacity {
-		self.capacity *= 2;
-		self.data = mem.realloc(self.T, self.data, self.capacity);
-	}
+	if self.length >= self.capacity { self.grow(); }
 	let comptime sz = @sizeOf(self.T);
 	for let i: u64 = self.length; i > idx; --i {
 		mem.cpy(&self.data[i], &self.data[i - 1], sz);
@@ -175,7 +177,8 @@ let eachRev in Vec = inline fn(): iter.Iter(self, u64) {
 };
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-// SmoothSort Implementation; Vec.sort(cmp: fn(a: &const self.T, b: &const self.T): i32)
+// SmoothSort Implementation; Vec.smoothSort(cmp: fn(a: &const self.T, b: &const self.T): i32)
+// O(n log n) worst case and close to O(n) for nearly sorted input, but slower than sort() otherwise
 // Source: https://git.musl-libc.org/cgit/musl/tree/src/stdlib/qsort.c
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -308,7 +311,7 @@ let trinkle = fn(comptime T: type, head: *u8, width: u64, cmp: fn(a: &const T, b
 	}
 };
 
-let sort in Vec = fn(cmp: fn(a: &const self.T, b: &const self.T): i32) {
+let smoothSort in Vec = fn(cmp: fn(a: &const self.T, b: &const self.T): i32) {
 	let comptime width = @sizeOf(self.T);
 	let lp: @array(u64, 12 * @sizeOf(u64));
 	let size: u64 = width * self.length;
@@ -372,6 +375,306 @@ let sort in Vec = fn(cmp: fn(a: &const self.T, b: &const self.T): i32) {
 	}
 };
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Pattern-defeating QuickSort; Vec.sort(cmp), Vec.sortAsc()
+// Source: https://github.com/orlp/pdqsort
+//
+// All functions are specialized for the element type. With usecmp == false, elements are
+// compared using their natural order (<, or strcmp() for C strings) which the C compiler can
+// inline, so sortAsc() avoids the indirect call per comparison that sort(cmp) has.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+let comptime PDQ_INSERTION_MAX = 24; // ranges smaller than this are insertion sorted
+let comptime PDQ_NINTHER_MIN = 128; // ranges larger than this use the median of medians as pivot
+let comptime PDQ_PARTIAL_MAX = 8; // max element moves in partialInsertionSort()
+
+let sortLess = inline fn(comptime T: type, comptime usecmp: i1, cmp: any, a: &const T, b: &const T): i1 {
+	inline if usecmp {
+		return cmp(a, b) < 0;
+	} elif @isCString(T) {
+		return c.strcmp(a, b) < 0;
+	} else {
+		return a < b;
+	}
+};
+
+let sortSwap = inline fn(comptime T: type, data: *T, i: u64, j: u64) {
+	inline if @isPrimitiveOrPtr(T) {
+		let tmp = data[i];
+		data[i] = data[j];
+		data[j] = tmp;
+	} else {
+		let tmp: @array(u8, @sizeOf(T));
+		mem.cpy(&tmp[0], &data[i], @sizeOf(T));
+		mem.cpy(&data[i], &data[j], @sizeOf(T));
+		mem.cpy(&data[j], &tmp[0], @sizeOf(T));
+	}
+};
+
+// orders data[x] <= data[y] <= data[z]
+let sort3 = inline fn(comptime T: type, comptime usecmp: i1, cmp: any, data: *T, x: u64, y: u64, z: u64) {
+	if sortLess(T, usecmp, cmp, data[y], data[x]) { sortSwap(T, data, x, y); }
+	if sortLess(T, usecmp, cmp, data[z], data[y]) {
+		sortSwap(T, data, y, z);
+		if sortLess(T, usecmp, cmp, data[y], data[x]) { sortSwap(T, data, x, y); }
+	}
+};
+
+// sorts data[lo, hi)
+let insertionSort = fn(comptime T: type, comptime usecmp: i1, cmp: any, data: *T, lo: u64, hi: u64) {
+	for let i = lo + 1; i < hi; ++i {
+		let j = i;
+		inline if @isPrimitiveOrPtr(T) {
+			let tmp = data[i];
+			while j > lo && sortLess(T, usecmp, cmp, tmp, data[j - 1]) {
+				data[j] = data[j - 1];
+				--j;
+			}
+			data[j] = tmp;
+		} else {
+			while j > lo && sortLess(T, usecmp, cmp, data[j], data[j - 1]) {
+				sortSwap(T, data, j, j - 1);
+				--j;
+			}
+		}
+	}
+};
+
+// insertion sorts data[lo, hi) but gives up (returning false) after PDQ_PARTIAL_MAX moves
+let partialInsertionSort = fn(comptime T: type, comptime usecmp: i1, cmp: any, data: *T, lo: u64, hi: u64): i1 {
+	let moves: u64 = 0;
+	for let i = lo + 1; i < hi; ++i {
+		let j = i;
+		while j > lo && sortLess(T, usecmp, cmp, data[j], data[j - 1]) {
+			sortSwap(T, data, j, j - 1);
+			--j;
+		}
+		moves += i - j;
+		if moves > PDQ_PARTIAL_MAX { return false; }
+	}
+	return true;
+};
+
+let heapSift = fn(comptime T: type, comptime usecmp: i1, cmp: any, data: *T, lo: u64, root: u64, n: u64) {
+	while true {
+		let child = 2 * root + 1;
+		if child >= n { break; }
+		if child + 1 < n && sortLess(T, usecmp, cmp, data[lo + child], data[lo + child + 1]) { ++child; }
+		if !sortLess(T, usecmp, cmp, data[lo + root], data[lo + child]) { break; }
+		sortSwap(T, data, lo + root, lo + child);
+		root = child;
+	}
+};
+
+// fallback for inputs on which the pivot selection keeps failing
+let heapSort = fn(comptime T: type, comptime usecmp: i1, cmp: any, data: *T, lo: u64, hi: u64) {
+	let n = hi - lo;
+	for let i = n / 2; i > 0; --i {
+		heapSift(T, usecmp, cmp, data, lo, i - 1, n);
+	}
+	for let end = n - 1; end > 0; --end {
+		sortSwap(T, data, lo, lo + end);
+		heapSift(T, usecmp, cmp, data, lo, 0, end);
+	}
+};
+
+// partitions data[lo, hi) around the pivot data[lo], elements equal to the pivot go right
+// there must be an element >= pivot in data(lo, hi) (ensured by the pivot selection)
+// returns the final position of the pivot
+let partitionRight = fn(comptime T: type, comptime usecmp: i1, cmp: any, data: *T, lo: u64, hi: u64,
+			alreadyPartitioned: &i1): u64 {
+	let first = lo + 1;
+	let last = hi - 1;
+	while sortLess(T, usecmp, cmp, data[first], data[lo]) { ++first; }
+	if first - 1 == lo {
+		while first < last && !sortLess(T, usecmp, cmp, data[last], data[lo]) { --last; }
+	} else {
+		while !sortLess(T, usecmp, cmp, data[last], data[lo]) { --last; }
+	}
+	alreadyPartitioned = first >= last;
+	while first < last {
+		sortSwap(T, data, first, last);
+		++first;
+		while sortLess(T, usecmp, cmp, data[first], data[lo]) { ++first; }
+		--last;
+		while !sortLess(T, usecmp, cmp, data[last], data[lo]) { --last; }
+	}
+	sortSwap(T, data, lo, first - 1);
+	return first - 1;
+};
+
+// partitions data[lo, hi) around the pivot data[lo], elements equal to the pivot go left
+// used when the pivot equals the element before lo, so all of data[lo, hi) is >= pivot
+// returns the final position of the pivot
+let partitionLeft = fn(comptime T: type, comptime usecmp: i1, cmp: any, data: *T, lo: u64, hi: u64): u64 {
+	let first = lo;
+	let last = hi - 1;
+	while sortLess(T, usecmp, cmp, data[lo], data[last]) { --last; }
+	if last + 1 == hi {
+		++first;
+		while first < last && !sortLess(T, usecmp, cmp, data[lo], data[first]) { ++first; }
+	} else {
+		++first;
+		while !sortLess(T, usecmp, cmp, data[lo], data[first]) { ++first; }
+	}
+	while first < last {
+		sortSwap(T, data, first, last);
+		--last;
+		while sortLess(T, usecmp, cmp, data[lo], data[last]) { --last; }
+		++first;
+		while !sortLess(T, usecmp, cmp, data[lo], data[first]) { ++first; }
+	}
+	sortSwap(T, data, lo, last);
+	return last;
+};
+
+// shuffles a few elements of data[lo, hi) so that the next pivot is likely to be better
+let breakPatterns = fn(comptime T: type, data: *T, lo: u64, hi: u64) {
+	let size = hi - lo;
+	if size < PDQ_INSERTION_MAX { return; }
+	let q = size / 4;
+	sortSwap(T, data, lo, lo + q);
+	sortSwap(T, data, hi - 1, hi - q);
+	if size > PDQ_NINTHER_MIN {
+		sortSwap(T, data, lo + 1, lo + q + 1);
+		sortSwap(T, data, lo + 2, lo + q + 2);
+		sortSwap(T, data, hi - 2, hi - q - 1);
+		sortSwap(T, data, hi - 3, hi - q - 2);
+	}
+};
+
+// leftmost is false if data[lo - 1] exists and is <= every element of data[lo, hi)
+let pdqLoop = fn(comptime T: type, comptime usecmp: i1, cmp: any, data: *T, lo: u64, hi: u64,
+		 badAllowed: i32, leftmost: i1) {
+	while true {
+		let size = hi - lo;
+		if size < PDQ_INSERTION_MAX {
+			insertionSort(T, usecmp, cmp, data, lo, hi);
+			return;
+		}
+
+		// pivot goes to data[lo], and an element >= pivot to the end of the range
+		let mid = lo + size / 2;
+		if size > PDQ_NINTHER_MIN {
+			sort3(T, usecmp, cmp, data, lo, mid, hi - 1);
+			sort3(T, usecmp, cmp, data, lo + 1, mid - 1, hi - 2);
+			sort3(T, usecmp, cmp, data, lo + 2, mid + 1, hi - 3);
+			sort3(T, usecmp, cmp, data, mid - 1, mid, mid + 1);
+			sortSwap(T, data, lo, mid);
+		} else {
+			sort3(T, usecmp, cmp, data, mid, lo, hi - 1);
+		}
+
+		// many equal elements - the ones equal to the pivot are already in place
+		if !leftmost && !sortLess(T, usecmp, cmp, data[lo - 1], data[lo]) {
+			lo = partitionLeft(T, usecmp, cmp, data, lo, hi) + 1;
+			continue;
+		}
+
+		let alreadyPartitioned: i1 = false;
+		let pivot = partitionRight(T, usecmp, cmp, data, lo, hi, alreadyPartitioned);
+		let lsize = pivot - lo;
+		let rsize = hi - pivot - 1;
+		if lsize < size / 8 || rsize < size / 8 {
+			if --badAllowed == 0 {
+				heapSort(T, usecmp, cmp, data, lo, hi);
+				return;
+			}
+			breakPatterns(T, data, lo, pivot);
+			breakPatterns(T, data, pivot + 1, hi);
+		} elif alreadyPartitioned &&
+		      partialInsertionSort(T, usecmp, cmp, data, lo, pivot) &&
+		      partialInsertionSort(T, usecmp, cmp, data, pivot + 1, hi) {
+			return;
+		}
+
+		// recurse into the left part, loop for the right one
+		pdqLoop(T, usecmp, cmp, data, lo, pivot, badAllowed, leftmost);
+		lo = pivot + 1;
+		leftmost = false;
+	}
+};
+
+let pdqSort = fn(comptime T: type, comptime usecmp: i1, cmp: any, data: *T, count: u64) {
+	if count < 2 { return; }
+	let badAllowed = 0;
+	for let n = count; n > 1; n >>= 1 { ++badAllowed; }
+	pdqLoop(T, usecmp, cmp, data, 0, count, badAllowed, true);
+};
+
+// unstable, O(n log n) worst case; cmp returns < 0, 0, > 0 for a < b, a == b, a > b
+let sort in Vec = fn(cmp: fn(a: &const self.T, b: &const self.T): i32) {
+	pdqSort(self.T, true, cmp, self.data, self.length);
+};
+
+// same as sort() but in ascending natural order of the elements (<, or strcmp() for C strings)
+let sortAsc in Vec = fn() {
+	pdqSort(self.T, false, nil, self.data, self.length);
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Radix Sort; Vec.radixSort()
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+let comptime RADIX_MIN = 256; // smaller vectors are sorted using sortAsc()
+
+// maps an integer to a u64 whose unsigned order matches the signed order of the integer
+let radixKey = inline fn(comptime T: type, v: T): u64 {
+	inline if @isIntSigned(T) {
+		return @as(u64, v) ^ (@as(u64, 1) << (@sizeOf(T) * 8 - 1));
+	} else {
+		return @as(u64, v);
+	}
+};
+
+// LSD radix sort of integers in ascending order, one byte per pass
+// O(n) but needs a temporary copy of the vector; passes in which all elements share a byte are skipped
+let radixSort in Vec = fn() {
+	inline if !@isInt(self.T) {
+		@compileError("radixSort() works only on integers, found: ", self.T);
+	}
+	if self.length < RADIX_MIN {
+		self.sortAsc();
+		return;
+	}
+	let comptime width = @sizeOf(self.T);
+	let counts: @array(u64, width * 256);
+	mem.set(&counts[0], 0, @sizeOf(counts));
+	for let i: u64 = 0; i < self.length; ++i {
+		let key = radixKey(self.T, self.data[i]);
+		for let b: u64 = 0; b < width; ++b {
+			++counts[b * 256 + ((key >> (b * 8)) & 255)];
+		}
+	}
+	let src = self.data;
+	let dst = self.allocator.alloc(self.T, self.length);
+	let tmp = dst;
+	let inTmp = false; // sorted data is in tmp
+	for let b: u64 = 0; b < width; ++b {
+		let cnt = &counts[b * 256];
+		let shift = b * 8;
+		if cnt[(radixKey(self.T, src[0]) >> shift) & 255] == self.length { continue; }
+		let pos: u64 = 0;
+		for let d: u64 = 0; d < 256; ++d {
+			let n = cnt[d];
+			cnt[d] = pos;
+			pos += n;
+		}
+		for let i: u64 = 0; i < self.length; ++i {
+			let v = src[i];
+			dst[cnt[(radixKey(self.T, v) >> shift) & 255]++] = v;
+		}
+		let t = src;
+		src = dst;
+		dst = t;
+		inTmp = !inTmp;
+	}
+	if inTmp {
+		mem.cpy(self.data, src, self.length * width);
+	}
+	self.allocator.free(self.T, tmp, self.length);
+};
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 // Usage
 ///////////////////////////////////////////////////////////////////////////////////////////////////
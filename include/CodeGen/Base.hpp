@@ -10,6 +10,9 @@ protected:
 	Context &ctx;
 	RAIIParser &parser;
 
+	// C compiler from C_COMPILER env var, or clang/gcc from PATH
+	StringRef getSystemCompiler();
+
 public:
 	CodeGenDriver(RAIIParser &parser);
 	virtual ~CodeGenDriver();
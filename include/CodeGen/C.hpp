@@ -1,14 +1,16 @@
 #pragma once
 
 #include "Base.hpp"
+#include "ConstPool.hpp"
 #include "Writer.hpp"
 
 namespace sc
 {
 struct CTy
 {
-	String base;
-	String arr;
+	// both are interned in the context
+	StringRef base;
+	StringRef arr;
 
 private:
 	size_t recurse;
@@ -24,10 +26,7 @@ private:
 
 public:
 	CTy();
-	CTy(const String &base, const String &arr, size_t ptrs);
-
-	CTy operator+(const CTy &other) const;
-	CTy &operator+=(const CTy &other);
+	CTy(StringRef base, StringRef arr, size_t ptrs);
 
 	String toStr(StringRef *varname);
 	size_t size();
@@ -55,7 +54,7 @@ public:
 	IsX(Decl, isdecl);
 	IsX(Weak, isweak);
 
-	inline void clearArray() { arr.clear(); }
+	inline void clearArray() { arr = ""; }
 	inline bool isArray() { return !arr.empty(); }
 
 	inline void incRecurse() { ++recurse; }
@@ -77,23 +76,22 @@ class CDriver : public CodeGenDriver
 	Vector<StringRef> headers;
 	Vector<StringRef> macros;
 	Vector<StringRef> typedefs;
+	// also contains the function pointer typedefs, as struct fields may be function pointers
+	// and function pointers may take structs - each is added after the types it uses
 	Vector<StringRef> structdecls;
-	Vector<StringRef> funcptrs;
 	Vector<StringRef> funcdecls;
-	struct ConstantInfo
-	{
-		// var: names of const declarations
-		// decl: C code equivalent
-		StringRef var;
-		StringRef decl;
-	};
-	// constants: key is the constant data
-	Map<StringRef, ConstantInfo> constants;
+	ConstPool constants;
+	// C type (base, array, pointers) for each scribe type - depends on weak and decl
+	// qualifiers of the CTy since those alter the base
+	Map<Type *, CTy> ctys[4];
+	// emit #line directives which map the C code to scribe sources (--lines)
+	bool linedirs;
 
 	StringRef getConstantDataVar(const lex::Lexeme &val, Type *ty);
-	StringRef getNewConstantVar();
 	static bool acceptsSemicolon(Stmt *stmt);
+	void writeLineDirective(Stmt *stmt, Writer &writer);
 	bool getCType(CTy &res, const ModuleLoc *loc, Type *ty);
+	bool buildCType(CTy &res, const ModuleLoc *loc, Type *ty);
 	StringRef getCTypeForStringRef(Context &c, const ModuleLoc *loc);
 	bool getCValue(String &res, Stmt *stmt, Value *value, Type *type, bool i8_to_char = true);
 	bool addStructDef(const ModuleLoc *loc, StructTy *sty);
@@ -102,7 +100,6 @@ class CDriver : public CodeGenDriver
 	bool applyCast(Stmt *stmt, Writer &writer, Writer &tmp);
 	bool getFuncPointer(CTy &res, FuncTy *f, const ModuleLoc *loc);
 	StringRef getArrCount(Type *t, size_t &ptrsin);
-	StringRef getSystemCompiler();
 
 	StringRef getMangledName(StringRef name, Type *ty);
 	inline StringRef getMangledName(StringRef name, Stmt *stmt)
@@ -21,7 +21,19 @@ static const StringRef default_macro_magic = "#if defined(_SYS_STAT_H) && define
 #define st_ctimensec st_ctim.tv_nsec\n\
 #endif\n\
 \n\
-#define _SC_INLINE_ __attribute__((always_inline)) inline\
+// memrchr() is declared by glibc only with _GNU_SOURCE\n\
+#if defined(_STRING_H) && defined(__GLIBC__) && !defined(__USE_GNU)\n\
+void *memrchr(const void *s, int c, size_t n);\n\
+#endif\n\
+\n\
+#define _SC_INLINE_ __attribute__((always_inline)) inline\n\
+\n\
+_SC_INLINE_ void _sc_mum(uint64_t *a, uint64_t *b)\n\
+{\n\
+	unsigned __int128 r = (unsigned __int128)*a * *b;\n\
+	*a = (uint64_t)r;\n\
+	*b = (uint64_t)(r >> 64);\n\
+}\
 ";
 
 } // namespace sc
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Context.hpp"
+#include "Writer.hpp"
+
+namespace sc
+{
+// Constant data of the generated C code.
+// Constants are deduplicated by their type and value, and are declared (const) in
+// the order of their creation so that the output is deterministic. They are not static
+// as non-static inline functions of the generated code cannot refer to static variables.
+// Bytes of all the string constants live in a single array in which
+// strings which are suffixes of other strings share storage with them.
+class ConstPool
+{
+	struct Constant
+	{
+		StringRef var;
+		StringRef type;
+		StringRef value; // initializer for scalars
+		size_t str;	 // 1 + index in strs for strings, 0 otherwise
+	};
+	struct StrData
+	{
+		String bytes; // including the null terminator
+		size_t offset;
+	};
+
+	Context &ctx;
+	Vector<Constant> constants;
+	Map<String, size_t> keys; // type + value -> index in constants
+	Vector<StrData> strs;
+	Vector<size_t> pooled; // strs which own their bytes in the pool, in order of offsets
+	size_t poolsize;
+
+	StringRef getNewVar();
+	void layoutStrings();
+
+public:
+	ConstPool(Context &ctx);
+
+	// returns the variable for the constant; type and value are copied
+	StringRef addScalar(StringRef type, StringRef value);
+	// bytes are the actual bytes of the string (without escape sequences) - constant of type
+	// (which must outlive the pool and be a struct of {const char *data; <int> length}) is
+	// created for the string
+	StringRef addString(StringRef type, StringRef bytes);
+
+	void write(Writer &writer);
+
+	inline size_t size() { return constants.size(); }
+	inline bool empty() { return constants.empty(); }
+	inline size_t getStrCount() { return strs.size(); }
+	// bytes required by strings without any merging
+	size_t getStrBytes();
+	// bytes in the string pool (valid after write())
+	inline size_t getPoolSize() { return poolsize; }
+};
+} // namespace sc
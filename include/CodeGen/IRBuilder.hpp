@@ -0,0 +1,149 @@
+#pragma once
+
+#include "IR.hpp"
+#include "Parser/Stmts.hpp"
+
+namespace sc
+{
+// Lowers the (simplified) typed AST to the flat IR in IR.hpp.
+// Only a subset of the language is supported - everything else is reported
+// through getFailMsg()/getFailLoc() so that the caller can fall back to the C backend.
+class IRBuilder
+{
+	enum SymKind : uint8_t
+	{
+		SFUNC,	 // scribe function
+		SEXTFN,	 // extern (C) function
+		SEXTVAR, // extern (C) variable
+		SCMACRO, // extern which is not a symbol (C macro) - unsupported
+		SGLOBAL, // global variable
+		SLOCAL,	 // local variable; addr = register containing the address
+		SALIAS,	 // alias to another symbol (target)
+	};
+	struct Sym
+	{
+		SymKind kind;
+		StringRef name; // asm symbol name or alias target
+		uint32_t addr;
+		Type *ty;
+		bool variadic;
+	};
+	struct Loop
+	{
+		uint32_t continueblk;
+		uint32_t breakblk;
+	};
+
+	Context &ctx;
+	IRModule &mod;
+	IRFunc *fn;
+	Vector<Map<StringRef, Sym>> scopes;
+	Vector<Loop> loops;
+	Map<String, StringRef> strconsts;
+	Vector<StringRef> libflags;
+	Type *retty;
+	uint32_t retptr;
+	bool retref;
+	size_t anonid;
+
+	const ModuleLoc *failloc;
+	String failmsg;
+
+	template<typename... Args> bool unsupported(Stmt *stmt, Args &&...args)
+	{
+		if(!failmsg.empty()) return false;
+		failloc = stmt ? stmt->getLoc() : nullptr;
+		appendToString(failmsg, std::forward<Args>(args)...);
+		return false;
+	}
+
+	// symbols
+	StringRef getMangledName(StringRef name, Type *ty);
+	StringRef getSymName(StmtVar *var);
+	StringRef getSymName(StmtSimple *sim);
+	Sym *lookup(StringRef name);
+	inline void addSym(StringRef name, const Sym &sym) { scopes.back()[name] = sym; }
+	StringRef getAnonName(StringRef prefix);
+	StringRef getStrConst(StringRef data);
+
+	// types
+	bool getLayout(Stmt *stmt, Type *ty, uint64_t &size, uint64_t &align);
+	bool getFieldOffset(Stmt *stmt, StructTy *st, StringRef field, uint64_t &offset,
+			    Type *&fieldty);
+	bool isAggregate(Type *ty);
+	Type *getElemTy(Type *ty);
+	Type *getValTy(Stmt *stmt);
+	Type *getCommonTy(Type *a, Type *b);
+	Type *getPromotedTy(Type *ty);
+	int64_t normalizeInt(int64_t val, Type *ty);
+
+	// instructions
+	uint32_t addInstr(IRInstr &&instr, bool hasres);
+	uint32_t emitImm(int64_t val);
+	uint32_t emitArg(uint32_t idx);
+	uint32_t emitAddr(StringRef name);
+	uint32_t emitVar(uint64_t size, uint64_t align);
+	uint32_t emitLoad(uint32_t addr, Type *ty);
+	void emitStore(uint32_t addr, uint32_t val, Type *ty);
+	void emitCopy(uint32_t dest, uint32_t src, uint64_t size);
+	uint32_t emitDot(uint32_t addr, int64_t offset);
+	uint32_t emitBinOp(lex::TokType oper, uint32_t lhs, uint32_t rhs, bool sign);
+	uint32_t emitUnOp(lex::TokType oper, uint32_t val);
+	uint32_t emitMulHi(uint32_t lhs, uint32_t rhs);
+	uint32_t emitCast(uint32_t val, uint16_t bits, bool sign);
+	uint32_t newBlk();
+	void emitBlk(uint32_t blk);
+	void emitJmp(InstrTy jmp, uint32_t blk, uint32_t cond);
+	void emitRet(uint32_t val);
+
+	// conversions
+	uint32_t convert(uint32_t val, Type *from, Type *to);
+	uint32_t normalize(uint32_t val, Type *ty);
+
+	// constants
+	bool writeValue(Stmt *stmt, IRGlobal &g, uint64_t offset, Value *val, Type *ty);
+	bool writeConstInit(Stmt *stmt, IRGlobal &g, Stmt *init, Type *ty);
+	bool getConstVal(Stmt *stmt, Value *val, Type *ty, uint32_t &res);
+
+	// expressions
+	bool getAddr(Stmt *stmt, uint32_t &res);
+	bool getVal(Stmt *stmt, uint32_t &res);
+	bool getRawAddr(Stmt *stmt, uint32_t &res);
+	bool getRawVal(Stmt *stmt, uint32_t &res);
+	bool getSimpleVal(StmtSimple *stmt, uint32_t &res);
+	bool getExprVal(StmtExpr *stmt, uint32_t &res, bool wantaddr);
+	bool getCall(Stmt *stmt, Stmt *callee, FuncTy *fty, StringRef calleename,
+		     const Vector<Stmt *> &args, uint32_t &res, bool wantaddr);
+	bool getMum(Stmt *stmt, const Vector<Stmt *> &args, uint32_t &res);
+	bool getStructInit(StmtExpr *stmt, uint32_t &res);
+	bool getArith(Stmt *stmt, lex::TokType oper, uint32_t lhs, Type *lty, uint32_t rhs,
+		      Type *rty, uint32_t &res, Type *&resty);
+	bool getLogical(StmtExpr *stmt, uint32_t &res);
+	bool getIncDec(StmtExpr *stmt, uint32_t &res);
+	bool getAssn(StmtExpr *stmt, uint32_t &res, bool wantaddr);
+	bool getChainAssn(Stmt *target, uint32_t val, Type *valty, uint32_t &res, bool wantaddr);
+
+	// statements
+	bool visitTop(Stmt *stmt, bool declare);
+	bool visitTopVar(StmtVar *stmt, bool declare);
+	bool visitFunc(StringRef name, StmtFnDef *stmt);
+	bool visitExtern(StmtExtern *stmt);
+
+	bool visit(Stmt *stmt);
+	bool visit(StmtBlock *stmt);
+	bool visit(StmtVar *stmt);
+	bool visit(StmtVarDecl *stmt);
+	bool visit(StmtCond *stmt);
+	bool visit(StmtFor *stmt);
+	bool visit(StmtRet *stmt);
+
+public:
+	IRBuilder(Context &ctx, IRModule &mod);
+
+	bool build(Stmt *tree);
+
+	inline const Vector<StringRef> &getLibFlags() { return libflags; }
+	inline const ModuleLoc *getFailLoc() { return failloc; }
+	inline StringRef getFailMsg() { return failmsg; }
+};
+} // namespace sc
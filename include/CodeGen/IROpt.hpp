@@ -0,0 +1,44 @@
+#pragma once
+
+#include "IR.hpp"
+
+namespace sc
+{
+// Optimizations on the IR generated by IRBuilder.
+// Registers in the IR are already in SSA form; variables live in (CREATEVAR) stack slots.
+// Slots whose address never escapes are treated like registers - stores to them are forwarded
+// to loads within a basic block (and across the function for single, constant stores).
+class IROptimizer
+{
+	IRModule &mod;
+	Map<StringRef, IRFunc *> funcs;
+
+	size_t inlinecount;
+	size_t removedinstrs;
+
+	bool shouldInline(IRFunc &caller, const IRInstr &call, IRFunc *&callee);
+	void inlineCall(IRFunc &f, const IRInstr &call, const IRFunc &callee,
+			Vector<IRInstr> &out);
+
+	// all of these return true if the function was changed
+	bool inlineCalls(IRFunc &f);
+	bool forwardStores(IRFunc &f);
+	bool propagateConstants(IRFunc &f);
+	bool removeUnreachable(IRFunc &f);
+	bool eliminateDeadCode(IRFunc &f);
+	void simplify(IRFunc &f);
+	void compactRegisters(IRFunc &f);
+	void removeUnused();
+
+	// erase all the instructions marked INVALID
+	size_t sweep(IRFunc &f);
+
+public:
+	IROptimizer(IRModule &mod);
+
+	void optimize();
+
+	inline size_t getInlineCount() { return inlinecount; }
+	inline size_t getRemovedInstrCount() { return removedinstrs; }
+};
+} // namespace sc
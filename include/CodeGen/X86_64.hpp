@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Base.hpp"
+#include "IR.hpp"
+#include "Writer.hpp"
+
+namespace sc
+{
+// Native backend for x86_64 (System V ABI, GNU assembler syntax).
+// The IR is lowered without any register allocation - each IR register
+// has its own stack slot. Meant for fast debug builds, not fast code.
+// Falls back to the C backend if the program uses something the IR builder does not support.
+class X86_64Driver : public CodeGenDriver
+{
+	IRModule mod;
+	Map<uint32_t, int64_t> varslots; // CREATEVAR register -> frame offset
+
+	void writeGlobal(const IRGlobal &g, Writer &writer);
+	void writeFunc(const IRFunc &f, size_t fnidx, Writer &writer);
+	void writeInstr(const IRFunc &f, const IRInstr &i, size_t fnidx, Writer &writer);
+	void writeLoadReg(uint32_t reg, StringRef dest, Writer &writer);
+	void writeStoreReg(uint32_t reg, StringRef src, Writer &writer);
+	void writeLabel(size_t fnidx, uint32_t blk, Writer &writer);
+
+public:
+	X86_64Driver(RAIIParser &parser);
+	~X86_64Driver() override;
+
+	bool compile(StringRef outfile) override;
+};
+} // namespace sc
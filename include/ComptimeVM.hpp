@@ -0,0 +1,156 @@
+#pragma once
+
+#include "Parser/Stmts.hpp"
+#include "Types.hpp"
+
+namespace sc
+{
+// Evaluates comptime calls to functions which work only on integers and floats.
+// Such functions are compiled (once) to a register bytecode which is run with an
+// unboxed register stack - no Value is allocated except for the final result.
+// The VM does not touch the AST, so whenever a function cannot be compiled
+// (or fails at runtime), the caller can simply fall back to the ValueAssignPass.
+class ComptimeVM
+{
+	enum Op : uint8_t
+	{
+		MOV,   // dst = a
+		LOADK, // dst = consts[a]
+		// integer
+		ADD,
+		SUB,
+		MUL,
+		DIV,
+		MOD,
+		BAND,
+		BOR,
+		BXOR,
+		SHL,
+		SHR,
+		LAND,
+		LOR,
+		EQ,
+		LT,
+		GT,
+		LE,
+		GE,
+		NE,
+		NEG,
+		NOT,
+		BNOT,
+		// float (all results are floats, like the float intrinsics)
+		FADD,
+		FSUB,
+		FMUL,
+		FDIV,
+		FLAND,
+		FLOR,
+		FEQ,
+		FLT,
+		FGT,
+		FLE,
+		FGE,
+		FNE,
+		FNEG,
+		FNOT,
+		// control flow
+		JMP,  // goto a
+		JZ,   // if(!int(dst)) goto a
+		FJZ,  // if(!flt(dst)) goto a
+		CALL, // dst = funcs[a](regs b...)
+		RETURN, // return dst
+		FAIL, // end of function without a return
+	};
+	union Reg
+	{
+		int64_t i;
+		long double f;
+	};
+	struct Instr
+	{
+		Op op;
+		uint32_t dst;
+		uint32_t a;
+		uint32_t b;
+	};
+	struct Func
+	{
+		Vector<Instr> code;
+		Vector<Reg> consts;
+		Vector<bool> argflt;
+		uint32_t regcount;
+		bool retflt;
+		bool valid;
+	};
+	enum OperKind : uint8_t
+	{
+		BINARY,
+		UNARY,
+		ASSIGN,	       // lhs = rhs
+		ASSIGN_BINARY, // lhs = lhs <op> rhs
+		PREFIX,	       // ++lhs, --lhs
+		POSTFIX,       // lhs++, lhs--
+	};
+	// instruction for a primitive intrinsic
+	struct Oper
+	{
+		IntrinsicFn fn;
+		Op op;
+		OperKind kind;
+		bool flt; // operands and result are floats
+	};
+	struct Local
+	{
+		uint32_t reg;
+		bool flt;
+	};
+	struct Loop
+	{
+		Vector<size_t> breaks;
+		Vector<size_t> continues;
+	};
+	// state of the function being compiled
+	struct FuncState
+	{
+		size_t fnidx;
+		Map<Stmt *, Local> locals;
+		Vector<Loop> loops;
+		bool hasret;
+	};
+
+	Vector<Func> funcs;
+	Map<StmtFnDef *, size_t> fnids; // funcs index for each compiled function
+	Vector<Reg> stack;
+	size_t depth;
+
+	static const Oper *getOper(IntrinsicFn fn);
+
+	// false if the function cannot be compiled
+	bool getFunc(StmtFnDef *def, size_t &fnidx);
+
+	uint32_t emit(FuncState &fs, Op op, uint32_t dst, uint32_t a = 0, uint32_t b = 0);
+	uint32_t newReg(FuncState &fs);
+	uint32_t loadConst(FuncState &fs, Reg val);
+
+	bool compile(FuncState &fs, Stmt *stmt);
+	bool compileBlock(FuncState &fs, StmtBlock *blk);
+	bool compileCond(FuncState &fs, StmtCond *stmt);
+	bool compileFor(FuncState &fs, StmtFor *stmt);
+	bool compileExpr(FuncState &fs, Stmt *stmt, uint32_t &res, bool &flt);
+	bool compileSimple(FuncState &fs, StmtSimple *stmt, uint32_t &res, bool &flt);
+	bool compileCall(FuncState &fs, StmtFnDef *def, const Vector<Stmt *> &args, uint32_t &res,
+			 bool &flt);
+	bool compileOper(FuncState &fs, StmtExpr *stmt, uint32_t &res, bool &flt);
+	// local variable which is the target of assignments
+	Local *getTarget(FuncState &fs, Stmt *stmt);
+
+	bool exec(size_t fnidx, size_t base, Reg &res);
+
+public:
+	ComptimeVM();
+
+	// evaluates def with args (which must already have their values)
+	// returns false if the VM cannot evaluate this call
+	bool call(Context &c, StmtFnDef *def, const Vector<Stmt *> &args, Value *&res);
+};
+} // namespace sc
@@ -0,0 +1,22 @@
+#pragma once
+
+#define PROJECT_NAME "Scribe"
+// clang-format off
+#define COMPILER_MAJOR 0
+#define COMPILER_MINOR 0
+#define COMPILER_PATCH 1
+#define COMPILER_MAJOR_S "0"
+#define COMPILER_MINOR_S "0"
+#define COMPILER_PATCH_S "1"
+// clang-format on
+
+#define BUILD_CXX_COMPILER "GNU 12.2.0"
+#define BUILD_DATE "Mon Oct 19, 2026 at 06:10:28"
+
+#define REPO_URL ""
+#define COMMIT_ID "80e848c9dddfc2cb17aa7d3f97026fb762eab9fb"
+#define TREE_STATUS "Clean"
+
+#define INSTALL_DIR "/root/.scribe"
+
+#define SCRIBE_PATH_MAX 4096
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <new>
+
 #include "Core.hpp"
 
 namespace sc
@@ -15,9 +17,15 @@ class Context
 {
 	List<String> stringmem;
 	List<ModuleLoc> modlocmem;
+	// stmts are placed back to back in chunks (so that a cloned subtree is contiguous)
+	// and are destroyed using the pointers in stmtmem
 	Vector<Stmt *> stmtmem;
+	Vector<char *> stmtchunks;
+	size_t stmtchunkpos;
+	size_t stmtbytes;
 	Vector<Type *> typemem;
 	Vector<Value *> valmem;
+	uint32_t visitepoch; // stmts start with visited = 0
 	Map<size_t, Pass *> passes;
 	RAIIParser *parser;
 
@@ -39,7 +47,7 @@ public:
 
 	template<typename T, typename... Args> T *allocStmt(Args... args)
 	{
-		T *res = new T(args...);
+		T *res = new(allocStmtChunk(sizeof(T), alignof(T))) T(args...);
 		stmtmem.push_back(res);
 		return res;
 	}
@@ -55,6 +63,12 @@ public:
 		valmem.push_back(res);
 		return res;
 	}
+	void *allocStmtChunk(size_t sz, size_t align);
+	// number of stmts / bytes allocated so far (used for clone stats)
+	inline size_t getStmtCount() { return stmtmem.size(); }
+	inline size_t getStmtBytes() { return stmtbytes; }
+	// new epoch for a traversal which must visit each stmt once (see Stmt::markVisited())
+	inline uint32_t genVisitEpoch() { return ++visitepoch; }
 
 	void addPass(size_t id, Pass *pass);
 	void remPass(size_t id);
@@ -20,7 +20,9 @@ public:
 	inline void pushFrame() { stack.back().push_back({}); }
 	inline void popFrame() { stack.back().pop_back(); }
 	inline void addStmt(Stmt *s) { stack.back().back().push_back(s); }
+	// moves out the statements of the top frame - must only be used at the end of the frame
 	Vector<Stmt *> getTopStmts(Context &c);
+	// clones the statements of all frames of the function (for returns)
 	Vector<Stmt *> getAllStmts(Context &c);
 };
 } // namespace sc
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "Lex.hpp"
+
 namespace sc
 {
 
@@ -21,12 +23,81 @@ enum InstrTy
 	JMPFALSE,     // jump if condition is false
 	BINOP,	      // binary operation (+, -, etc.)
 	UNOP,	      // unary operation (++, --, etc.)
+	MULHI,	      // high 64 bits of the unsigned 128 bit product of two registers
 		      /* Utility */
 	PTR,	      // add pointer to a type
 	REF,	      // add ref to a type
 	CONST,	      // add const to a type
+		      /* Memory */
+	IMM,	      // load an immediate integer in a register
+	ARG,	      // fetch a function argument
+	ADDR,	      // get the address of a global symbol (data or function)
+	LOAD,	      // load data of given size from an address
+	STORE,	      // store data of given size at an address
+	COPY,	      // copy an aggregate from one address to another
+	CAST,	      // truncate and extend an integer to a given size
 		      /* Eh */
 	INVALID,      // invalid operation
 };
 
-} // namespace sc
\ No newline at end of file
+const char *getInstrTyCString(InstrTy ty);
+
+// All the values in the IR are (virtual) registers which are 64 bits wide.
+// Registers are defined exactly once. Integers in registers are always kept
+// sign/zero extended to 64 bits as per their type.
+// Aggregates (structs, arrays) are never in registers - their address is used instead.
+struct IRInstr
+{
+	InstrTy ty;
+	uint32_t res;	    // register set by this instruction (0 = none)
+	uint32_t blk;	    // basic block id for BASICBLOCK/JMP*, arg index for ARG
+	uint16_t bits;	    // size of data (in bits) for LOAD/STORE/CAST, alignment for CREATEVAR
+	bool sign;	    // signedness for LOAD/CAST/BINOP
+	bool indirect;	    // CALL: call the function address in args[0]
+	bool variadic;	    // CALL: callee is a C variadic function
+	lex::TokType oper;  // BINOP/UNOP operator
+	int64_t imm;	    // IMM value, DOT offset, CREATEVAR/COPY size
+	StringRef name;	    // CALL/ADDR symbol
+	Vector<uint32_t> args;
+
+	IRInstr(InstrTy ty);
+
+	String toStr() const;
+};
+
+// a global data object - variables, constant data, string literals
+struct IRGlobal
+{
+	StringRef name;
+	uint64_t align;
+	String data;				    // raw bytes (size of the global)
+	Vector<std::pair<uint64_t, StringRef>> relocs; // (offset, symbol) for pointers in data
+
+	String toStr() const;
+};
+
+struct IRFunc
+{
+	StringRef name;
+	Vector<IRInstr> instrs;
+	uint32_t regcount;
+	uint32_t blkcount;
+	bool exported;
+	bool inlinable; // defined as inline fn
+
+	IRFunc(StringRef name, bool exported);
+
+	String toStr() const;
+};
+
+struct IRModule
+{
+	Vector<IRGlobal> globals;
+	Vector<IRFunc> funcs;
+	Set<StringRef> externs; // symbols which are not defined in this module
+	StringRef entry;
+
+	String toStr() const;
+};
+
+} // namespace sc
@@ -8,11 +8,6 @@
 
 namespace sc
 {
-extern Map<uint64_t, Value *> values;
-uint64_t genValueID();
-uint64_t createValueIDWith(Value *v);
-Value *getValueWithID(uint64_t id);
-
 enum Stmts : uint8_t
 {
 	BLOCK,
@@ -55,16 +50,25 @@ protected:
 	Stmts stype;
 	uint8_t stmtmask; // for StmtMask
 	uint8_t castmask;
+	uint32_t visited; // epoch of the last traversal which visited this stmt
+
+	// marks the stmt as visited in traversal epoch - false if it was already visited
+	inline bool markVisited(uint32_t epoch)
+	{
+		if(visited == epoch) return false;
+		visited = epoch;
+		return true;
+	}
 
 public:
 	Stmt(const Stmts &stmt_type, const ModuleLoc *loc);
 	virtual ~Stmt();
 
-	virtual void disp(bool has_next)		       = 0;
-	virtual Stmt *clone(Context &ctx)		       = 0;
-	virtual void clearValue()			       = 0;
-	virtual bool requiresTemplateInit()		       = 0;
-	virtual void _setFuncUsed(bool inc, Set<Stmt *> &done) = 0;
+	virtual void disp(bool has_next)		    = 0;
+	virtual Stmt *clone(Context &ctx)		    = 0;
+	virtual void clearValue()			    = 0;
+	virtual bool requiresTemplateInit()		    = 0;
+	virtual void _setFuncUsed(bool inc, uint32_t epoch) = 0;
 
 	const char *getStmtTypeCString() const;
 	String getTypeString();
@@ -220,7 +224,7 @@ public:
 	Stmt *clone(Context &ctx);
 	void clearValue();
 	bool requiresTemplateInit();
-	void _setFuncUsed(bool inc, Set<Stmt *> &done);
+	void _setFuncUsed(bool inc, uint32_t epoch);
 
 	inline Vector<Stmt *> &getStmts() { return stmts; }
 	inline bool isTop() const { return is_top; }
@@ -243,7 +247,7 @@ public:
 	Stmt *clone(Context &ctx);
 	void clearValue();
 	bool requiresTemplateInit();
-	void _setFuncUsed(bool inc, Set<Stmt *> &done);
+	void _setFuncUsed(bool inc, uint32_t epoch);
 
 	inline void setVariadic() { variadic = true; }
 	inline void unsetVariadic() { variadic = false; }
@@ -280,7 +284,7 @@ public:
 	Stmt *clone(Context &ctx);
 	void clearValue();
 	bool requiresTemplateInit();
-	void _setFuncUsed(bool inc, Set<Stmt *> &done);
+	void _setFuncUsed(bool inc, uint32_t epoch);
 
 	inline void setDecl(StmtVar *d) { decl = d; }
 	inline void updateLexDataStr(StringRef newdata) { val.setDataStr(newdata); }
@@ -308,7 +312,7 @@ public:
 	Stmt *clone(Context &ctx);
 	void clearValue();
 	bool requiresTemplateInit();
-	void _setFuncUsed(bool inc, Set<Stmt *> &done);
+	void _setFuncUsed(bool inc, uint32_t epoch);
 
 	inline void setArg(size_t idx, Stmt *a) { args[idx] = a; }
 	inline Vector<Stmt *> &getArgs() { return args; }
@@ -338,7 +342,7 @@ public:
 	Stmt *clone(Context &ctx);
 	void clearValue();
 	bool requiresTemplateInit();
-	void _setFuncUsed(bool inc, Set<Stmt *> &done);
+	void _setFuncUsed(bool inc, uint32_t epoch);
 
 	inline void setCommas(size_t c) { commas = c; }
 	inline void setOr(StmtBlock *blk, const lex::Lexeme &blk_var)
@@ -387,7 +391,7 @@ public:
 	Stmt *clone(Context &ctx);
 	void clearValue();
 	bool requiresTemplateInit();
-	void _setFuncUsed(bool inc, Set<Stmt *> &done);
+	void _setFuncUsed(bool inc, uint32_t epoch);
 
 #define SetModifierX(Fn, Mod) \
 	inline void set##Fn() { varmask |= (uint8_t)VarMask::Mod; }
@@ -443,7 +447,7 @@ public:
 	Stmt *clone(Context &ctx);
 	void clearValue();
 	bool requiresTemplateInit();
-	void _setFuncUsed(bool inc, Set<Stmt *> &done);
+	void _setFuncUsed(bool inc, uint32_t epoch);
 
 	inline void insertArg(StmtVar *arg) { args.push_back(arg); }
 	inline void insertArg(size_t pos, StmtVar *arg) { args.insert(args.begin() + pos, arg); }
@@ -475,21 +479,13 @@ public:
 	Stmt *clone(Context &ctx);
 	void clearValue();
 	bool requiresTemplateInit();
-	void _setFuncUsed(bool inc, Set<Stmt *> &done);
+	void _setFuncUsed(bool inc, uint32_t epoch);
 
 	inline void setBlk(StmtBlock *_blk) { blk = _blk; }
 
 	inline void setParentVar(StmtVar *pvar) { parentvar = pvar; }
-	inline void incUsed()
-	{
-		Set<Stmt *> done;
-		_setFuncUsed(true, done);
-	}
-	inline void decUsed()
-	{
-		Set<Stmt *> done;
-		_setFuncUsed(false, done);
-	}
+	inline void incUsed(Context &c) { _setFuncUsed(true, c.genVisitEpoch()); }
+	inline void decUsed(Context &c) { _setFuncUsed(false, c.genVisitEpoch()); }
 	inline StmtFnSig *&getSig() { return sig; }
 	inline StmtBlock *&getBlk() { return blk; }
 	inline StmtVar *&getParentVar() { return parentvar; }
@@ -518,7 +514,7 @@ public:
 	Stmt *clone(Context &ctx);
 	void clearValue();
 	bool requiresTemplateInit();
-	void _setFuncUsed(bool inc, Set<Stmt *> &done);
+	void _setFuncUsed(bool inc, uint32_t epoch);
 
 	inline const lex::Lexeme &getNames() const { return names; }
 	inline const lex::Lexeme &getFlags() const { return flags; }
@@ -537,7 +533,7 @@ public:
 	Stmt *clone(Context &ctx);
 	void clearValue();
 	bool requiresTemplateInit();
-	void _setFuncUsed(bool inc, Set<Stmt *> &done);
+	void _setFuncUsed(bool inc, uint32_t epoch);
 
 	inline const lex::Lexeme &getFlags() const { return flags; }
 };
@@ -562,7 +558,7 @@ public:
 	Stmt *clone(Context &ctx);
 	void clearValue();
 	bool requiresTemplateInit();
-	void _setFuncUsed(bool inc, Set<Stmt *> &done);
+	void _setFuncUsed(bool inc, uint32_t epoch);
 
 	inline void setParentVar(StmtVar *var) { parentvar = var; }
 
@@ -591,7 +587,7 @@ public:
 	Stmt *clone(Context &ctx);
 	void clearValue();
 	bool requiresTemplateInit();
-	void _setFuncUsed(bool inc, Set<Stmt *> &done);
+	void _setFuncUsed(bool inc, uint32_t epoch);
 
 	inline Vector<lex::Lexeme> &getItems() { return items; }
 	inline StmtType *&getTagTy() { return tagty; }
@@ -617,7 +613,7 @@ public:
 	Stmt *clone(Context &ctx);
 	void clearValue();
 	bool requiresTemplateInit();
-	void _setFuncUsed(bool inc, Set<Stmt *> &done);
+	void _setFuncUsed(bool inc, uint32_t epoch);
 
 	inline void setDecl(bool decl) { is_decl = decl; }
 	inline void setExterned(bool externed) { is_externed = externed; }
@@ -645,7 +641,7 @@ public:
 	Stmt *clone(Context &ctx);
 	void clearValue();
 	bool requiresTemplateInit();
-	void _setFuncUsed(bool inc, Set<Stmt *> &done);
+	void _setFuncUsed(bool inc, uint32_t epoch);
 
 	inline Vector<StmtVar *> &getDecls() { return decls; }
 };
@@ -686,7 +682,7 @@ public:
 	Stmt *clone(Context &ctx);
 	void clearValue();
 	bool requiresTemplateInit();
-	void _setFuncUsed(bool inc, Set<Stmt *> &done);
+	void _setFuncUsed(bool inc, uint32_t epoch);
 
 	inline Vector<Conditional> &getConditionals() { return conds; }
 	inline bool isInline() const { return is_inline; }
@@ -712,7 +708,7 @@ public:
 	Stmt *clone(Context &ctx);
 	void clearValue();
 	bool requiresTemplateInit();
-	void _setFuncUsed(bool inc, Set<Stmt *> &done);
+	void _setFuncUsed(bool inc, uint32_t epoch);
 
 	inline Stmt *&getInit() { return init; }
 	inline Stmt *&getCond() { return cond; }
@@ -735,7 +731,7 @@ public:
 	Stmt *clone(Context &ctx);
 	void clearValue();
 	bool requiresTemplateInit();
-	void _setFuncUsed(bool inc, Set<Stmt *> &done);
+	void _setFuncUsed(bool inc, uint32_t epoch);
 
 	inline void setFnBlk(StmtBlock *blk) { fnblk = blk; }
 
@@ -753,7 +749,7 @@ public:
 	Stmt *clone(Context &ctx);
 	void clearValue();
 	bool requiresTemplateInit();
-	void _setFuncUsed(bool inc, Set<Stmt *> &done);
+	void _setFuncUsed(bool inc, uint32_t epoch);
 };
 
 class StmtBreak : public Stmt
@@ -766,7 +762,7 @@ public:
 	Stmt *clone(Context &ctx);
 	void clearValue();
 	bool requiresTemplateInit();
-	void _setFuncUsed(bool inc, Set<Stmt *> &done);
+	void _setFuncUsed(bool inc, uint32_t epoch);
 };
 
 class StmtDefer : public Stmt
@@ -782,7 +778,7 @@ public:
 	Stmt *clone(Context &ctx);
 	void clearValue();
 	bool requiresTemplateInit();
-	void _setFuncUsed(bool inc, Set<Stmt *> &done);
+	void _setFuncUsed(bool inc, uint32_t epoch);
 
 	inline Stmt *&getDeferVal() { return val; }
 };
@@ -8,6 +8,12 @@
 
 namespace sc
 {
+struct CloneStats
+{
+	size_t clones;
+	size_t stmts;
+	size_t bytes;
+};
 class TypeAssignPass : public Pass
 {
 	ValueManager vmgr;
@@ -23,12 +29,27 @@ class TypeAssignPass : public Pass
 	Vector<size_t> valen;
 	Vector<bool> is_fn_va;
 	bool disabled_varname_mangling;
+	// inline for-loop unrolling stats
+	size_t unrolled_loops;
+	size_t unrolled_iters;
+	size_t unrolled_stmts;
+	size_t pruned_stmts;
+	// stmt clones per template function / inline for-loops / defers
+	Map<StringRef, CloneStats> clonestats;
 
 	StringRef getMangledName(Stmt *stmt, StringRef name, NamespaceVal *ns = nullptr) const;
 	void applyPrimitiveTypeCoercion(Type *to, Stmt *from);
 	void applyPrimitiveTypeCoercion(Stmt *lhs, Stmt *rhs, const lex::Lexeme &oper);
 	bool chooseSuperiorPrimitiveType(Type *l, Type *r);
 	bool initTemplateFunc(Stmt *caller, FuncTy *&cf, Vector<Stmt *> &args);
+	// adds one clone of stmts / bytes to the clone stats of name
+	void addCloneStats(StringRef name, size_t stmts, size_t bytes);
+	// clones stmt, adding the stmts / bytes allocated by the clone to stmts / bytes
+	Stmt *cloneCounted(Stmt *stmt, size_t &stmts, size_t &bytes);
+	Stmt *cloneStmt(Stmt *stmt, StringRef statname);
+	// type assigns a statement of an unrolled inline for-loop and appends it to stmts
+	// unless it is discarded (dead inline conditional, defer, ...)
+	bool unrollStmt(StmtFor *loop, Vector<Stmt *> &stmts, Stmt *stmt, bool &inserted_defers);
 
 	void pushFunc(FuncVal *fn, bool is_va, size_t va_len);
 	void updateLastFunc(FuncVal *fn, bool is_va, size_t va_len);
@@ -70,5 +91,11 @@ public:
 	}
 	inline size_t getFnVALen() const { return valen.size() > 0 ? valen.back() : 0; }
 	inline bool isFnVALen() const { return is_fn_va.size() > 0 ? is_fn_va.back() : false; }
+
+	inline size_t getUnrolledLoops() const { return unrolled_loops; }
+	inline size_t getUnrolledIters() const { return unrolled_iters; }
+	inline size_t getUnrolledStmts() const { return unrolled_stmts; }
+	inline size_t getPrunedStmts() const { return pruned_stmts; }
+	inline const Map<StringRef, CloneStats> &getCloneStats() const { return clonestats; }
 };
 } // namespace sc
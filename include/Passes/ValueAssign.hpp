@@ -1,11 +1,17 @@
 #pragma once
 
+#include "ComptimeVM.hpp"
 #include "Passes/Base.hpp"
 
 namespace sc
 {
 class ValueAssignPass : public Pass
 {
+	ComptimeVM vm;
+	bool break_stmt;
+	bool continue_stmt;
+	bool return_stmt;
+
 public:
 	ValueAssignPass(Context &ctx);
 	~ValueAssignPass() override;
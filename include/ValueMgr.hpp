@@ -24,16 +24,29 @@ public:
 		return true;
 	}
 	inline bool exists(StringRef name) { return items.find(name) != items.end(); }
-	inline VarDecl *getAll(StringRef name)
+	inline bool getAll(StringRef name, VarDecl &res)
 	{
-		return items.find(name) == items.end() ? nullptr : &items[name];
+		auto loc = items.find(name);
+		if(loc == items.end()) return false;
+		res = loc->second;
+		return true;
 	}
 	inline Map<StringRef, VarDecl> &getItems() { return items; }
 };
+// All the variables of a function are in one flat table which maps each name to the stack of
+// its bindings (innermost last), so a lookup is a single probe regardless of the block depth.
+// A layer only records the names declared in it, which are unbound when the layer is popped.
+// The binding stacks reallocate as names are shadowed, so lookups copy the VarDecl out.
 class Function
 {
+	struct Binding
+	{
+		VarDecl decl;
+		size_t layer;
+	};
 	FuncTy *fty;
-	Vector<Layer> layers;
+	Map<StringRef, Vector<Binding>> table;
+	Vector<Vector<StringRef>> layers;
 
 public:
 	Function(FuncTy *ty);
@@ -41,18 +54,27 @@ public:
 	inline void setTy(FuncTy *ty) { fty = ty; }
 	inline FuncTy *getFuncTy() { return fty; }
 	inline void pushLayer() { layers.emplace_back(); }
-	inline void popLayer() { layers.pop_back(); }
+	void popLayer();
 	inline size_t size() { return layers.size(); }
-	inline bool add(StringRef name, Type *ty, Value *val, StmtVar *decl)
-	{
-		return layers.back().add(name, ty, val, decl);
-	}
+	bool add(StringRef name, Type *ty, Value *val, StmtVar *decl);
 	bool exists(StringRef name, bool top_only);
-	VarDecl *getAll(StringRef name, bool top_only);
+	bool getAll(StringRef name, bool top_only, VarDecl &res);
 };
 class ValueManager
 {
-	Map<uint32_t, Map<StringRef, FuncVal *>> typefuncs;
+	// A hit of getTyFn() - names are compared by their data pointer since all clones of a
+	// call site (and all uses of an operator) share the same name string.
+	struct TyFnCacheEntry
+	{
+		uint32_t id;
+		const char *name;
+		size_t len;
+		FuncVal *fn;
+	};
+	static constexpr size_t TYFN_CACHE_SIZE = 256;
+
+	Vector<Map<StringRef, FuncVal *>> typefuncs; // indexed by type id
+	TyFnCacheEntry tyfncache[TYFN_CACHE_SIZE];
 	Vector<Function> funcstack;
 	Layer globals;
 
@@ -90,7 +112,7 @@ public:
 	Type *getTy(StringRef var, bool top_only);
 	Value *getVal(StringRef var, bool top_only);
 	StmtVar *getDecl(StringRef var, bool top_only);
-	VarDecl *getAll(StringRef name, bool top_only);
+	bool getAll(StringRef name, bool top_only, VarDecl &res);
 	FuncVal *getTyFn(Type *ty, StringRef name);
 };
 } // namespace sc
@@ -96,12 +96,38 @@ public:
 	inline long double &getVal() { return data; }
 };
 
+// Clones of a VecVal/StructVal are lazy: the clone refers to the elements of the value it was
+// cloned from (src) and copies them only when one of the two hands out or modifies an element.
+// Once a value has handed out its elements (exposed), they can be modified through those pointers
+// at any time, so it is cloned eagerly from then on.
+// Strings are packed - their bytes are kept in one buffer and the char values are created only
+// if an element is accessed.
 class VecVal : public Value
 {
+	Context &ctx;
 	Vector<Value *> data;
+	VecVal *src;		     // value whose elements are shared by this one (lazy clone)
+	Vector<VecVal *> lazyclones; // lazy clones which share the elements of this value
+	StringRef str;		     // bytes of a packed string
+	ContainsData strcd;	     // has_data of the chars of packed string
+	bool packed;
+	bool exposed; // elements have been handed out for modification
+
+	// elements which are valid for reading only
+	const Vector<Value *> &view();
+	// unpacks / copies the elements so that they belong to this value only
+	void detach();
+	// detach(), and the elements may be modified by the caller from now on
+	inline void expose()
+	{
+		detach();
+		exposed = true;
+	}
 
 public:
 	VecVal(Context &c, ContainsData has_data, const Vector<Value *> &data);
+	VecVal(Context &c, ContainsData has_data, VecVal *src);
+	VecVal(Context &c, ContainsData has_data, ContainsData strcd, StringRef str);
 
 	String toStr() override;
 	Value *clone(Context &c) override;
@@ -110,18 +136,44 @@ public:
 	static VecVal *create(Context &c, ContainsData has_data, const Vector<Value *> &val);
 	static VecVal *createStr(Context &c, ContainsData has_data, StringRef val);
 
-	inline void insertVal(Value *v) { data.push_back(v); }
-	inline Vector<Value *> &getVal() { return data; }
-	inline Value *&getValAt(size_t idx) { return data[idx]; }
+	inline void insertVal(Value *v)
+	{
+		expose();
+		data.push_back(v);
+	}
+	inline Vector<Value *> &getVal()
+	{
+		expose();
+		return data;
+	}
+	inline Value *&getValAt(size_t idx)
+	{
+		expose();
+		return data[idx];
+	}
+	inline size_t size() { return packed ? str.size() : (src ? src->data.size() : data.size()); }
 	String getAsString();
 };
 
 class StructVal : public Value
 {
+	Context &ctx;
 	Map<StringRef, Value *> data;
+	StructVal *src;
+	Vector<StructVal *> lazyclones;
+	bool exposed;
+
+	const Map<StringRef, Value *> &view();
+	void detach();
+	inline void expose()
+	{
+		detach();
+		exposed = true;
+	}
 
 public:
 	StructVal(Context &c, ContainsData has_data, const Map<StringRef, Value *> &data);
+	StructVal(Context &c, ContainsData has_data, StructVal *src);
 
 	String toStr() override;
 	Value *clone(Context &c) override;
@@ -131,13 +183,20 @@ public:
 				 const Map<StringRef, Value *> &val);
 	static StructVal *createStrRef(Context &c, ContainsData has_data, StringRef val);
 
-	inline Map<StringRef, Value *> &getVal() { return data; }
+	inline Map<StringRef, Value *> &getVal()
+	{
+		expose();
+		return data;
+	}
 
 	inline Value *getField(StringRef key)
 	{
-		if(data.find(key) == data.end()) return nullptr;
-		return data[key];
+		expose();
+		auto loc = data.find(key);
+		if(loc == data.end()) return nullptr;
+		return loc->second;
 	}
+	inline size_t size() { return src ? src->data.size() : data.size(); }
 
 	String getStrFromRef();
 };
@@ -1,9 +1,30 @@
 #include "CodeGen/Base.hpp"
 
+#include "Env.hpp"
+#include "FS.hpp"
 #include "Parser.hpp"
 
 namespace sc
 {
 CodeGenDriver::CodeGenDriver(RAIIParser &parser) : ctx(parser.getContext()), parser(parser) {}
 CodeGenDriver::~CodeGenDriver() {}
+
+StringRef CodeGenDriver::getSystemCompiler()
+{
+	String compiler = env::get("C_COMPILER");
+	if(!compiler.empty()) {
+		if(compiler.front() == '/' || compiler.front() == '~' || compiler.front() == '.') {
+			compiler = fs::absPath(compiler);
+			return ctx.moveStr(std::move(compiler));
+		}
+	} else {
+		compiler = "clang";
+	}
+	compiler = env::getExeFromPath(compiler);
+	if(compiler.empty()) {
+		compiler = "gcc";
+		compiler = env::getExeFromPath(compiler);
+	}
+	return ctx.moveStr(std::move(compiler));
+}
 } // namespace sc
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include <cstddef>
 #include <inttypes.h>
+#include <iostream>
 
 #include "CodeGen/C/Prelude.hpp"
 #include "Env.hpp"
@@ -14,28 +15,16 @@ CTy::CTy()
 	: recurse(0), ptrs(0), ptrsin(0), isstatic(false), isvolatile(false), isconst(false),
 	  isref(false), iscast(false), isdecl(false), isweak(false)
 {}
-CTy::CTy(const String &base, const String &arr, size_t ptrs)
+CTy::CTy(StringRef base, StringRef arr, size_t ptrs)
 	: base(base), arr(arr), recurse(0), ptrs(ptrs), ptrsin(0), isstatic(false),
 	  isvolatile(false), isconst(false), isref(false), iscast(false), isdecl(false),
 	  isweak(false)
 {}
 
-CTy CTy::operator+(const CTy &other) const
-{
-	return CTy(base + other.base, arr + other.arr, ptrs + other.ptrs);
-}
-CTy &CTy::operator+=(const CTy &other)
-{
-	base += other.base;
-	arr += other.arr;
-	ptrs += other.ptrs;
-	return *this;
-}
-
 String CTy::toStr(StringRef *varname)
 {
-	static String res;
-	res.clear();
+	String res;
+	res.reserve(size() + (varname ? varname->size() : 0) + 2);
 	if(isstatic) res += "static ";
 	if(isvolatile) res += "volatile ";
 	if(isconst) res += "const ";
@@ -72,9 +61,11 @@ size_t CTy::size()
 
 void CTy::clear()
 {
-	base.clear();
-	arr.clear();
+	base	   = "";
+	arr	   = "";
+	recurse	   = 0;
 	ptrs	   = 0;
+	ptrsin	   = 0;
 	isstatic   = false;
 	isvolatile = false;
 	isconst	   = false;
@@ -83,7 +74,8 @@ void CTy::clear()
 
 CDriver::CDriver(RAIIParser &parser)
 	: CodeGenDriver(parser), preheadermacros(default_preheadermacros),
-	  headers(default_includes), typedefs(default_typedefs)
+	  headers(default_includes), typedefs(default_typedefs), constants(ctx),
+	  linedirs(parser.getCommandArgs().has("lines"))
 {}
 CDriver::~CDriver() {}
 
@@ -123,21 +115,13 @@ bool CDriver::compile(StringRef outfile)
 		finalmod.newLine();
 	}
 	if(structdecls.size() > 0) finalmod.newLine();
-	for(auto &d : funcptrs) {
-		finalmod.write(d);
-		finalmod.newLine();
-	}
-	if(funcptrs.size() > 0) finalmod.newLine();
 	for(auto &d : funcdecls) {
 		finalmod.write(d);
 		finalmod.newLine();
 	}
 	if(funcdecls.size() > 0) finalmod.newLine();
-	for(auto &c : constants) {
-		finalmod.write(c.second.decl);
-		finalmod.newLine();
-	}
-	if(constants.size() > 0) finalmod.newLine();
+	constants.write(finalmod);
+	if(!constants.empty()) finalmod.newLine();
 	finalmod.append(mainwriter);
 
 	args::ArgParser &cliargs = parser.getCommandArgs();
@@ -145,6 +129,11 @@ bool CDriver::compile(StringRef outfile)
 	StringRef std		 = "11";
 	bool ir_only		 = cliargs.has("ir");
 	bool llir		 = cliargs.has("llir");
+	if(cliargs.has("verbose")) {
+		std::cout << "constants: " << constants.size()
+			  << ", strings: " << constants.getStrCount() << " (" << constants.getStrBytes()
+			  << " bytes), string pool: " << constants.getPoolSize() << " bytes\n";
+	}
 	if(cliargs.has("opt")) {
 		StringRef res = cliargs.val("opt");
 		if(res.empty()) {
@@ -206,6 +195,7 @@ bool CDriver::compile(StringRef outfile)
 	cmd += opt;
 	cmd += " ";
 	if(opt == "0") cmd += "-gdwarf-4 ";
+	else if(linedirs) cmd += "-g ";
 	for(auto &h : headerflags) {
 		cmd += h;
 		cmd += " ";
@@ -287,6 +277,7 @@ bool CDriver::visit(StmtBlock *stmt, Writer &writer, bool semicol)
 			return false;
 		}
 		if(tmp.empty()) continue;
+		if(linedirs) writeLineDirective(s, writer);
 		writer.append(tmp);
 		if(i < stmt->getStmts().size() - 1) writer.newLine();
 	}
@@ -891,85 +882,53 @@ bool CDriver::visit(StmtDefer *stmt, Writer &writer, bool semicol)
 	return false;
 }
 
+// INT64_MIN cannot be written as a literal in C - the number part would not fit in int64_t
+static String intToCStr(int64_t val)
+{
+	if(val == INT64_MIN) return "(-9223372036854775807LL - 1)";
+	return std::to_string(val);
+}
 StringRef CDriver::getConstantDataVar(const lex::Lexeme &val, Type *ty)
 {
-	String key;
 	String value;
 	String type;
-	String bits;
-	String is_sign;
 	switch(val.getTokVal()) {
 	case lex::TRUE:
 		value = "1";
-		key += value;
-		key += "i1";
-		type = "const i1";
+		type  = "i1";
 		break;
 	case lex::FALSE: // fallthrough
 	case lex::NIL:
 		value = "0";
-		key += value;
-		key += "i1";
-		type = "const i1";
+		type  = "i1";
 		break;
 	case lex::INT:
-		value	= std::to_string(val.getDataInt());
-		bits	= std::to_string(as<IntTy>(ty)->getBits());
-		is_sign = as<IntTy>(ty)->isSigned() ? "i" : "u";
-		key += value;
-		key += as<IntTy>(ty)->isSigned() ? "i" : "u";
-		key += bits;
-		type += "const ";
-		type += as<IntTy>(ty)->isSigned() ? "i" : "u";
-		type += bits;
+		value = intToCStr(val.getDataInt());
+		type  = as<IntTy>(ty)->isSigned() ? "i" : "u";
+		type += std::to_string(as<IntTy>(ty)->getBits());
 		break;
 	case lex::FLT:
 		value = std::to_string(val.getDataFlt());
-		bits  = std::to_string(as<FltTy>(ty)->getBits());
-		key += value;
-		key += "f";
-		key += bits;
-		type += "const f";
-		type += bits;
+		type  = "f";
+		type += std::to_string(as<FltTy>(ty)->getBits());
 		break;
 	case lex::CHAR:
 		value += '\'';
 		value += toRawString(val.getDataStr());
 		value += '\'';
-		key  = value;
-		type = "const i8";
+		type = "i8";
 		break;
-	case lex::STR: {
-		String tmp = toRawString(val.getDataStr());
-		value	   = "{\"";
-		value += tmp;
-		value += "\", ";
-		value += std::to_string(tmp.size());
-		value += "}";
-		key  = value;
-		type = getCTypeForStringRef(ctx, val.getLoc());
-		break;
-	}
+	case lex::STR:
+		// the pool stores actual bytes - resolve the escape sequences
+		return constants.addString(getCTypeForStringRef(ctx, val.getLoc()),
+					   fromRawString(toRawString(val.getDataStr())));
 	default: break;
 	}
-	if(key.empty()) {
+	if(value.empty()) {
 		value = "0";
-		key   = "0i32";
-		type  = "const i32";
+		type  = "i32";
 	}
-
-	auto res = constants.find(key);
-	if(res != constants.end()) return res->second.var;
-	StringRef k    = ctx.moveStr(std::move(key));
-	StringRef var  = getNewConstantVar();
-	StringRef decl = ctx.strFrom({type, " ", var, " = ", value, ";"});
-	constants[k]   = {var, decl};
-	return constants[k].var;
-}
-StringRef CDriver::getNewConstantVar()
-{
-	static size_t const_id = 0;
-	return ctx.strFrom({"const_", std::to_string(const_id++)});
+	return constants.addScalar(type, value);
 }
 
 bool CDriver::acceptsSemicolon(Stmt *stmt)
@@ -999,6 +958,14 @@ bool CDriver::acceptsSemicolon(Stmt *stmt)
 	return false;
 }
 
+void CDriver::writeLineDirective(Stmt *stmt, Writer &writer)
+{
+	const ModuleLoc *loc = stmt->getLoc();
+	if(!loc || !loc->getMod()) return;
+	writer.write({"#line ", std::to_string(loc->getLine() + 1), " "});
+	writer.writeConstString(loc->getMod()->getPath());
+	writer.newLine();
+}
 StringRef CDriver::getCTypeForStringRef(Context &c, const ModuleLoc *loc)
 {
 	static StringRef res;
@@ -1009,6 +976,26 @@ StringRef CDriver::getCTypeForStringRef(Context &c, const ModuleLoc *loc)
 	return res;
 }
 bool CDriver::getCType(CTy &cty, const ModuleLoc *loc, Type *ty)
+{
+	if(!cty.isTop()) return buildCType(cty, loc, ty);
+	Map<Type *, CTy> &cache = ctys[cty.isWeak() * 2 + cty.isDecl()];
+	auto res		= cache.find(ty);
+	if(res != cache.end()) {
+		cty.base = res->second.base;
+		cty.arr	 = res->second.arr;
+		cty.setWeak(res->second.isWeak());
+		cty.setPtrsIn(res->second.getPtrsIn());
+		for(size_t i = cty.getPtrs(); i < res->second.getPtrs(); ++i) cty.incPtrs();
+		cty.incRecurse();
+		return true;
+	}
+	bool weak = cty.isWeak();
+	bool decl = cty.isDecl();
+	if(!buildCType(cty, loc, ty)) return false;
+	ctys[weak * 2 + decl][ty] = cty;
+	return true;
+}
+bool CDriver::buildCType(CTy &cty, const ModuleLoc *loc, Type *ty)
 {
 	if(cty.isTop()) {
 		size_t ptrsin = 0;
@@ -1018,9 +1005,8 @@ bool CDriver::getCType(CTy &cty, const ModuleLoc *loc, Type *ty)
 	cty.incRecurse();
 
 	if(cty.isWeak()) {
-		if(cty.isDecl()) cty.base = "struct ";
-		cty.base += "struct_";
-		cty.base += std::to_string(ty->getUniqID());
+		cty.base = ctx.strFrom({cty.isDecl() ? "struct " : "", "struct_",
+					std::to_string(ty->getUniqID())});
 		return true;
 	}
 
@@ -1030,7 +1016,7 @@ bool CDriver::getCType(CTy &cty, const ModuleLoc *loc, Type *ty)
 	}
 	if(ty->isTypeTy()) {
 		Type *ctyp = as<TypeTy>(ty)->getContainedTy();
-		if(!getCType(cty, loc, ctyp)) {
+		if(!buildCType(cty, loc, ctyp)) {
 			err::out(loc,
 				 "failed to determine C type for scribe type: ", ctyp->toStr());
 			return false;
@@ -1038,19 +1024,18 @@ bool CDriver::getCType(CTy &cty, const ModuleLoc *loc, Type *ty)
 		return true;
 	}
 	if(ty->isInt()) {
-		cty.base = (as<IntTy>(ty)->isSigned() ? "i" : "u");
-		cty.base += std::to_string(as<IntTy>(ty)->getBits());
+		cty.base = ctx.strFrom({as<IntTy>(ty)->isSigned() ? "i" : "u",
+					std::to_string(as<IntTy>(ty)->getBits())});
 		return true;
 	}
 	if(ty->isFlt()) {
-		cty.base = "f";
-		cty.base += std::to_string(as<FltTy>(ty)->getBits());
+		cty.base = ctx.strFrom({"f", std::to_string(as<FltTy>(ty)->getBits())});
 		return true;
 	}
 	if(ty->isPtr()) {
 		Type *to = as<PtrTy>(ty)->getTo();
 		cty.setWeak(as<PtrTy>(ty)->isWeak());
-		if(!getCType(cty, loc, to)) {
+		if(!buildCType(cty, loc, to)) {
 			err::out(loc, "failed to determine C type for scribe type: ", to->toStr());
 			return false;
 		}
@@ -1066,8 +1051,7 @@ bool CDriver::getCType(CTy &cty, const ModuleLoc *loc, Type *ty)
 			err::out(loc, "failed to add struct def '", s->toStr(), "' in C code");
 			return false;
 		}
-		cty.base = "struct_";
-		cty.base += std::to_string(s->getUniqID());
+		cty.base = ctx.strFrom({"struct_", std::to_string(s->getUniqID())});
 		return true;
 	}
 	err::out(loc, "invalid scribe type encountered: ", ty->toStr());
@@ -1094,7 +1078,7 @@ bool CDriver::getCValue(String &res, Stmt *stmt, Value *value, Type *type, bool
 			}
 			return true;
 		}
-		res = std::to_string(as<IntVal>(value)->getVal());
+		res = intToCStr(as<IntVal>(value)->getVal());
 		return true;
 	}
 	case VFLT: res = std::to_string(as<FltVal>(value)->getVal()); return true;
@@ -1124,7 +1108,7 @@ bool CDriver::getCValue(String &res, Stmt *stmt, Value *value, Type *type, bool
 			res += cval;
 			res += ", ";
 		}
-		if(as<VecVal>(value)->getVal().size() > 0) {
+		if(as<VecVal>(value)->size() > 0) {
 			res.pop_back();
 			res.pop_back();
 		}
@@ -1270,8 +1254,7 @@ bool CDriver::writeCallArgs(const ModuleLoc *loc, const Vector<Stmt *> &args, Ty
 bool CDriver::getFuncPointer(CTy &res, FuncTy *f, const ModuleLoc *loc)
 {
 	static Set<uint64_t> funcids;
-	res.base = "func_";
-	res.base += std::to_string(f->getUniqID());
+	res.base = ctx.strFrom({"func_", std::to_string(f->getUniqID())});
 	if(funcids.find(f->getUniqID()) != funcids.end()) return true;
 
 	String decl = "typedef ";
@@ -1307,7 +1290,7 @@ bool CDriver::getFuncPointer(CTy &res, FuncTy *f, const ModuleLoc *loc)
 		decl.pop_back();
 	}
 	decl += ");";
-	funcptrs.push_back(ctx.moveStr(std::move(decl)));
+	structdecls.push_back(ctx.moveStr(std::move(decl)));
 	funcids.insert(f->getUniqID());
 	return true;
 }
@@ -1329,24 +1312,6 @@ StringRef CDriver::getArrCount(Type *t, size_t &ptrsin)
 	}
 	return ctx.moveStr(std::move(res));
 }
-StringRef CDriver::getSystemCompiler()
-{
-	String compiler = env::get("C_COMPILER");
-	if(!compiler.empty()) {
-		if(compiler.front() == '/' || compiler.front() == '~' || compiler.front() == '.') {
-			compiler = fs::absPath(compiler);
-			return ctx.moveStr(std::move(compiler));
-		}
-	} else {
-		compiler = "clang";
-	}
-	compiler = env::getExeFromPath(compiler);
-	if(compiler.empty()) {
-		compiler = "gcc";
-		compiler = env::getExeFromPath(compiler);
-	}
-	return ctx.moveStr(std::move(compiler));
-}
 StringRef CDriver::getMangledName(StringRef name, Type *ty)
 {
 	String res = std::to_string(ty->getUniqID());
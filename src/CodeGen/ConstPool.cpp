@@ -0,0 +1,125 @@
+#include "CodeGen/ConstPool.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace sc
+{
+ConstPool::ConstPool(Context &ctx) : ctx(ctx), poolsize(0) {}
+
+StringRef ConstPool::getNewVar()
+{
+	return ctx.strFrom({"const_", std::to_string(constants.size())});
+}
+
+StringRef ConstPool::addScalar(StringRef type, StringRef value)
+{
+	String key(type);
+	key += '\0';
+	key += value;
+	auto res = keys.find(key);
+	if(res != keys.end()) return constants[res->second].var;
+	StringRef var = getNewVar();
+	constants.push_back({var, ctx.strFrom({type}), ctx.strFrom({value}), 0});
+	keys[std::move(key)] = constants.size() - 1;
+	return var;
+}
+
+StringRef ConstPool::addString(StringRef type, StringRef bytes)
+{
+	// '\1' separates the string keys from the scalar keys
+	String key(type);
+	key += '\1';
+	key += bytes;
+	auto res = keys.find(key);
+	if(res != keys.end()) return constants[res->second].var;
+	StringRef var = getNewVar();
+	String data(bytes);
+	data += '\0';
+	strs.push_back({std::move(data), 0});
+	constants.push_back({var, type, "", strs.size()});
+	keys[std::move(key)] = constants.size() - 1;
+	return var;
+}
+
+size_t ConstPool::getStrBytes()
+{
+	size_t res = 0;
+	for(auto &s : strs) res += s.bytes.size();
+	return res;
+}
+
+// Strings are sorted in descending order of their reversed bytes.
+// That way, a string which is a suffix of another one comes right after
+// the longest string it is a suffix of, and can simply point into it.
+void ConstPool::layoutStrings()
+{
+	Vector<size_t> order(strs.size());
+	for(size_t i = 0; i < order.size(); ++i) order[i] = i;
+	std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+		const String &sa = strs[a].bytes;
+		const String &sb = strs[b].bytes;
+		return std::lexicographical_compare(sb.rbegin(), sb.rend(), sa.rbegin(), sa.rend());
+	});
+	pooled.clear();
+	poolsize       = 0;
+	StrData *owner = nullptr;
+	for(auto &i : order) {
+		StrData &s = strs[i];
+		if(owner && owner->bytes.size() >= s.bytes.size() &&
+		   std::equal(s.bytes.rbegin(), s.bytes.rend(), owner->bytes.rbegin()))
+		{
+			s.offset = owner->offset + owner->bytes.size() - s.bytes.size();
+			continue;
+		}
+		s.offset = poolsize;
+		poolsize += s.bytes.size();
+		owner = &s;
+		pooled.push_back(i);
+	}
+}
+
+void ConstPool::write(Writer &writer)
+{
+	if(constants.empty()) return;
+	layoutStrings();
+	if(!strs.empty()) {
+		writer.write("const char const_pool[] =");
+		String line;
+		char oct[5];
+		for(auto &i : pooled) {
+			for(auto &c : strs[i].bytes) {
+				unsigned char uc = c;
+				if(uc < 32 || uc > 126 || c == '"' || c == '\\' || c == '?') {
+					snprintf(oct, sizeof(oct), "\\%03o", uc);
+					line += oct;
+				} else {
+					line += c;
+				}
+				if(line.size() < 80) continue;
+				writer.newLine();
+				writer.write({"\t\"", line, "\""});
+				line.clear();
+			}
+		}
+		if(!line.empty()) {
+			writer.newLine();
+			writer.write({"\t\"", line, "\""});
+		}
+		writer.write(";");
+		writer.newLine();
+	}
+	for(auto &c : constants) {
+		writer.write({"const ", c.type, " ", c.var, " = "});
+		if(c.str) {
+			StrData &s = strs[c.str - 1];
+			writer.write({"{const_pool + ", std::to_string(s.offset), ", ",
+				      std::to_string(s.bytes.size() - 1), "}"});
+		} else {
+			writer.write(c.value);
+		}
+		writer.write(";");
+		writer.newLine();
+	}
+}
+} // namespace sc
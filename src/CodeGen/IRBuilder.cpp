@@ -0,0 +1,1339 @@
+#include "CodeGen/IRBuilder.hpp"
+
+#include <dlfcn.h>
+#include <link.h>
+
+#include "Utils.hpp"
+
+namespace sc
+{
+// string literals are stored with (some of) their escape sequences intact -
+// get the actual bytes, same as the ones in the C backend's constant pool
+static String getCStrBytes(StringRef data) { return fromRawString(toRawString(data)); }
+
+// externs are often C macros which have no symbol to link with;
+// check if the C library (which is linked with the compiler too) has a non-TLS symbol by that name
+static bool isLinkableSymbol(StringRef name)
+{
+	String n(name);
+	void *addr = dlsym(RTLD_DEFAULT, n.c_str());
+	if(!addr) return false;
+	Dl_info info;
+	const ElfW(Sym) *sym = nullptr;
+	if(!dladdr1(addr, &info, (void **)&sym, RTLD_DL_SYMENT) || !sym) return true;
+	return ELF64_ST_TYPE(sym->st_info) != STT_TLS;
+}
+
+IRBuilder::IRBuilder(Context &ctx, IRModule &mod)
+	: ctx(ctx), mod(mod), fn(nullptr), retty(nullptr), retptr(0), retref(false), anonid(0),
+	  failloc(nullptr)
+{}
+
+bool IRBuilder::build(Stmt *tree)
+{
+	scopes.emplace_back();
+	// first declare all the global symbols since functions can be used before definition
+	if(!visitTop(tree, true) || !visitTop(tree, false)) return false;
+	scopes.pop_back();
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////// Symbols /////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+StringRef IRBuilder::getMangledName(StringRef name, Type *ty)
+{
+	String res = std::to_string(ty->getUniqID());
+	res.insert(res.begin(), name.begin(), name.end());
+	return ctx.moveStr(std::move(res));
+}
+StringRef IRBuilder::getSymName(StmtVar *var)
+{
+	StringRef name = var->getName().getDataStr();
+	if(var->isCodeGenManglingDisabled()) return name;
+	return getMangledName(name, var->getTy(true));
+}
+StringRef IRBuilder::getSymName(StmtSimple *sim)
+{
+	StringRef name = sim->getLexValue().getDataStr();
+	if(sim->isCodeGenManglingDisabled()) return name;
+	return getMangledName(name, sim->getTy(true));
+}
+IRBuilder::Sym *IRBuilder::lookup(StringRef name)
+{
+	for(auto s = scopes.rbegin(); s != scopes.rend(); ++s) {
+		auto res = s->find(name);
+		if(res == s->end()) continue;
+		if(res->second.kind == SALIAS) return lookup(res->second.name);
+		return &res->second;
+	}
+	return nullptr;
+}
+StringRef IRBuilder::getAnonName(StringRef prefix)
+{
+	return ctx.strFrom({"__sc_", prefix, "_", ctx.strFrom(anonid++)});
+}
+StringRef IRBuilder::getStrConst(StringRef data)
+{
+	String key(data);
+	auto loc = strconsts.find(key);
+	if(loc != strconsts.end()) return loc->second;
+	IRGlobal g;
+	g.name	= getAnonName("str");
+	g.align = 1;
+	g.data	= getCStrBytes(data);
+	g.data.push_back('\0');
+	mod.globals.push_back(std::move(g));
+	strconsts[key] = mod.globals.back().name;
+	return mod.globals.back().name;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////// Types //////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool IRBuilder::getLayout(Stmt *stmt, Type *ty, uint64_t &size, uint64_t &align)
+{
+	if(ty->isTypeTy() && as<TypeTy>(ty)->getContainedTy()) {
+		return getLayout(stmt, as<TypeTy>(ty)->getContainedTy(), size, align);
+	}
+	if(ty->isInt()) {
+		size  = as<IntTy>(ty)->getBits() < 8 ? 1 : as<IntTy>(ty)->getBits() / 8;
+		align = size;
+		return true;
+	}
+	if(ty->isFunc()) {
+		size = align = 8;
+		return true;
+	}
+	if(ty->isPtr()) {
+		PtrTy *p = as<PtrTy>(ty);
+		if(!p->getCount()) {
+			size = align = 8;
+			return true;
+		}
+		if(!getLayout(stmt, p->getTo(), size, align)) return false;
+		size *= p->getCount();
+		return true;
+	}
+	if(ty->isStruct()) {
+		StructTy *st = as<StructTy>(ty);
+		if(st->isExtern()) {
+			return unsupported(stmt, "layout of extern struct: ", st->toStr());
+		}
+		size  = 0;
+		align = 1;
+		for(auto &f : st->getFields()) {
+			uint64_t fsz, falign;
+			if(!getLayout(stmt, f, fsz, falign)) return false;
+			size = (size + falign - 1) / falign * falign;
+			size += fsz;
+			if(falign > align) align = falign;
+		}
+		size = (size + align - 1) / align * align;
+		return true;
+	}
+	return unsupported(stmt, "type: ", ty->toStr());
+}
+bool IRBuilder::getFieldOffset(Stmt *stmt, StructTy *st, StringRef field, uint64_t &offset,
+			       Type *&fieldty)
+{
+	if(st->isExtern()) {
+		return unsupported(stmt, "field access in extern struct: ", st->toStr());
+	}
+	offset = 0;
+	for(size_t i = 0; i < st->getFields().size(); ++i) {
+		uint64_t fsz, falign;
+		Type *f = st->getField(i);
+		if(!getLayout(stmt, f, fsz, falign)) return false;
+		offset = (offset + falign - 1) / falign * falign;
+		if(st->getFieldName(i) == field) {
+			fieldty = f;
+			return true;
+		}
+		offset += fsz;
+	}
+	return unsupported(stmt, "unknown field '", field, "' in struct: ", st->toStr());
+}
+bool IRBuilder::isAggregate(Type *ty)
+{
+	if(ty->isTypeTy() && as<TypeTy>(ty)->getContainedTy()) {
+		return isAggregate(as<TypeTy>(ty)->getContainedTy());
+	}
+	return ty->isStruct() || (ty->isPtr() && as<PtrTy>(ty)->getCount() > 0);
+}
+Type *IRBuilder::getElemTy(Type *ty) { return as<PtrTy>(ty)->getTo(); }
+Type *IRBuilder::getValTy(Stmt *stmt)
+{
+	Type *t = stmt->getCast() ? stmt->getCast() : stmt->getTy(true);
+	for(uint16_t i = 0; i < stmt->getDerefCount(); ++i) t = getElemTy(t);
+	return t;
+}
+Type *IRBuilder::getPromotedTy(Type *ty)
+{
+	if(!ty->isInt()) return IntTy::get(ctx, 64, false);
+	if(as<IntTy>(ty)->getBits() < 32) return IntTy::get(ctx, 32, true);
+	return ty;
+}
+// C's usual arithmetic conversions
+Type *IRBuilder::getCommonTy(Type *a, Type *b)
+{
+	IntTy *l = as<IntTy>(getPromotedTy(a));
+	IntTy *r = as<IntTy>(getPromotedTy(b));
+	if(l->isSigned() == r->isSigned()) return l->getBits() >= r->getBits() ? l : r;
+	IntTy *u = l->isSigned() ? r : l;
+	IntTy *s = l->isSigned() ? l : r;
+	if(u->getBits() >= s->getBits()) return u;
+	return s;
+}
+int64_t IRBuilder::normalizeInt(int64_t val, Type *ty)
+{
+	if(!ty->isInt()) return val;
+	IntTy *t = as<IntTy>(ty);
+	if(t->getBits() == 1) return val != 0;
+	if(t->getBits() >= 64) return val;
+	uint64_t mask = (1ULL << t->getBits()) - 1;
+	uint64_t res  = (uint64_t)val & mask;
+	if(t->isSigned() && (res >> (t->getBits() - 1))) res |= ~mask;
+	return (int64_t)res;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////// Instructions //////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t IRBuilder::addInstr(IRInstr &&instr, bool hasres)
+{
+	if(hasres) instr.res = fn->regcount++;
+	fn->instrs.push_back(std::move(instr));
+	return fn->instrs.back().res;
+}
+uint32_t IRBuilder::emitImm(int64_t val)
+{
+	IRInstr i(IMM);
+	i.imm = val;
+	return addInstr(std::move(i), true);
+}
+uint32_t IRBuilder::emitArg(uint32_t idx)
+{
+	IRInstr i(ARG);
+	i.blk = idx;
+	return addInstr(std::move(i), true);
+}
+uint32_t IRBuilder::emitAddr(StringRef name)
+{
+	IRInstr i(ADDR);
+	i.name = name;
+	return addInstr(std::move(i), true);
+}
+uint32_t IRBuilder::emitVar(uint64_t size, uint64_t align)
+{
+	IRInstr i(CREATEVAR);
+	i.imm  = size;
+	i.bits = align;
+	return addInstr(std::move(i), true);
+}
+uint32_t IRBuilder::emitLoad(uint32_t addr, Type *ty)
+{
+	if(isAggregate(ty)) return addr;
+	IRInstr i(LOAD);
+	i.bits = 64;
+	if(ty->isInt()) {
+		i.bits = as<IntTy>(ty)->getBits() < 8 ? 8 : as<IntTy>(ty)->getBits();
+		i.sign = as<IntTy>(ty)->isSigned() && as<IntTy>(ty)->getBits() > 1;
+	}
+	i.args.push_back(addr);
+	return addInstr(std::move(i), true);
+}
+void IRBuilder::emitStore(uint32_t addr, uint32_t val, Type *ty)
+{
+	IRInstr i(STORE);
+	i.bits = 64;
+	if(ty->isInt()) i.bits = as<IntTy>(ty)->getBits() < 8 ? 8 : as<IntTy>(ty)->getBits();
+	i.args = {addr, val};
+	addInstr(std::move(i), false);
+}
+void IRBuilder::emitCopy(uint32_t dest, uint32_t src, uint64_t size)
+{
+	IRInstr i(COPY);
+	i.imm  = size;
+	i.args = {dest, src};
+	addInstr(std::move(i), false);
+}
+uint32_t IRBuilder::emitDot(uint32_t addr, int64_t offset)
+{
+	if(!offset) return addr;
+	IRInstr i(DOT);
+	i.imm = offset;
+	i.args.push_back(addr);
+	return addInstr(std::move(i), true);
+}
+uint32_t IRBuilder::emitBinOp(lex::TokType oper, uint32_t lhs, uint32_t rhs, bool sign)
+{
+	IRInstr i(BINOP);
+	i.oper = oper;
+	i.sign = sign;
+	i.args = {lhs, rhs};
+	return addInstr(std::move(i), true);
+}
+uint32_t IRBuilder::emitUnOp(lex::TokType oper, uint32_t val)
+{
+	IRInstr i(UNOP);
+	i.oper = oper;
+	i.args.push_back(val);
+	return addInstr(std::move(i), true);
+}
+uint32_t IRBuilder::emitMulHi(uint32_t lhs, uint32_t rhs)
+{
+	IRInstr i(MULHI);
+	i.args = {lhs, rhs};
+	return addInstr(std::move(i), true);
+}
+uint32_t IRBuilder::emitCast(uint32_t val, uint16_t bits, bool sign)
+{
+	IRInstr i(CAST);
+	i.bits = bits;
+	i.sign = sign;
+	i.args.push_back(val);
+	return addInstr(std::move(i), true);
+}
+uint32_t IRBuilder::newBlk() { return fn->blkcount++; }
+void IRBuilder::emitBlk(uint32_t blk)
+{
+	IRInstr i(BASICBLOCK);
+	i.blk = blk;
+	addInstr(std::move(i), false);
+}
+void IRBuilder::emitJmp(InstrTy jmp, uint32_t blk, uint32_t cond)
+{
+	IRInstr i(jmp);
+	i.blk = blk;
+	if(jmp != JMP) i.args.push_back(cond);
+	addInstr(std::move(i), false);
+}
+void IRBuilder::emitRet(uint32_t val)
+{
+	IRInstr i(RETURN);
+	if(val) i.args.push_back(val);
+	addInstr(std::move(i), false);
+	// anything after return is unreachable, but must still belong to a block
+	emitBlk(newBlk());
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////// Conversions ///////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+// registers are always normalized (sign/zero extended to 64 bits) as per their type,
+// so conversion to any 64 bit type is a no-op
+uint32_t IRBuilder::convert(uint32_t val, Type *from, Type *to)
+{
+	if(!to || !to->isInt()) return val;
+	IntTy *t = as<IntTy>(to);
+	if(t->getBits() >= 64) return val;
+	if(t->getBits() == 1) {
+		if(from->isInt() && as<IntTy>(from)->getBits() == 1) return val;
+		return emitCast(val, 1, false);
+	}
+	if(from->isInt()) {
+		IntTy *f = as<IntTy>(from);
+		if(f->getBits() < t->getBits() && (f->isSigned() == t->isSigned() || !f->isSigned()))
+		{
+			return val;
+		}
+		if(f->getBits() == t->getBits() && f->isSigned() == t->isSigned()) return val;
+	}
+	return emitCast(val, t->getBits(), t->isSigned());
+}
+uint32_t IRBuilder::normalize(uint32_t val, Type *ty)
+{
+	if(!ty->isInt()) return val;
+	IntTy *t = as<IntTy>(ty);
+	if(t->getBits() >= 64) return val;
+	if(t->getBits() <= 8) return emitCast(val, 8, t->isSigned() && t->getBits() > 1);
+	return emitCast(val, t->getBits(), t->isSigned());
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////// Constants ////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool IRBuilder::writeValue(Stmt *stmt, IRGlobal &g, uint64_t offset, Value *val, Type *ty)
+{
+	uint64_t size, align;
+	if(!getLayout(stmt, ty, size, align)) return false;
+	switch(val->getValType()) {
+	case VINT: {
+		int64_t v = normalizeInt(as<IntVal>(val)->getVal(), ty);
+		for(uint64_t i = 0; i < size && i < 8; ++i) g.data[offset + i] = (v >> (i * 8)) & 0xff;
+		return true;
+	}
+	case VVEC: {
+		if(!ty->isPtr()) break;
+		PtrTy *pt = as<PtrTy>(ty);
+		if(pt->isArrayPtr()) {
+			uint64_t esz, ealign;
+			if(!getLayout(stmt, pt->getTo(), esz, ealign)) return false;
+			Vector<Value *> &elems = as<VecVal>(val)->getVal();
+			for(size_t i = 0; i < elems.size() && i < pt->getCount(); ++i) {
+				if(!writeValue(stmt, g, offset + i * esz, elems[i], pt->getTo())) {
+					return false;
+				}
+			}
+			return true;
+		}
+		Type *to = pt->getTo();
+		if(to->isInt() && as<IntTy>(to)->getBits() == 8) {
+			g.relocs.emplace_back(offset, getStrConst(as<VecVal>(val)->getAsString()));
+			return true;
+		}
+		break;
+	}
+	case VSTRUCT: {
+		if(!ty->isStruct()) break;
+		StructTy *st = as<StructTy>(ty);
+		for(size_t i = 0; i < st->getFields().size(); ++i) {
+			StringRef fname = st->getFieldName(i);
+			Value *fv	= as<StructVal>(val)->getField(fname);
+			uint64_t foff;
+			Type *fty;
+			if(!fv) continue;
+			if(!getFieldOffset(stmt, st, fname, foff, fty)) return false;
+			if(!writeValue(stmt, g, offset + foff, fv, fty)) return false;
+		}
+		return true;
+	}
+	default: break;
+	}
+	return unsupported(stmt, "constant value: ", val->toStr(), " of type: ", ty->toStr());
+}
+bool IRBuilder::writeConstInit(Stmt *stmt, IRGlobal &g, Stmt *init, Type *ty)
+{
+	if(init->getVal() && init->getVal()->hasData()) {
+		return writeValue(stmt, g, 0, init->getVal(), ty);
+	}
+	int64_t v = 0;
+	if(init->isSimple()) {
+		lex::Lexeme &lv = as<StmtSimple>(init)->getLexValue();
+		switch(lv.getTokVal()) {
+		case lex::TRUE: v = 1; break;
+		case lex::FALSE:
+		case lex::NIL: v = 0; break;
+		case lex::INT: v = lv.getDataInt(); break;
+		case lex::CHAR: v = (int8_t)getCStrBytes(lv.getDataStr()).front(); break;
+		case lex::STR: {
+			if(!ty->isStruct()) goto fail;
+			StringRef data = lv.getDataStr();
+			g.relocs.emplace_back(0, getStrConst(data));
+			v = getCStrBytes(data).size();
+			for(size_t i = 0; i < 8; ++i) g.data[8 + i] = (v >> (i * 8)) & 0xff;
+			return true;
+		}
+		default: goto fail;
+		}
+	} else if(init->isExpr() && as<StmtExpr>(init)->getOper().getTokVal() == lex::USUB) {
+		Stmt *lhs = as<StmtExpr>(init)->getLHS();
+		if(!lhs->isSimple() || as<StmtSimple>(lhs)->getLexValue().getTokVal() != lex::INT) {
+			goto fail;
+		}
+		v = -as<StmtSimple>(lhs)->getLexValue().getDataInt();
+	} else {
+		goto fail;
+	}
+	if(!ty->isPrimitiveOrPtr() || ty->isFlt()) goto fail;
+	v = normalizeInt(v, ty);
+	for(size_t i = 0; i < g.data.size() && i < 8; ++i) g.data[i] = (v >> (i * 8)) & 0xff;
+	return true;
+fail:
+	return unsupported(init, "non constant initializer for global variable");
+}
+bool IRBuilder::getConstVal(Stmt *stmt, Value *val, Type *ty, uint32_t &res)
+{
+	if(val->isInt() && !ty->isFlt()) {
+		res = emitImm(normalizeInt(as<IntVal>(val)->getVal(), ty));
+		return true;
+	}
+	// everything else is written as an anonymous global
+	uint64_t size, align;
+	if(!getLayout(stmt, ty, size, align)) return false;
+	bool is_ptr = ty->isPtr() && !as<PtrTy>(ty)->isArrayPtr();
+	IRGlobal g;
+	g.name	= getAnonName("const");
+	g.align = align;
+	g.data.resize(size, 0);
+	if(!writeValue(stmt, g, 0, val, ty)) return false;
+	if(is_ptr && g.relocs.size() == 1) {
+		// string - directly use the pointer to constant string
+		res = emitAddr(g.relocs.back().second);
+		return true;
+	}
+	mod.globals.push_back(std::move(g));
+	res = emitAddr(mod.globals.back().name);
+	if(is_ptr) res = emitLoad(res, ty);
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////// Expressions ///////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Address of the location represented by stmt (after dereferences)
+bool IRBuilder::getAddr(Stmt *stmt, uint32_t &res)
+{
+	uint16_t derefs = stmt->getDerefCount();
+	if(!derefs) return getRawAddr(stmt, res);
+	if(!getRawVal(stmt, res)) return false;
+	for(uint16_t i = 1; i < derefs; ++i) res = emitLoad(res, VoidTy::get(ctx));
+	return true;
+}
+// Value represented by stmt (after dereferences and cast) - type is getValTy(stmt)
+bool IRBuilder::getVal(Stmt *stmt, uint32_t &res)
+{
+	if(stmt->getDerefCount()) {
+		if(!getAddr(stmt, res)) return false;
+		res = emitLoad(res, getValTy(stmt));
+		return true;
+	}
+	if(!getRawVal(stmt, res)) return false;
+	if(stmt->getCast()) res = convert(res, stmt->getTy(true), stmt->getCast());
+	return true;
+}
+bool IRBuilder::getRawAddr(Stmt *stmt, uint32_t &res)
+{
+	if(stmt->isSimple()) {
+		StmtSimple *sim = as<StmtSimple>(stmt);
+		if(sim->getLexValue().getTokVal() == lex::IDEN) {
+			StringRef name = getSymName(sim);
+			Sym *sym       = lookup(name);
+			if(!sym) return unsupported(stmt, "unknown symbol: ", name);
+			switch(sym->kind) {
+			case SLOCAL: res = sym->addr; return true;
+			case SGLOBAL:
+			case SEXTVAR: res = emitAddr(sym->name); return true;
+			case SCMACRO: return unsupported(stmt, "use of C macro: ", sym->name);
+			default: break;
+			}
+		} else if(sim->getLexValue().getTokVal() == lex::STR) {
+			return getSimpleVal(sim, res);
+		}
+	} else if(stmt->isExpr()) {
+		StmtExpr *expr	= as<StmtExpr>(stmt);
+		lex::TokType op = expr->getOper().getTokVal();
+		if(!(expr->getVal() && expr->getVal()->hasPermaData()) &&
+		   (op == lex::DOT || op == lex::ARROW || op == lex::UMUL || op == lex::SUBS ||
+		    op == lex::FNCALL || op == lex::ASSN))
+		{
+			return getExprVal(expr, res, true);
+		}
+	}
+	// temporary - required for passing rvalues as references
+	Type *t = stmt->getTy(true);
+	if(!getRawVal(stmt, res)) return false;
+	if(isAggregate(t)) return true;
+	uint64_t size, align;
+	if(!getLayout(stmt, t, size, align)) return false;
+	uint32_t tmp = emitVar(size, align);
+	emitStore(tmp, res, t);
+	res = tmp;
+	return true;
+}
+bool IRBuilder::getRawVal(Stmt *stmt, uint32_t &res)
+{
+	switch(stmt->getStmtType()) {
+	case SIMPLE: return getSimpleVal(as<StmtSimple>(stmt), res);
+	case EXPR: return getExprVal(as<StmtExpr>(stmt), res, false);
+	default: break;
+	}
+	return unsupported(stmt, "expression: ", stmt->getStmtTypeCString());
+}
+bool IRBuilder::getSimpleVal(StmtSimple *stmt, uint32_t &res)
+{
+	lex::Lexeme &lv = stmt->getLexValue();
+	Type *t		= stmt->getTy(true);
+	switch(lv.getTokVal()) {
+	case lex::TRUE: res = emitImm(1); return true;
+	case lex::FALSE:
+	case lex::NIL: res = emitImm(0); return true;
+	case lex::INT:
+		if(t->isFlt()) break;
+		res = emitImm(normalizeInt(lv.getDataInt(), t));
+		return true;
+	case lex::CHAR: res = emitImm((int8_t)getCStrBytes(lv.getDataStr()).front()); return true;
+	case lex::STR: {
+		StringRef data = lv.getDataStr();
+		IRGlobal g;
+		g.name	= getAnonName("strref");
+		g.align = 8;
+		g.data.resize(16, 0);
+		g.relocs.emplace_back(0, getStrConst(data));
+		size_t len = getCStrBytes(data).size();
+		for(size_t i = 0; i < 8; ++i) g.data[8 + i] = (len >> (i * 8)) & 0xff;
+		mod.globals.push_back(std::move(g));
+		res = emitAddr(mod.globals.back().name);
+		return true;
+	}
+	case lex::IDEN: {
+		StringRef name = getSymName(stmt);
+		Sym *sym       = lookup(name);
+		if(!sym) return unsupported(stmt, "unknown symbol: ", name);
+		if(sym->kind == SFUNC || sym->kind == SEXTFN) {
+			res = emitAddr(sym->name);
+			return true;
+		}
+		if(sym->kind == SCMACRO) return unsupported(stmt, "use of C macro: ", sym->name);
+		uint32_t addr;
+		if(!getRawAddr(stmt, addr)) return false;
+		res = emitLoad(addr, t);
+		return true;
+	}
+	default: break;
+	}
+	return unsupported(stmt, "literal: ", lv.getDataStr());
+}
+bool IRBuilder::getExprVal(StmtExpr *stmt, uint32_t &res, bool wantaddr)
+{
+	if(stmt->getVal() && stmt->getVal()->hasPermaData()) {
+		return getConstVal(stmt, stmt->getVal(), stmt->getTy(true), res);
+	}
+	lex::TokType oper = stmt->getOper().getTokVal();
+	Stmt *lhs	  = stmt->getLHS();
+	Stmt *rhs	  = stmt->getRHS();
+	switch(oper) {
+	case lex::ARROW:
+	case lex::DOT: {
+		uint32_t addr;
+		uint64_t offset;
+		Type *fty;
+		Type *lty = getValTy(lhs);
+		if(!lty->isStruct()) return unsupported(stmt, "dot on non struct: ", lty->toStr());
+		StringRef field = as<StmtSimple>(rhs)->getLexValue().getDataStr();
+		if(!getFieldOffset(stmt, as<StructTy>(lty), field, offset, fty)) return false;
+		if(!getAddr(lhs, addr)) return false;
+		res = emitDot(addr, offset);
+		if(!wantaddr) res = emitLoad(res, fty);
+		return true;
+	}
+	case lex::FNCALL: {
+		if(!lhs->getTy()->isFunc()) return unsupported(stmt, "call on non function");
+		FuncTy *fty = as<FuncTy>(lhs->getTy());
+		StringRef name;
+		if(lhs->isSimple()) {
+			StmtSimple *sim = as<StmtSimple>(lhs);
+			name		= sim->getLexValue().getDataStr();
+			if(!sim->isCodeGenManglingDisabled()) name = getMangledName(name, fty);
+		}
+		Vector<Stmt *> &args = as<StmtFnCallInfo>(rhs)->getArgs();
+		return getCall(stmt, lhs, fty, name, args, res, wantaddr);
+	}
+	case lex::STCALL: return getStructInit(stmt, res);
+	case lex::UAND: return getAddr(lhs, res);
+	case lex::UMUL: {
+		if(!getVal(lhs, res)) return false;
+		if(!wantaddr) res = emitLoad(res, stmt->getTy(true));
+		return true;
+	}
+	default: break;
+	}
+
+	bool primitive =
+	lhs->getTy()->isPrimitiveOrPtr() && (!rhs || rhs->getTy()->isPrimitiveOrPtr());
+	if(!primitive && stmt->getCalledFn()) {
+		FuncTy *fty    = stmt->getCalledFn();
+		StringRef name = getMangledName(stmt->getOper().getTok().getOperCStr(), fty);
+		Vector<Stmt *> args = {lhs};
+		if(rhs) args.push_back(rhs);
+		return getCall(stmt, nullptr, fty, name, args, res, wantaddr);
+	}
+
+	switch(oper) {
+	case lex::SUBS: {
+		Type *lty = getValTy(lhs);
+		if(!lty->isPtr()) return unsupported(stmt, "subscript on: ", lty->toStr());
+		Type *ety = getElemTy(lty);
+		uint64_t esz, ealign;
+		uint32_t base, idx;
+		if(!getLayout(stmt, ety, esz, ealign)) return false;
+		if(!getVal(lhs, base) || !getVal(rhs, idx)) return false;
+		if(esz != 1) idx = emitBinOp(lex::MUL, idx, emitImm(esz), true);
+		res = emitBinOp(lex::ADD, base, idx, false);
+		if(!wantaddr) res = emitLoad(res, ety);
+		return true;
+	}
+	case lex::ASSN: return getAssn(stmt, res, wantaddr);
+	case lex::ADD_ASSN:
+	case lex::SUB_ASSN:
+	case lex::MUL_ASSN:
+	case lex::DIV_ASSN:
+	case lex::MOD_ASSN:
+	case lex::BAND_ASSN:
+	case lex::BOR_ASSN:
+	case lex::BXOR_ASSN:
+	case lex::LSHIFT_ASSN:
+	case lex::RSHIFT_ASSN: return getAssn(stmt, res, wantaddr);
+	case lex::XINC:
+	case lex::INCX:
+	case lex::XDEC:
+	case lex::DECX: return getIncDec(stmt, res);
+	case lex::LAND:
+	case lex::LOR: return getLogical(stmt, res);
+	case lex::UADD:
+	case lex::USUB:
+	case lex::BNOT: {
+		Type *lty = getValTy(lhs);
+		if(!getVal(lhs, res)) return false;
+		Type *pty = getPromotedTy(lty);
+		res	  = convert(res, lty, pty);
+		if(oper == lex::UADD) return true;
+		res = normalize(emitUnOp(oper, res), pty);
+		return true;
+	}
+	case lex::LNOT: {
+		if(!getVal(lhs, res)) return false;
+		res = emitUnOp(oper, res);
+		return true;
+	}
+	case lex::ADD:
+	case lex::SUB:
+	case lex::MUL:
+	case lex::DIV:
+	case lex::MOD:
+	case lex::EQ:
+	case lex::LT:
+	case lex::GT:
+	case lex::LE:
+	case lex::GE:
+	case lex::NE:
+	case lex::BAND:
+	case lex::BOR:
+	case lex::BXOR:
+	case lex::LSHIFT:
+	case lex::RSHIFT: {
+		uint32_t l, r;
+		Type *resty;
+		if(!getVal(lhs, l) || !getVal(rhs, r)) return false;
+		return getArith(stmt, oper, l, getValTy(lhs), r, getValTy(rhs), res, resty);
+	}
+	default: break;
+	}
+	return unsupported(stmt, "operator: ", lex::TokStrs[oper]);
+}
+bool IRBuilder::getCall(Stmt *stmt, Stmt *callee, FuncTy *fty, StringRef calleename,
+			const Vector<Stmt *> &args, uint32_t &res, bool wantaddr)
+{
+	if(fty->isIntrinsic()) return unsupported(stmt, "intrinsic call in code generation");
+	IRInstr call(CALL);
+	Sym *sym = calleename.empty() ? nullptr : lookup(calleename);
+	bool is_c = false;
+	if(sym && (sym->kind == SFUNC || sym->kind == SEXTFN)) {
+		call.name     = sym->name;
+		is_c	      = sym->kind == SEXTFN;
+		call.variadic = is_c && fty->isVariadic();
+	} else if(sym && sym->kind == SCMACRO) {
+		// helpers in the C prelude have no symbol either
+		if(sym->name == "_sc_mum") return getMum(stmt, args, res);
+		return unsupported(stmt, "use of C macro: ", sym->name);
+	} else if(callee) {
+		// function pointer
+		uint32_t fptr;
+		if(!getVal(callee, fptr)) return false;
+		call.indirect = true;
+		call.args.push_back(fptr);
+	} else {
+		return unsupported(stmt, "unknown function: ", calleename);
+	}
+
+	StmtFnSig *sig = fty->getSig();
+	Type *rt       = fty->getRet();
+	bool ref       = sig && sig->getRetType()->isRef();
+	bool memret    = !ref && isAggregate(rt);
+	uint32_t tmp   = 0;
+	if(memret) {
+		if(is_c) return unsupported(stmt, "C function returning aggregate: ", calleename);
+		uint64_t size, align;
+		if(!getLayout(stmt, rt, size, align)) return false;
+		tmp = emitVar(size, align);
+		call.args.push_back(tmp);
+	}
+	for(size_t i = 0; i < args.size(); ++i) {
+		Stmt *a	    = args[i];
+		Type *at    = fty->getArg(i);
+		bool argref = sig && i < sig->getArgs().size() && sig->getArg(i)->isRef();
+		uint32_t v;
+		if(argref) {
+			if(!getAddr(a, v)) return false;
+			call.args.push_back(v);
+			continue;
+		}
+		if(!getVal(a, v)) return false;
+		Type *vty = getValTy(a);
+		if(vty->isFlt()) return unsupported(a, "floating point argument");
+		if(isAggregate(vty) && vty->isStruct()) {
+			if(is_c) return unsupported(a, "aggregate argument to C function");
+			uint64_t size, align;
+			if(!getLayout(a, vty, size, align)) return false;
+			uint32_t cpy = emitVar(size, align);
+			emitCopy(cpy, v, size);
+			v = cpy;
+		} else if(at && !at->isVariadic() && !at->isAny()) {
+			v = convert(v, vty, at);
+		}
+		call.args.push_back(v);
+	}
+	bool hasres = memret || ref || !rt->isVoid();
+	if(!memret && !ref && rt->isFlt()) return unsupported(stmt, "floating point return");
+	res = addInstr(std::move(call), hasres);
+	if(memret) {
+		res = tmp;
+		return true;
+	}
+	if(ref) {
+		if(!wantaddr) res = emitLoad(res, rt);
+		return true;
+	}
+	if(hasres) res = normalize(res, rt);
+	if(wantaddr) {
+		uint64_t size, align;
+		if(!getLayout(stmt, rt, size, align)) return false;
+		uint32_t loc = emitVar(size, align);
+		emitStore(loc, res, rt);
+		res = loc;
+	}
+	return true;
+}
+// _sc_mum(u64 *a, u64 *b) from the C prelude: *a, *b = low, high half of *a * *b
+bool IRBuilder::getMum(Stmt *stmt, const Vector<Stmt *> &args, uint32_t &res)
+{
+	if(args.size() != 2) return unsupported(stmt, "call to _sc_mum with ", args.size(), " args");
+	uint32_t pa, pb;
+	if(!getVal(args[0], pa) || !getVal(args[1], pb)) return false;
+	Type *ty   = getElemTy(getValTy(args[0]));
+	uint32_t a = emitLoad(pa, ty);
+	uint32_t b = emitLoad(pb, ty);
+	emitStore(pa, emitBinOp(lex::MUL, a, b, false), ty);
+	emitStore(pb, emitMulHi(a, b), ty);
+	res = 0;
+	return true;
+}
+bool IRBuilder::getStructInit(StmtExpr *stmt, uint32_t &res)
+{
+	Type *t = stmt->getLHS()->getTy();
+	if(!t->isStruct()) return unsupported(stmt, "struct init of non struct: ", t->toStr());
+	StructTy *st = as<StructTy>(t);
+	uint64_t size, align;
+	if(!getLayout(stmt, st, size, align)) return false;
+	res		     = emitVar(size, align);
+	Vector<Stmt *> &args = as<StmtFnCallInfo>(stmt->getRHS())->getArgs();
+	for(size_t i = 0; i < args.size() && i < st->getFields().size(); ++i) {
+		uint64_t offset;
+		Type *fty;
+		uint32_t v;
+		if(!getFieldOffset(stmt, st, st->getFieldName(i), offset, fty)) return false;
+		if(!getVal(args[i], v)) return false;
+		uint32_t addr = emitDot(res, offset);
+		if(isAggregate(fty)) {
+			uint64_t fsz, falign;
+			if(!getLayout(stmt, fty, fsz, falign)) return false;
+			emitCopy(addr, v, fsz);
+			continue;
+		}
+		emitStore(addr, convert(v, getValTy(args[i]), fty), fty);
+	}
+	return true;
+}
+bool IRBuilder::getArith(Stmt *stmt, lex::TokType oper, uint32_t lhs, Type *lty, uint32_t rhs,
+			 Type *rty, uint32_t &res, Type *&resty)
+{
+	if(lty->isFlt() || rty->isFlt()) return unsupported(stmt, "floating point arithmetic");
+	bool is_cmp = oper == lex::EQ || oper == lex::LT || oper == lex::GT || oper == lex::LE ||
+		      oper == lex::GE || oper == lex::NE;
+	// pointer arithmetic
+	if((oper == lex::ADD || oper == lex::SUB) && (lty->isPtr() || rty->isPtr())) {
+		if(oper == lex::ADD && rty->isPtr()) {
+			std::swap(lhs, rhs);
+			std::swap(lty, rty);
+		}
+		uint64_t esz, ealign;
+		if(!getLayout(stmt, getElemTy(lty), esz, ealign)) return false;
+		if(rty->isPtr()) {
+			// ptr - ptr
+			res = emitBinOp(lex::SUB, lhs, rhs, true);
+			if(esz != 1) res = emitBinOp(lex::DIV, res, emitImm(esz), true);
+			resty = IntTy::get(ctx, 64, true);
+			return true;
+		}
+		if(esz != 1) rhs = emitBinOp(lex::MUL, rhs, emitImm(esz), true);
+		res   = emitBinOp(oper, lhs, rhs, false);
+		resty = lty;
+		return true;
+	}
+	Type *cty;
+	if(oper == lex::LSHIFT || oper == lex::RSHIFT) cty = getPromotedTy(lty);
+	else cty = getCommonTy(lty, rty);
+	bool sign = as<IntTy>(cty)->isSigned();
+	lhs	  = convert(lhs, lty, cty);
+	if(oper != lex::LSHIFT && oper != lex::RSHIFT) rhs = convert(rhs, rty, cty);
+	res = emitBinOp(oper, lhs, rhs, sign);
+	if(is_cmp) {
+		resty = IntTy::get(ctx, 32, true);
+		return true;
+	}
+	resty = cty;
+	if(oper == lex::ADD || oper == lex::SUB || oper == lex::MUL || oper == lex::LSHIFT) {
+		res = normalize(res, cty);
+	}
+	return true;
+}
+bool IRBuilder::getLogical(StmtExpr *stmt, uint32_t &res)
+{
+	bool is_and	  = stmt->getOper().getTokVal() == lex::LAND;
+	Type *i32	  = IntTy::get(ctx, 32, true);
+	uint32_t tmp	  = emitVar(4, 4);
+	uint32_t shortblk = newBlk();
+	uint32_t endblk	  = newBlk();
+	uint32_t l, r;
+	if(!getVal(stmt->getLHS(), l)) return false;
+	emitJmp(is_and ? JMPFALSE : JMPTRUE, shortblk, l);
+	if(!getVal(stmt->getRHS(), r)) return false;
+	emitJmp(is_and ? JMPFALSE : JMPTRUE, shortblk, r);
+	emitStore(tmp, emitImm(is_and), i32);
+	emitJmp(JMP, endblk, 0);
+	emitBlk(shortblk);
+	emitStore(tmp, emitImm(!is_and), i32);
+	emitJmp(JMP, endblk, 0);
+	emitBlk(endblk);
+	res = emitLoad(tmp, i32);
+	return true;
+}
+bool IRBuilder::getIncDec(StmtExpr *stmt, uint32_t &res)
+{
+	lex::TokType oper = stmt->getOper().getTokVal();
+	Stmt *lhs	  = stmt->getLHS();
+	Type *lty	  = getValTy(lhs);
+	uint32_t addr;
+	if(lty->isFlt()) return unsupported(stmt, "floating point arithmetic");
+	if(!getAddr(lhs, addr)) return false;
+	uint32_t old = emitLoad(addr, lty);
+	uint64_t step = 1, align;
+	if(lty->isPtr() && !getLayout(stmt, getElemTy(lty), step, align)) return false;
+	bool inc     = oper == lex::XINC || oper == lex::INCX;
+	uint32_t nw  = emitBinOp(inc ? lex::ADD : lex::SUB, old, emitImm(step), false);
+	nw	     = convert(nw, IntTy::get(ctx, 64, true), lty);
+	emitStore(addr, nw, lty);
+	res = (oper == lex::INCX || oper == lex::DECX) ? nw : old;
+	return true;
+}
+bool IRBuilder::getAssn(StmtExpr *stmt, uint32_t &res, bool wantaddr)
+{
+	lex::TokType oper = stmt->getOper().getTokVal();
+	Stmt *lhs	  = stmt->getLHS();
+	Stmt *rhs	  = stmt->getRHS();
+	uint32_t addr, v;
+	// chained assignments are parsed as ((a = b) = c) but mean a = (b = c), like in C
+	if(oper == lex::ASSN && lhs->isExpr() &&
+	   as<StmtExpr>(lhs)->getOper().getTokVal() == lex::ASSN)
+	{
+		if(!getVal(rhs, v)) return false;
+		return getChainAssn(lhs, v, getValTy(rhs), res, wantaddr);
+	}
+	Type *lty = getValTy(lhs);
+	Type *rty = getValTy(rhs);
+	if(!getAddr(lhs, addr) || !getVal(rhs, v)) return false;
+	if(isAggregate(lty)) {
+		if(oper != lex::ASSN) return unsupported(stmt, "arithmetic on aggregates");
+		uint64_t size, align;
+		if(!getLayout(stmt, lty, size, align)) return false;
+		emitCopy(addr, v, size);
+		res = addr;
+		return true;
+	}
+	if(oper != lex::ASSN) {
+		lex::TokType binop;
+		switch(oper) {
+		case lex::ADD_ASSN: binop = lex::ADD; break;
+		case lex::SUB_ASSN: binop = lex::SUB; break;
+		case lex::MUL_ASSN: binop = lex::MUL; break;
+		case lex::DIV_ASSN: binop = lex::DIV; break;
+		case lex::MOD_ASSN: binop = lex::MOD; break;
+		case lex::BAND_ASSN: binop = lex::BAND; break;
+		case lex::BOR_ASSN: binop = lex::BOR; break;
+		case lex::BXOR_ASSN: binop = lex::BXOR; break;
+		case lex::LSHIFT_ASSN: binop = lex::LSHIFT; break;
+		case lex::RSHIFT_ASSN: binop = lex::RSHIFT; break;
+		default: return unsupported(stmt, "operator: ", lex::TokStrs[oper]);
+		}
+		uint32_t old = emitLoad(addr, lty);
+		if(!getArith(stmt, binop, old, lty, v, rty, v, rty)) return false;
+	}
+	v = convert(v, rty, lty);
+	emitStore(addr, v, lty);
+	res = wantaddr ? addr : v;
+	return true;
+}
+
+bool IRBuilder::getChainAssn(Stmt *target, uint32_t val, Type *valty, uint32_t &res,
+			     bool wantaddr)
+{
+	if(target->isExpr() && as<StmtExpr>(target)->getOper().getTokVal() == lex::ASSN) {
+		StmtExpr *expr = as<StmtExpr>(target);
+		uint32_t inner;
+		if(!getChainAssn(expr->getRHS(), val, valty, inner, false)) return false;
+		return getChainAssn(expr->getLHS(), inner, getValTy(expr->getRHS()), res, wantaddr);
+	}
+	Type *ty = getValTy(target);
+	uint32_t addr;
+	if(!getAddr(target, addr)) return false;
+	if(isAggregate(ty)) {
+		uint64_t size, align;
+		if(!getLayout(target, ty, size, align)) return false;
+		emitCopy(addr, val, size);
+		res = addr;
+		return true;
+	}
+	val = convert(val, valty, ty);
+	emitStore(addr, val, ty);
+	res = wantaddr ? addr : val;
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////// Statements ////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool IRBuilder::visitTop(Stmt *stmt, bool declare)
+{
+	switch(stmt->getStmtType()) {
+	case BLOCK:
+		for(auto &s : as<StmtBlock>(stmt)->getStmts()) {
+			if(!visitTop(s, declare)) return false;
+		}
+		return true;
+	case VARDECL:
+		for(auto &d : as<StmtVarDecl>(stmt)->getDecls()) {
+			if(!visitTopVar(d, declare)) return false;
+		}
+		return true;
+	case VAR: return visitTopVar(as<StmtVar>(stmt), declare);
+	case COND:
+		if(!as<StmtCond>(stmt)->isInline()) break;
+		if(as<StmtCond>(stmt)->getConditionals().empty()) return true;
+		return visitTop(as<StmtCond>(stmt)->getConditionals().back().getBlk(), declare);
+	case HEADER:
+	case LIB:
+	case STRUCTDEF: return true;
+	case EXTERN: return declare ? visitExtern(as<StmtExtern>(stmt)) : true;
+	default: break;
+	}
+	return unsupported(stmt, "global statement: ", stmt->getStmtTypeCString());
+}
+bool IRBuilder::visitTopVar(StmtVar *stmt, bool declare)
+{
+	StringRef name = getSymName(stmt);
+	Stmt *vval     = stmt->getVVal();
+	if(vval && vval->isExtern()) {
+		if(!declare) return true;
+		StmtExtern *ext = as<StmtExtern>(vval);
+		Stmt *ent	= ext->getEntity();
+		if(ent && ent->isStructDef()) return true;
+		StringRef extname = ext->getName().getDataStr();
+		Type *t		  = stmt->getTy(true);
+		bool isfn	  = ent && ent->isFnSig();
+		bool variadic	  = isfn && t->isFunc() && as<FuncTy>(t)->isVariadic();
+		StmtLib *lib	  = ext->getLibs();
+		bool haslib	  = lib && !lib->getFlags().getDataStr().empty();
+		if(!(isfn && haslib) && !isLinkableSymbol(extname)) {
+			addSym(name, {SCMACRO, extname, 0, t, variadic});
+			return true;
+		}
+		addSym(name, {isfn ? SEXTFN : SEXTVAR, extname, 0, t, variadic});
+		mod.externs.insert(extname);
+		return visitExtern(ext);
+	}
+	if(vval && vval->isFnDef()) {
+		if(declare) {
+			addSym(name, {SFUNC, name, 0, stmt->getTy(true), false});
+			return true;
+		}
+		if(!as<StmtFnDef>(vval)->getBlk()) return true;
+		return visitFunc(name, as<StmtFnDef>(vval));
+	}
+	if(vval && vval->isStructDef()) return true;
+	if(vval && stmt->getVal() && stmt->getVal()->hasData()) {
+		if(stmt->getVal()->isType()) return true;
+		if(stmt->getVal()->isFunc()) {
+			if(!declare) return true;
+			if(!vval->isSimple()) return unsupported(stmt, "function alias");
+			addSym(name, {SALIAS, getSymName(as<StmtSimple>(vval)), 0, nullptr, false});
+			return true;
+		}
+	}
+	if(vval && vval->isSimple()) {
+		StmtSimple *sim = as<StmtSimple>(vval);
+		if(sim->getDecl() && sim->getDecl()->getVVal() &&
+		   sim->getDecl()->getVVal()->isExtern())
+		{
+			if(declare) addSym(name, {SALIAS, getSymName(sim), 0, nullptr, false});
+			return true;
+		}
+	}
+	if(stmt->isRef()) return unsupported(stmt, "global reference");
+	Type *t = stmt->getCast() ? stmt->getCast() : stmt->getTy(true);
+	if(declare) {
+		addSym(name, {SGLOBAL, name, 0, t, false});
+		return true;
+	}
+	uint64_t size, align;
+	if(!getLayout(stmt, t, size, align)) return false;
+	IRGlobal g;
+	g.name	= name;
+	g.align = align;
+	g.data.resize(size, 0);
+	if(vval && !writeConstInit(stmt, g, vval, t)) return false;
+	mod.globals.push_back(std::move(g));
+	return true;
+}
+bool IRBuilder::visitFunc(StringRef name, StmtFnDef *stmt)
+{
+	mod.funcs.emplace_back(name, name == "main");
+	fn	      = &mod.funcs.back();
+	fn->inlinable = stmt->isInline();
+	if(name == "main") mod.entry = name;
+	scopes.emplace_back();
+	emitBlk(newBlk());
+
+	StmtType *sigret = stmt->getSigRetType();
+	retty		 = sigret->getTy();
+	retref		 = sigret->isRef();
+	retptr		 = 0;
+	uint32_t argidx	 = 0;
+	if(!retref && isAggregate(retty)) retptr = emitArg(argidx++);
+	if(!retref && retty->isFlt()) return unsupported(stmt, "floating point return");
+	// fetch all the arguments before anything else so that the emitter
+	// can read them directly from the argument registers
+	Vector<uint32_t> argregs;
+	for(size_t i = 0; i < stmt->getSigArgs().size(); ++i) argregs.push_back(emitArg(argidx++));
+	for(size_t i = 0; i < stmt->getSigArgs().size(); ++i) {
+		StmtVar *a	= stmt->getSigArgs()[i];
+		StringRef aname = getSymName(a);
+		Type *t		= a->getTy(true);
+		uint32_t v	= argregs[i];
+		if(a->isRef() || isAggregate(t)) {
+			addSym(aname, {SLOCAL, aname, v, t, false});
+			continue;
+		}
+		uint64_t size, align;
+		if(!getLayout(a, t, size, align)) return false;
+		uint32_t slot = emitVar(size, align);
+		emitStore(slot, v, t);
+		addSym(aname, {SLOCAL, aname, slot, t, false});
+	}
+	if(!visit(stmt->getBlk())) return false;
+	if(fn->instrs.empty() || fn->instrs.back().ty != RETURN) {
+		IRInstr ret(RETURN);
+		if(name == "main" || (!retref && !retty->isVoid() && !isAggregate(retty))) {
+			ret.args.push_back(emitImm(0));
+		}
+		addInstr(std::move(ret), false);
+	}
+	scopes.pop_back();
+	fn = nullptr;
+	return true;
+}
+bool IRBuilder::visitExtern(StmtExtern *stmt)
+{
+	StmtLib *lib = stmt->getLibs();
+	if(!lib || lib->getFlags().getDataStr().empty()) return true;
+	for(auto &l : libflags) {
+		if(l == lib->getFlags().getDataStr()) return true;
+	}
+	libflags.push_back(lib->getFlags().getDataStr());
+	return true;
+}
+
+bool IRBuilder::visit(Stmt *stmt)
+{
+	uint32_t res;
+	switch(stmt->getStmtType()) {
+	case BLOCK: return visit(as<StmtBlock>(stmt));
+	case SIMPLE:
+	case EXPR: return getRawVal(stmt, res);
+	case FNCALLINFO: return true;
+	case VAR: return visit(as<StmtVar>(stmt));
+	case VARDECL: return visit(as<StmtVarDecl>(stmt));
+	case COND: return visit(as<StmtCond>(stmt));
+	case FOR: return visit(as<StmtFor>(stmt));
+	case RET: return visit(as<StmtRet>(stmt));
+	case CONTINUE:
+		if(loops.empty()) return unsupported(stmt, "continue outside loop");
+		emitJmp(JMP, loops.back().continueblk, 0);
+		emitBlk(newBlk());
+		return true;
+	case BREAK:
+		if(loops.empty()) return unsupported(stmt, "break outside loop");
+		emitJmp(JMP, loops.back().breakblk, 0);
+		emitBlk(newBlk());
+		return true;
+	case HEADER:
+	case LIB:
+	case STRUCTDEF: return true;
+	case EXTERN: return visitExtern(as<StmtExtern>(stmt));
+	default: break;
+	}
+	return unsupported(stmt, "statement: ", stmt->getStmtTypeCString());
+}
+bool IRBuilder::visit(StmtBlock *stmt)
+{
+	scopes.emplace_back();
+	for(auto &s : stmt->getStmts()) {
+		if(!visit(s)) return false;
+	}
+	scopes.pop_back();
+	return true;
+}
+bool IRBuilder::visit(StmtVar *stmt)
+{
+	StringRef name = getSymName(stmt);
+	Stmt *vval     = stmt->getVVal();
+	if(vval && (vval->isExtern() || vval->isStructDef())) return visitTopVar(stmt, true);
+	if(vval && vval->isFnDef()) return unsupported(stmt, "nested function definition");
+	Type *t = stmt->getCast() ? stmt->getCast() : stmt->getTy(true);
+	if(vval && stmt->getVal() && stmt->getVal()->hasData()) {
+		if(stmt->getVal()->isType()) return true;
+		if(stmt->getVal()->isFunc()) {
+			if(!vval->isSimple()) return unsupported(stmt, "function alias");
+			addSym(name, {SALIAS, getSymName(as<StmtSimple>(vval)), 0, nullptr, false});
+			return true;
+		}
+		uint64_t size, align;
+		uint32_t v;
+		if(!getLayout(stmt, t, size, align)) return false;
+		if(!getConstVal(stmt, stmt->getVal(), t, v)) return false;
+		uint32_t slot = emitVar(size, align);
+		if(isAggregate(t)) emitCopy(slot, v, size);
+		else emitStore(slot, v, t);
+		addSym(name, {SLOCAL, name, slot, t, false});
+		return true;
+	}
+	if(vval && vval->isSimple()) {
+		StmtSimple *sim = as<StmtSimple>(vval);
+		if(sim->getDecl() && sim->getDecl()->getVVal() &&
+		   sim->getDecl()->getVVal()->isExtern())
+		{
+			addSym(name, {SALIAS, getSymName(sim), 0, nullptr, false});
+			return true;
+		}
+	}
+	if(stmt->isStatic()) {
+		uint64_t size, align;
+		if(!getLayout(stmt, t, size, align)) return false;
+		IRGlobal g;
+		g.name	= getAnonName(name);
+		g.align = align;
+		g.data.resize(size, 0);
+		if(vval && !writeConstInit(stmt, g, vval, t)) return false;
+		mod.globals.push_back(std::move(g));
+		addSym(name, {SGLOBAL, mod.globals.back().name, 0, t, false});
+		return true;
+	}
+	if(stmt->isRef()) {
+		uint32_t addr;
+		if(!vval) return unsupported(stmt, "reference without value");
+		if(!getAddr(vval, addr)) return false;
+		addSym(name, {SLOCAL, name, addr, t, false});
+		return true;
+	}
+	uint64_t size, align;
+	if(!getLayout(stmt, t, size, align)) return false;
+	uint32_t v    = 0;
+	uint32_t slot = 0;
+	// evaluate the value before adding the symbol as it may shadow an existing one
+	if(vval && !getVal(vval, v)) return false;
+	slot = emitVar(size, align);
+	if(vval) {
+		if(isAggregate(t)) emitCopy(slot, v, size);
+		else emitStore(slot, convert(v, getValTy(vval), t), t);
+	}
+	addSym(name, {SLOCAL, name, slot, t, false});
+	return true;
+}
+bool IRBuilder::visit(StmtVarDecl *stmt)
+{
+	for(auto &d : stmt->getDecls()) {
+		if(!visit(d)) return false;
+	}
+	return true;
+}
+bool IRBuilder::visit(StmtCond *stmt)
+{
+	if(stmt->isInline()) {
+		if(stmt->getConditionals().empty()) return true;
+		return visit(stmt->getConditionals().back().getBlk());
+	}
+	uint32_t endblk = newBlk();
+	for(auto &c : stmt->getConditionals()) {
+		uint32_t nextblk = newBlk();
+		if(c.getCond()) {
+			uint32_t cond;
+			if(!getVal(c.getCond(), cond)) return false;
+			emitJmp(JMPFALSE, nextblk, cond);
+		}
+		if(!visit(c.getBlk())) return false;
+		emitJmp(JMP, endblk, 0);
+		emitBlk(nextblk);
+	}
+	emitJmp(JMP, endblk, 0);
+	emitBlk(endblk);
+	return true;
+}
+bool IRBuilder::visit(StmtFor *stmt)
+{
+	if(stmt->isInline()) return visit(stmt->getBlk());
+	scopes.emplace_back();
+	if(stmt->getInit() && !visit(stmt->getInit())) return false;
+	uint32_t condblk = newBlk();
+	uint32_t incrblk = newBlk();
+	uint32_t endblk	 = newBlk();
+	emitJmp(JMP, condblk, 0);
+	emitBlk(condblk);
+	if(stmt->getCond()) {
+		uint32_t cond;
+		if(!getVal(stmt->getCond(), cond)) return false;
+		emitJmp(JMPFALSE, endblk, cond);
+	}
+	loops.push_back({incrblk, endblk});
+	if(!visit(stmt->getBlk())) return false;
+	loops.pop_back();
+	emitJmp(JMP, incrblk, 0);
+	emitBlk(incrblk);
+	uint32_t res;
+	if(stmt->getIncr() && !getRawVal(stmt->getIncr(), res)) return false;
+	emitJmp(JMP, condblk, 0);
+	emitBlk(endblk);
+	scopes.pop_back();
+	return true;
+}
+bool IRBuilder::visit(StmtRet *stmt)
+{
+	Stmt *val = stmt->getRetVal();
+	uint32_t v;
+	if(!val) {
+		emitRet(0);
+		return true;
+	}
+	if(retref) {
+		if(!getAddr(val, v)) return false;
+		emitRet(v);
+		return true;
+	}
+	if(!getVal(val, v)) return false;
+	if(retptr) {
+		uint64_t size, align;
+		if(!getLayout(stmt, retty, size, align)) return false;
+		emitCopy(retptr, v, size);
+		emitRet(retptr);
+		return true;
+	}
+	emitRet(convert(v, getValTy(val), retty));
+	return true;
+}
+} // namespace sc
@@ -0,0 +1,512 @@
+#include "CodeGen/IROpt.hpp"
+
+#include <algorithm>
+
+namespace sc
+{
+// functions with at most these many instructions are inlined
+static constexpr size_t INLINE_MAX_SMALL = 12;
+static constexpr size_t INLINE_MAX	 = 64;
+
+static bool isTerminator(const IRInstr &i) { return i.ty == JMP || i.ty == RETURN; }
+static bool isJmp(const IRInstr &i)
+{
+	return i.ty == JMP || i.ty == JMPTRUE || i.ty == JMPFALSE;
+}
+// instructions which can be removed if their result is not used
+static bool isPure(const IRInstr &i)
+{
+	switch(i.ty) {
+	case IMM:
+	case ARG:
+	case ADDR:
+	case CREATEVAR:
+	case LOAD:
+	case DOT:
+	case CAST:
+	case BINOP:
+	case UNOP:
+	case MULHI: return true;
+	default: break;
+	}
+	return false;
+}
+static int64_t castInt(int64_t val, uint16_t bits, bool sign)
+{
+	switch(bits) {
+	case 1: return val != 0;
+	case 8: return sign ? (int64_t)(int8_t)val : (int64_t)(uint8_t)val;
+	case 16: return sign ? (int64_t)(int16_t)val : (int64_t)(uint16_t)val;
+	case 32: return sign ? (int64_t)(int32_t)val : (int64_t)(uint32_t)val;
+	default: break;
+	}
+	return val;
+}
+static bool foldBinOp(lex::TokType oper, bool sign, int64_t l, int64_t r, int64_t &res)
+{
+	uint64_t ul = l, ur = r;
+	switch(oper) {
+	case lex::ADD: res = ul + ur; return true;
+	case lex::SUB: res = ul - ur; return true;
+	case lex::MUL: res = ul * ur; return true;
+	case lex::DIV:
+	case lex::MOD:
+		if(r == 0 || (sign && l == INT64_MIN && r == -1)) return false;
+		if(oper == lex::DIV) res = sign ? l / r : (int64_t)(ul / ur);
+		else res = sign ? l % r : (int64_t)(ul % ur);
+		return true;
+	case lex::BAND: res = l & r; return true;
+	case lex::BOR: res = l | r; return true;
+	case lex::BXOR: res = l ^ r; return true;
+	case lex::LSHIFT: res = ul << (ur & 63); return true;
+	case lex::RSHIFT: res = sign ? l >> (ur & 63) : (int64_t)(ul >> (ur & 63)); return true;
+	case lex::EQ: res = l == r; return true;
+	case lex::NE: res = l != r; return true;
+	case lex::LT: res = sign ? l < r : ul < ur; return true;
+	case lex::LE: res = sign ? l <= r : ul <= ur; return true;
+	case lex::GT: res = sign ? l > r : ul > ur; return true;
+	case lex::GE: res = sign ? l >= r : ul >= ur; return true;
+	default: break;
+	}
+	return false;
+}
+static bool foldUnOp(lex::TokType oper, int64_t val, int64_t &res)
+{
+	switch(oper) {
+	case lex::USUB: res = -(uint64_t)val; return true;
+	case lex::BNOT: res = ~val; return true;
+	case lex::LNOT: res = val == 0; return true;
+	default: break;
+	}
+	return false;
+}
+static void setImm(IRInstr &i, int64_t val)
+{
+	i.ty  = IMM;
+	i.imm = val;
+	i.args.clear();
+}
+// registers of slots (CREATEVAR) whose address is only used to load from/store to them
+static Vector<bool> getLocalSlots(const IRFunc &f)
+{
+	Vector<bool> local(f.regcount, false);
+	for(auto &i : f.instrs) {
+		if(i.ty == CREATEVAR) local[i.res] = true;
+	}
+	for(auto &i : f.instrs) {
+		for(size_t a = 0; a < i.args.size(); ++a) {
+			if(a == 0 && (i.ty == LOAD || i.ty == STORE)) continue;
+			local[i.args[a]] = false;
+		}
+	}
+	return local;
+}
+
+IROptimizer::IROptimizer(IRModule &mod) : mod(mod), inlinecount(0), removedinstrs(0) {}
+
+void IROptimizer::optimize()
+{
+	for(auto &f : mod.funcs) funcs[f.name] = &f;
+	for(auto &f : mod.funcs) simplify(f);
+	// callees are (mostly) defined before callers, so they are already inlined into
+	for(auto &f : mod.funcs) {
+		if(inlineCalls(f)) simplify(f);
+	}
+	funcs.clear();
+	removeUnused();
+	for(auto &f : mod.funcs) compactRegisters(f);
+}
+
+size_t IROptimizer::sweep(IRFunc &f)
+{
+	size_t before = f.instrs.size();
+	f.instrs.erase(std::remove_if(f.instrs.begin(), f.instrs.end(),
+				      [](const IRInstr &i) { return i.ty == INVALID; }),
+		       f.instrs.end());
+	removedinstrs += before - f.instrs.size();
+	return before - f.instrs.size();
+}
+
+void IROptimizer::simplify(IRFunc &f)
+{
+	for(size_t i = 0; i < 8; ++i) {
+		bool changed = forwardStores(f);
+		changed |= propagateConstants(f);
+		changed |= removeUnreachable(f);
+		changed |= eliminateDeadCode(f);
+		if(!changed) break;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////// Inlining ////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool IROptimizer::shouldInline(IRFunc &caller, const IRInstr &call, IRFunc *&callee)
+{
+	if(call.indirect || call.variadic) return false;
+	auto loc = funcs.find(call.name);
+	if(loc == funcs.end() || loc->second == &caller) return false;
+	callee = loc->second;
+	size_t count = 0;
+	for(auto &i : callee->instrs) {
+		if(i.ty == BASICBLOCK) continue;
+		if(i.ty == CALL && i.name == callee->name) return false; // recursive
+		if(i.ty == ARG && i.blk >= call.args.size()) return false;
+		if(i.ty == RETURN && i.args.empty() && call.res) return false;
+		++count;
+	}
+	return count <= (callee->inlinable ? INLINE_MAX : INLINE_MAX_SMALL);
+}
+void IROptimizer::inlineCall(IRFunc &f, const IRInstr &call, const IRFunc &callee,
+			     Vector<IRInstr> &out)
+{
+	// callee register r becomes r + regoff, block b becomes b + blkoff
+	uint32_t regoff = f.regcount - 1;
+	uint32_t blkoff = f.blkcount;
+	uint32_t endblk = blkoff + callee.blkcount;
+	f.regcount += callee.regcount - 1;
+	f.blkcount = endblk + 1;
+
+	size_t rets = 0;
+	for(auto &i : callee.instrs) rets += i.ty == RETURN;
+	// single return at the end - no need for a return slot or jumps
+	bool single	 = rets == 1 && callee.instrs.back().ty == RETURN;
+	uint32_t retslot = 0;
+	if(!single && call.res) {
+		IRInstr var(CREATEVAR);
+		var.res	 = f.regcount++;
+		var.imm	 = 8;
+		var.bits = 8;
+		retslot	 = var.res;
+		out.push_back(std::move(var));
+	}
+	Map<uint32_t, uint32_t> argmap; // callee ARG register -> caller register
+	for(auto &ci : callee.instrs) {
+		if(ci.ty == ARG) {
+			argmap[ci.res] = call.args[ci.blk];
+			continue;
+		}
+		IRInstr i = ci;
+		if(i.res) i.res += regoff;
+		for(auto &a : i.args) {
+			auto loc = argmap.find(a);
+			a	 = loc != argmap.end() ? loc->second : a + regoff;
+		}
+		if(i.ty == BASICBLOCK || isJmp(i)) i.blk += blkoff;
+		if(i.ty != RETURN) {
+			out.push_back(std::move(i));
+			continue;
+		}
+		if(single) {
+			if(!call.res) continue;
+			IRInstr cpy(CAST);
+			cpy.res	 = call.res;
+			cpy.bits = 64;
+			cpy.args = {i.args[0]};
+			out.push_back(std::move(cpy));
+			continue;
+		}
+		if(call.res) {
+			IRInstr st(STORE);
+			st.bits = 64;
+			st.args = {retslot, i.args[0]};
+			out.push_back(std::move(st));
+		}
+		IRInstr jmp(JMP);
+		jmp.blk = endblk;
+		out.push_back(std::move(jmp));
+	}
+	if(single) return;
+	IRInstr blk(BASICBLOCK);
+	blk.blk = endblk;
+	out.push_back(std::move(blk));
+	if(!call.res) return;
+	IRInstr ld(LOAD);
+	ld.res	= call.res;
+	ld.bits = 64;
+	ld.args = {retslot};
+	out.push_back(std::move(ld));
+}
+bool IROptimizer::inlineCalls(IRFunc &f)
+{
+	Vector<IRInstr> res;
+	bool changed = false;
+	for(auto &i : f.instrs) {
+		IRFunc *callee;
+		if(i.ty != CALL || !shouldInline(f, i, callee)) {
+			res.push_back(std::move(i));
+			continue;
+		}
+		inlineCall(f, i, *callee, res);
+		++inlinecount;
+		changed = true;
+	}
+	f.instrs = std::move(res);
+	return changed;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////// Constant Propagation /////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool IROptimizer::forwardStores(IRFunc &f)
+{
+	Vector<bool> local = getLocalSlots(f);
+	bool changed	   = false;
+
+	// slots with a single store of a constant, which happens before any load
+	Vector<uint32_t> stores(f.regcount, 0);
+	Vector<uint32_t> constval(f.regcount, 0);
+	Vector<bool> isimm(f.regcount, false);
+	Vector<bool> loaded(f.regcount, false);
+	for(auto &i : f.instrs) {
+		if(i.ty == IMM) isimm[i.res] = true;
+		if(i.ty == LOAD && local[i.args[0]]) loaded[i.args[0]] = true;
+		if(i.ty != STORE || !local[i.args[0]]) continue;
+		uint32_t slot = i.args[0];
+		if(++stores[slot] == 1 && !loaded[slot] && isimm[i.args[1]]) {
+			constval[slot] = i.args[1];
+		} else {
+			constval[slot] = 0;
+		}
+	}
+
+	// (slot -> stored register) within the current basic block
+	Map<uint32_t, const IRInstr *> last;
+	for(auto &i : f.instrs) {
+		if(i.ty == BASICBLOCK) {
+			last.clear();
+			continue;
+		}
+		if(i.ty == STORE && local[i.args[0]]) {
+			last[i.args[0]] = &i;
+			continue;
+		}
+		if(i.ty != LOAD || !local[i.args[0]]) continue;
+		uint32_t slot = i.args[0];
+		uint32_t val  = 0;
+		auto loc      = last.find(slot);
+		if(loc != last.end() && loc->second->bits == i.bits) val = loc->second->args[1];
+		else if(constval[slot] && stores[slot] == 1) val = constval[slot];
+		if(!val) continue;
+		// the load becomes a truncation + extension of the stored value
+		i.ty   = CAST;
+		i.args = {val};
+		changed = true;
+	}
+	return changed;
+}
+bool IROptimizer::propagateConstants(IRFunc &f)
+{
+	Vector<bool> known(f.regcount, false);
+	Vector<int64_t> vals(f.regcount, 0);
+	Vector<uint32_t> alias(f.regcount, 0);
+	bool changed = false;
+	// a register can only be used after its definition (in instruction order),
+	// so a single pass is enough
+	for(auto &i : f.instrs) {
+		for(auto &a : i.args) {
+			if(alias[a]) a = alias[a];
+		}
+		int64_t res;
+		switch(i.ty) {
+		case IMM:
+			known[i.res] = true;
+			vals[i.res]  = i.imm;
+			break;
+		case CAST:
+			if(known[i.args[0]]) {
+				setImm(i, castInt(vals[i.args[0]], i.bits, i.sign));
+				known[i.res] = true;
+				vals[i.res]  = i.imm;
+				changed	     = true;
+			} else if(i.bits >= 64) {
+				alias[i.res] = i.args[0];
+			}
+			break;
+		case BINOP: {
+			uint32_t l = i.args[0], r = i.args[1];
+			if(known[l] && known[r] && foldBinOp(i.oper, i.sign, vals[l], vals[r], res)) {
+				setImm(i, res);
+				known[i.res] = true;
+				vals[i.res]  = res;
+				changed	     = true;
+				break;
+			}
+			// identities
+			bool rzero = known[r] && vals[r] == 0;
+			bool rone  = known[r] && vals[r] == 1;
+			bool lzero = known[l] && vals[l] == 0;
+			switch(i.oper) {
+			case lex::ADD:
+			case lex::BOR:
+			case lex::BXOR:
+				if(rzero) alias[i.res] = l;
+				else if(lzero) alias[i.res] = r;
+				break;
+			case lex::SUB:
+			case lex::LSHIFT:
+			case lex::RSHIFT:
+				if(rzero) alias[i.res] = l;
+				break;
+			case lex::MUL:
+			case lex::DIV:
+				if(rone) alias[i.res] = l;
+				break;
+			default: break;
+			}
+			break;
+		}
+		case UNOP:
+			if(known[i.args[0]] && foldUnOp(i.oper, vals[i.args[0]], res)) {
+				setImm(i, res);
+				known[i.res] = true;
+				vals[i.res]  = res;
+				changed	     = true;
+			}
+			break;
+		case JMPTRUE:
+		case JMPFALSE: {
+			if(!known[i.args[0]]) break;
+			bool cond = vals[i.args[0]] != 0;
+			if(cond == (i.ty == JMPTRUE)) {
+				i.ty = JMP;
+				i.args.clear();
+			} else {
+				i.ty = INVALID;
+			}
+			changed = true;
+			break;
+		}
+		default: break;
+		}
+	}
+	sweep(f);
+	return changed;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////// Dead Code Elimination ////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool IROptimizer::removeUnreachable(IRFunc &f)
+{
+	bool changed = false;
+	while(true) {
+		Set<uint32_t> targets;
+		for(auto &i : f.instrs) {
+			if(isJmp(i)) targets.insert(i.blk);
+		}
+		bool dead	= false;
+		IRInstr *prev	= nullptr;
+		for(auto &i : f.instrs) {
+			if(i.ty == BASICBLOCK) {
+				if(targets.find(i.blk) != targets.end()) {
+					dead = false;
+				} else if(!dead) {
+					// fallthrough only - merge with the previous block
+					i.ty = INVALID;
+					continue;
+				}
+			}
+			if(dead) {
+				i.ty = INVALID;
+				continue;
+			}
+			// jump to the next instruction
+			if(prev && prev->ty == JMP && i.ty == BASICBLOCK && prev->blk == i.blk) {
+				prev->ty = INVALID;
+			}
+			if(isTerminator(i)) dead = true;
+			prev = &i;
+		}
+		if(!sweep(f)) break;
+		changed = true;
+	}
+	return changed;
+}
+bool IROptimizer::eliminateDeadCode(IRFunc &f)
+{
+	bool changed = false;
+	while(true) {
+		Vector<bool> local = getLocalSlots(f);
+		Vector<size_t> uses(f.regcount, 0);
+		Vector<bool> loaded(f.regcount, false);
+		for(auto &i : f.instrs) {
+			for(auto &a : i.args) ++uses[a];
+			if(i.ty == LOAD) loaded[i.args[0]] = true;
+		}
+		for(auto &i : f.instrs) {
+			// stores to slots which are never read
+			if(i.ty == STORE && local[i.args[0]] && !loaded[i.args[0]]) {
+				i.ty = INVALID;
+				continue;
+			}
+			if(isPure(i) && !uses[i.res]) i.ty = INVALID;
+		}
+		if(!sweep(f)) break;
+		changed = true;
+	}
+	return changed;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////// Module Level /////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+void IROptimizer::compactRegisters(IRFunc &f)
+{
+	Vector<uint32_t> map(f.regcount, 0);
+	uint32_t next = 1;
+	for(auto &i : f.instrs) {
+		for(auto &a : i.args) a = map[a];
+		if(!i.res) continue;
+		map[i.res] = next;
+		i.res	   = next++;
+	}
+	f.regcount = next;
+}
+// remove functions and globals which are not reachable from exported functions (anymore)
+void IROptimizer::removeUnused()
+{
+	Map<StringRef, IRFunc *> fns;
+	Map<StringRef, IRGlobal *> globals;
+	for(auto &f : mod.funcs) fns[f.name] = &f;
+	for(auto &g : mod.globals) globals[g.name] = &g;
+
+	Set<StringRef> used;
+	Vector<StringRef> worklist;
+	for(auto &f : mod.funcs) {
+		if(!f.exported) continue;
+		used.insert(f.name);
+		worklist.push_back(f.name);
+	}
+	while(!worklist.empty()) {
+		StringRef name = worklist.back();
+		worklist.pop_back();
+		Vector<StringRef> refs;
+		auto floc = fns.find(name);
+		if(floc != fns.end()) {
+			for(auto &i : floc->second->instrs) {
+				if((i.ty == CALL || i.ty == ADDR) && !i.name.empty()) refs.push_back(i.name);
+			}
+		}
+		auto gloc = globals.find(name);
+		if(gloc != globals.end()) {
+			for(auto &r : gloc->second->relocs) refs.push_back(r.second);
+		}
+		for(auto &r : refs) {
+			if(used.find(r) != used.end()) continue;
+			used.insert(r);
+			worklist.push_back(r);
+		}
+	}
+	mod.funcs.erase(std::remove_if(mod.funcs.begin(), mod.funcs.end(),
+				       [&](const IRFunc &f) { return !used.contains(f.name); }),
+			mod.funcs.end());
+	mod.globals.erase(std::remove_if(mod.globals.begin(), mod.globals.end(),
+					 [&](const IRGlobal &g) { return !used.contains(g.name); }),
+			  mod.globals.end());
+}
+} // namespace sc
@@ -0,0 +1,362 @@
+#include "CodeGen/X86_64.hpp"
+
+#include <iostream>
+
+#include "CodeGen/C.hpp"
+#include "CodeGen/IRBuilder.hpp"
+#include "CodeGen/IROpt.hpp"
+#include "Env.hpp"
+#include "FS.hpp"
+#include "Parser.hpp"
+
+namespace sc
+{
+static const char *argregs[] = {"%rdi", "%rsi", "%rdx", "%rcx", "%r8", "%r9"};
+
+X86_64Driver::X86_64Driver(RAIIParser &parser) : CodeGenDriver(parser) {}
+X86_64Driver::~X86_64Driver() {}
+
+bool X86_64Driver::compile(StringRef outfile)
+{
+	Module *mainmod = parser.getMainModule();
+	IRBuilder builder(ctx, mod);
+	if(!builder.build(mainmod->getParseTree())) {
+		err::outw(builder.getFailLoc(), "native backend does not support this program (",
+			  builder.getFailMsg(), "), using C backend");
+		CDriver cdriver(parser);
+		return cdriver.compile(outfile);
+	}
+	args::ArgParser &cliargs = parser.getCommandArgs();
+	IROptimizer optimizer(mod);
+	optimizer.optimize();
+	if(cliargs.has("verbose")) {
+		std::cout << "inlined calls: " << optimizer.getInlineCount()
+			  << ", removed IR instructions: " << optimizer.getRemovedInstrCount() << "\n";
+	}
+
+	Writer writer;
+	writer.write("\t.data");
+	writer.newLine();
+	for(auto &g : mod.globals) writeGlobal(g, writer);
+	writer.write("\t.text");
+	writer.newLine();
+	for(size_t i = 0; i < mod.funcs.size(); ++i) writeFunc(mod.funcs[i], i, writer);
+	writer.write("\t.section .note.GNU-stack,\"\",@progbits");
+	writer.newLine();
+
+	bool ir_only		 = cliargs.has("ir");
+	String asmfile;
+	if(ir_only) {
+		asmfile = outfile;
+		asmfile += ".s";
+		String irfile(outfile);
+		irfile += ".ir";
+		FILE *f	      = fopen(irfile.c_str(), "w+");
+		if(!f) {
+			err::out(mainmod->getParseTree(), "failed to create file for writing IR: ", irfile);
+			return false;
+		}
+		fprintf(f, "%s", mod.toStr().c_str());
+		fclose(f);
+	} else {
+		auto loc = outfile.find_last_of('/');
+		asmfile	 = (loc == String::npos ? outfile : outfile.substr(loc));
+		asmfile	 = "/tmp/" + asmfile + ".s";
+	}
+	FILE *f = fopen(asmfile.c_str(), "w+");
+	if(!f) {
+		err::out(mainmod->getParseTree(), "failed to create file for writing assembly: ", asmfile);
+		return false;
+	}
+	fprintf(f, "%s", writer.getData().c_str());
+	fclose(f);
+	if(ir_only) return true;
+
+	// the system compiler is only used as an assembler + linker driver
+	String cmd;
+	cmd.reserve(128);
+	cmd += getSystemCompiler();
+	cmd += " ";
+	cmd += asmfile + " -o ";
+	cmd += outfile;
+	for(auto &l : builder.getLibFlags()) {
+		cmd += " ";
+		cmd += l;
+	}
+	int res = env::exec(cmd);
+	if(res) {
+		err::out(mainmod->getParseTree(),
+			 "failed to assemble code, got assembler exit status: ", res);
+		return false;
+	}
+	return true;
+}
+
+void X86_64Driver::writeGlobal(const IRGlobal &g, Writer &writer)
+{
+	size_t p2align = 0;
+	while((1ULL << p2align) < g.align) ++p2align;
+	writer.write({"\t.p2align ", std::to_string(p2align)});
+	writer.newLine();
+	writer.write({g.name, ":"});
+	writer.newLine();
+	if(g.data.empty()) {
+		writer.write("\t.zero 1");
+		writer.newLine();
+		return;
+	}
+	size_t reloc	    = 0;
+	size_t inline_bytes = 0;
+	for(size_t i = 0; i < g.data.size();) {
+		if(reloc < g.relocs.size() && g.relocs[reloc].first == i) {
+			if(inline_bytes) writer.newLine();
+			inline_bytes = 0;
+			writer.write({"\t.quad ", g.relocs[reloc].second});
+			writer.newLine();
+			++reloc;
+			i += 8;
+			continue;
+		}
+		writer.write(inline_bytes ? ", " : "\t.byte ");
+		writer.write(std::to_string((uint8_t)g.data[i]));
+		if(++inline_bytes == 16) {
+			writer.newLine();
+			inline_bytes = 0;
+		}
+		++i;
+	}
+	if(inline_bytes) writer.newLine();
+}
+
+void X86_64Driver::writeFunc(const IRFunc &f, size_t fnidx, Writer &writer)
+{
+	// frame: [registers][variables], each register is 8 bytes
+	int64_t framesz = 8 * (int64_t)f.regcount;
+	varslots.clear();
+	for(auto &i : f.instrs) {
+		if(i.ty != CREATEVAR) continue;
+		int64_t align = i.bits ? i.bits : 8;
+		framesz += i.imm ? i.imm : 1;
+		framesz = (framesz + align - 1) / align * align;
+		varslots[i.res] = -framesz;
+	}
+	framesz = (framesz + 15) / 16 * 16;
+
+	writer.newLine();
+	if(f.exported) {
+		writer.write({"\t.globl ", f.name});
+		writer.newLine();
+	}
+	writer.write({"\t.type ", f.name, ", @function"});
+	writer.newLine();
+	writer.write({f.name, ":"});
+	writer.newLine();
+	writer.write("\tpushq %rbp");
+	writer.newLine();
+	writer.write("\tmovq %rsp, %rbp");
+	writer.newLine();
+	writer.write({"\tsubq $", std::to_string(framesz), ", %rsp"});
+	writer.newLine();
+	for(auto &i : f.instrs) writeInstr(f, i, fnidx, writer);
+	writer.write({"\t.size ", f.name, ", .-", f.name});
+	writer.newLine();
+}
+
+void X86_64Driver::writeLoadReg(uint32_t reg, StringRef dest, Writer &writer)
+{
+	writer.write({"\tmovq -", std::to_string(8 * (uint64_t)reg), "(%rbp), ", dest});
+	writer.newLine();
+}
+void X86_64Driver::writeStoreReg(uint32_t reg, StringRef src, Writer &writer)
+{
+	writer.write({"\tmovq ", src, ", -", std::to_string(8 * (uint64_t)reg), "(%rbp)"});
+	writer.newLine();
+}
+void X86_64Driver::writeLabel(size_t fnidx, uint32_t blk, Writer &writer)
+{
+	writer.write({".L", std::to_string(fnidx), "_", std::to_string(blk)});
+}
+
+void X86_64Driver::writeInstr(const IRFunc &f, const IRInstr &i, size_t fnidx, Writer &writer)
+{
+	auto line = [&](InitList<StringRef> data) {
+		writer.write("\t");
+		writer.write(data);
+		writer.newLine();
+	};
+	switch(i.ty) {
+	case BASICBLOCK:
+		writeLabel(fnidx, i.blk, writer);
+		writer.write(":");
+		writer.newLine();
+		return;
+	case IMM:
+		if(i.imm >= INT32_MIN && i.imm <= INT32_MAX) {
+			line({"movq $", std::to_string(i.imm), ", %rax"});
+		} else {
+			line({"movabsq $", std::to_string(i.imm), ", %rax"});
+		}
+		break;
+	case ARG:
+		if(i.blk < 6) {
+			writeStoreReg(i.res, argregs[i.blk], writer);
+			return;
+		}
+		line({"movq ", std::to_string(16 + 8 * (i.blk - 6)), "(%rbp), %rax"});
+		break;
+	case ADDR:
+		if(mod.externs.contains(i.name)) line({"movq ", i.name, "@GOTPCREL(%rip), %rax"});
+		else line({"leaq ", i.name, "(%rip), %rax"});
+		break;
+	case CREATEVAR: line({"leaq ", std::to_string(varslots[i.res]), "(%rbp), %rax"}); break;
+	case LOAD:
+		writeLoadReg(i.args[0], "%rcx", writer);
+		switch(i.bits) {
+		case 8: line({i.sign ? "movsbq" : "movzbq", " (%rcx), %rax"}); break;
+		case 16: line({i.sign ? "movswq" : "movzwq", " (%rcx), %rax"}); break;
+		case 32: line({i.sign ? "movslq (%rcx), %rax" : "movl (%rcx), %eax"}); break;
+		default: line({"movq (%rcx), %rax"}); break;
+		}
+		break;
+	case STORE:
+		writeLoadReg(i.args[0], "%rax", writer);
+		writeLoadReg(i.args[1], "%rcx", writer);
+		switch(i.bits) {
+		case 8: line({"movb %cl, (%rax)"}); break;
+		case 16: line({"movw %cx, (%rax)"}); break;
+		case 32: line({"movl %ecx, (%rax)"}); break;
+		default: line({"movq %rcx, (%rax)"}); break;
+		}
+		return;
+	case COPY:
+		writeLoadReg(i.args[0], "%rdi", writer);
+		writeLoadReg(i.args[1], "%rsi", writer);
+		line({"movq $", std::to_string(i.imm), ", %rcx"});
+		line({"rep movsb"});
+		return;
+	case DOT:
+		writeLoadReg(i.args[0], "%rax", writer);
+		line({"leaq ", std::to_string(i.imm), "(%rax), %rax"});
+		break;
+	case CAST:
+		writeLoadReg(i.args[0], "%rax", writer);
+		switch(i.bits) {
+		case 1:
+			line({"cmpq $0, %rax"});
+			line({"setne %al"});
+			line({"movzbq %al, %rax"});
+			break;
+		case 8: line({i.sign ? "movsbq" : "movzbq", " %al, %rax"}); break;
+		case 16: line({i.sign ? "movswq" : "movzwq", " %ax, %rax"}); break;
+		case 32: line({i.sign ? "movslq %eax, %rax" : "movl %eax, %eax"}); break;
+		default: break;
+		}
+		break;
+	case UNOP:
+		writeLoadReg(i.args[0], "%rax", writer);
+		switch(i.oper) {
+		case lex::USUB: line({"negq %rax"}); break;
+		case lex::BNOT: line({"notq %rax"}); break;
+		case lex::LNOT:
+			line({"cmpq $0, %rax"});
+			line({"sete %al"});
+			line({"movzbq %al, %rax"});
+			break;
+		default: break;
+		}
+		break;
+	case BINOP: {
+		writeLoadReg(i.args[0], "%rax", writer);
+		writeLoadReg(i.args[1], "%rcx", writer);
+		StringRef setcc;
+		switch(i.oper) {
+		case lex::ADD: line({"addq %rcx, %rax"}); break;
+		case lex::SUB: line({"subq %rcx, %rax"}); break;
+		case lex::MUL: line({"imulq %rcx, %rax"}); break;
+		case lex::DIV:
+		case lex::MOD:
+			if(i.sign) {
+				line({"cqo"});
+				line({"idivq %rcx"});
+			} else {
+				line({"xorl %edx, %edx"});
+				line({"divq %rcx"});
+			}
+			if(i.oper == lex::MOD) line({"movq %rdx, %rax"});
+			break;
+		case lex::BAND: line({"andq %rcx, %rax"}); break;
+		case lex::BOR: line({"orq %rcx, %rax"}); break;
+		case lex::BXOR: line({"xorq %rcx, %rax"}); break;
+		case lex::LSHIFT: line({"shlq %cl, %rax"}); break;
+		case lex::RSHIFT: line({i.sign ? "sarq %cl, %rax" : "shrq %cl, %rax"}); break;
+		case lex::EQ: setcc = "sete"; break;
+		case lex::NE: setcc = "setne"; break;
+		case lex::LT: setcc = i.sign ? "setl" : "setb"; break;
+		case lex::LE: setcc = i.sign ? "setle" : "setbe"; break;
+		case lex::GT: setcc = i.sign ? "setg" : "seta"; break;
+		case lex::GE: setcc = i.sign ? "setge" : "setae"; break;
+		default: break;
+		}
+		if(!setcc.empty()) {
+			line({"cmpq %rcx, %rax"});
+			line({setcc, " %al"});
+			line({"movzbq %al, %rax"});
+		}
+		break;
+	}
+	case MULHI:
+		writeLoadReg(i.args[0], "%rax", writer);
+		writeLoadReg(i.args[1], "%rcx", writer);
+		line({"mulq %rcx"});
+		line({"movq %rdx, %rax"});
+		break;
+	case JMP:
+		writer.write("\tjmp ");
+		writeLabel(fnidx, i.blk, writer);
+		writer.newLine();
+		return;
+	case JMPTRUE:
+	case JMPFALSE:
+		writeLoadReg(i.args[0], "%rax", writer);
+		line({"testq %rax, %rax"});
+		writer.write(i.ty == JMPTRUE ? "\tjne " : "\tje ");
+		writeLabel(fnidx, i.blk, writer);
+		writer.newLine();
+		return;
+	case CALL: {
+		size_t first	 = i.indirect ? 1 : 0;
+		size_t argcount	 = i.args.size() - first;
+		size_t stackargs = argcount > 6 ? argcount - 6 : 0;
+		size_t padding	 = stackargs % 2 ? 8 : 0;
+		if(padding) line({"subq $8, %rsp"});
+		for(size_t a = i.args.size(); a > first + 6; --a) {
+			writeLoadReg(i.args[a - 1], "%rax", writer);
+			line({"pushq %rax"});
+		}
+		for(size_t a = 0; a < argcount && a < 6; ++a) {
+			writeLoadReg(i.args[first + a], argregs[a], writer);
+		}
+		if(i.variadic) line({"xorl %eax, %eax"});
+		if(i.indirect) {
+			writeLoadReg(i.args[0], "%r11", writer);
+			line({"call *%r11"});
+		} else if(mod.externs.contains(i.name)) {
+			line({"call ", i.name, "@PLT"});
+		} else {
+			line({"call ", i.name});
+		}
+		if(stackargs || padding) {
+			line({"addq $", std::to_string(8 * stackargs + padding), ", %rsp"});
+		}
+		break;
+	}
+	case RETURN:
+		if(!i.args.empty()) writeLoadReg(i.args[0], "%rax", writer);
+		line({"leave"});
+		line({"ret"});
+		return;
+	default: break;
+	}
+	if(i.res) writeStoreReg(i.res, "%rax", writer);
+}
+} // namespace sc
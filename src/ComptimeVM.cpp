@@ -0,0 +1,525 @@
+#include "ComptimeVM.hpp"
+
+#include "Context.hpp"
+#include "Intrinsics.hpp"
+
+// deeper recursion is left to the ValueAssignPass
+#define MAX_CALL_DEPTH 4096
+
+namespace sc
+{
+ComptimeVM::ComptimeVM() : depth(0) {}
+
+const ComptimeVM::Oper *ComptimeVM::getOper(IntrinsicFn fn)
+{
+	static const Oper opers[] = {
+	{intrinsic_add_int, ADD, BINARY, false},
+	{intrinsic_sub_int, SUB, BINARY, false},
+	{intrinsic_mul_int, MUL, BINARY, false},
+	{intrinsic_div_int, DIV, BINARY, false},
+	{intrinsic_mod_int, MOD, BINARY, false},
+	{intrinsic_band_int, BAND, BINARY, false},
+	{intrinsic_bor_int, BOR, BINARY, false},
+	{intrinsic_bxor_int, BXOR, BINARY, false},
+	{intrinsic_lshift_int, SHL, BINARY, false},
+	{intrinsic_rshift_int, SHR, BINARY, false},
+	{intrinsic_logand_int, LAND, BINARY, false},
+	{intrinsic_logor_int, LOR, BINARY, false},
+	{intrinsic_eq_int, EQ, BINARY, false},
+	{intrinsic_lt_int, LT, BINARY, false},
+	{intrinsic_gt_int, GT, BINARY, false},
+	{intrinsic_le_int, LE, BINARY, false},
+	{intrinsic_ge_int, GE, BINARY, false},
+	{intrinsic_ne_int, NE, BINARY, false},
+	{intrinsic_uadd_int, MOV, UNARY, false},
+	{intrinsic_usub_int, NEG, UNARY, false},
+	{intrinsic_lognot_int, NOT, UNARY, false},
+	{intrinsic_bnot_int, BNOT, UNARY, false},
+	{intrinsic_assn_int, MOV, ASSIGN, false},
+	{intrinsic_addassn_int, ADD, ASSIGN_BINARY, false},
+	{intrinsic_subassn_int, SUB, ASSIGN_BINARY, false},
+	{intrinsic_mulassn_int, MUL, ASSIGN_BINARY, false},
+	{intrinsic_divassn_int, DIV, ASSIGN_BINARY, false},
+	{intrinsic_modassn_int, MOD, ASSIGN_BINARY, false},
+	{intrinsic_bandassn_int, BAND, ASSIGN_BINARY, false},
+	{intrinsic_borassn_int, BOR, ASSIGN_BINARY, false},
+	{intrinsic_bxorassn_int, BXOR, ASSIGN_BINARY, false},
+	{intrinsic_lshiftassn_int, SHL, ASSIGN_BINARY, false},
+	{intrinsic_rshiftassn_int, SHR, ASSIGN_BINARY, false},
+	{intrinsic_incx_int, ADD, PREFIX, false},
+	{intrinsic_decx_int, SUB, PREFIX, false},
+	{intrinsic_xinc_int, ADD, POSTFIX, false},
+	{intrinsic_xdec_int, SUB, POSTFIX, false},
+
+	{intrinsic_add_flt, FADD, BINARY, true},
+	{intrinsic_sub_flt, FSUB, BINARY, true},
+	{intrinsic_mul_flt, FMUL, BINARY, true},
+	{intrinsic_div_flt, FDIV, BINARY, true},
+	{intrinsic_logand_flt, FLAND, BINARY, true},
+	{intrinsic_logor_flt, FLOR, BINARY, true},
+	{intrinsic_eq_flt, FEQ, BINARY, true},
+	{intrinsic_lt_flt, FLT, BINARY, true},
+	{intrinsic_gt_flt, FGT, BINARY, true},
+	{intrinsic_le_flt, FLE, BINARY, true},
+	{intrinsic_ge_flt, FGE, BINARY, true},
+	{intrinsic_ne_flt, FNE, BINARY, true},
+	{intrinsic_uadd_flt, MOV, UNARY, true},
+	{intrinsic_usub_flt, FNEG, UNARY, true},
+	{intrinsic_lognot_flt, FNOT, UNARY, true},
+	{intrinsic_assn_flt, MOV, ASSIGN, true},
+	{intrinsic_addassn_flt, FADD, ASSIGN_BINARY, true},
+	{intrinsic_subassn_flt, FSUB, ASSIGN_BINARY, true},
+	{intrinsic_mulassn_flt, FMUL, ASSIGN_BINARY, true},
+	{intrinsic_divassn_flt, FDIV, ASSIGN_BINARY, true},
+	};
+	for(auto &o : opers) {
+		if(o.fn == fn) return &o;
+	}
+	return nullptr;
+}
+
+bool ComptimeVM::getFunc(StmtFnDef *def, size_t &fnidx)
+{
+	auto loc = fnids.find(def);
+	if(loc != fnids.end()) {
+		fnidx = loc->second;
+		return funcs[fnidx].valid;
+	}
+	fnidx	    = funcs.size();
+	fnids[def] = fnidx;
+	funcs.push_back({});
+	Func &fn = funcs.back();
+	fn.valid = false;
+
+	if(!def->getBlk() || !def->getTy() || !def->getTy()->isFunc()) return false;
+	FuncTy *ft = as<FuncTy>(def->getTy());
+	if(ft->isVariadic()) return false;
+	Type *ret = ft->getRet();
+	if(!ret->isInt() && !ret->isFlt()) return false;
+	fn.retflt = ret->isFlt();
+
+	FuncState fs;
+	fs.fnidx		   = fnidx;
+	const Vector<StmtVar *> &args = def->getSigArgs();
+	for(size_t i = 0; i < args.size(); ++i) {
+		Type *t = args[i]->getTy();
+		if(args[i]->isRef() || (!t->isInt() && !t->isFlt())) return false;
+		fs.locals[args[i]] = {(uint32_t)i, t->isFlt()};
+		fn.argflt.push_back(t->isFlt());
+	}
+	fn.regcount = args.size();
+	// allows recursive calls - the function is rejected at runtime if its compilation fails
+	fn.valid = true;
+	if(!compileBlock(fs, def->getBlk())) {
+		funcs[fnidx].valid = false;
+		funcs[fnidx].code.clear();
+		return false;
+	}
+	emit(fs, FAIL, 0);
+	return true;
+}
+
+uint32_t ComptimeVM::emit(FuncState &fs, Op op, uint32_t dst, uint32_t a, uint32_t b)
+{
+	Vector<Instr> &code = funcs[fs.fnidx].code;
+	code.push_back({op, dst, a, b});
+	return code.size() - 1;
+}
+uint32_t ComptimeVM::newReg(FuncState &fs) { return funcs[fs.fnidx].regcount++; }
+uint32_t ComptimeVM::loadConst(FuncState &fs, Reg val)
+{
+	Vector<Reg> &consts = funcs[fs.fnidx].consts;
+	consts.push_back(val);
+	uint32_t reg = newReg(fs);
+	emit(fs, LOADK, reg, consts.size() - 1);
+	return reg;
+}
+
+bool ComptimeVM::compile(FuncState &fs, Stmt *stmt)
+{
+	uint32_t reg;
+	bool flt;
+	switch(stmt->getStmtType()) {
+	case BLOCK: return compileBlock(fs, as<StmtBlock>(stmt));
+	case SIMPLE: // fallthrough
+	case EXPR: return compileExpr(fs, stmt, reg, flt);
+	case VAR: {
+		StmtVar *var = as<StmtVar>(stmt);
+		Stmt *val    = var->getVVal();
+		if(!val || val->isFnDef() || var->isStatic()) return false;
+		if(!compileExpr(fs, val, reg, flt)) return false;
+		if(flt ? !var->getTy()->isFlt() : !var->getTy()->isInt()) return false;
+		uint32_t local = newReg(fs);
+		emit(fs, MOV, local, reg);
+		fs.locals[var] = {local, flt};
+		return true;
+	}
+	case VARDECL: {
+		for(auto &d : as<StmtVarDecl>(stmt)->getDecls()) {
+			if(!compile(fs, d)) return false;
+		}
+		return true;
+	}
+	case COND: return compileCond(fs, as<StmtCond>(stmt));
+	case FOR: return compileFor(fs, as<StmtFor>(stmt));
+	case RET: {
+		Stmt *val = as<StmtRet>(stmt)->getRetVal();
+		if(!val || !compileExpr(fs, val, reg, flt)) return false;
+		if(flt != funcs[fs.fnidx].retflt) return false;
+		emit(fs, RETURN, reg);
+		return true;
+	}
+	case CONTINUE: {
+		if(fs.loops.empty()) return false;
+		fs.loops.back().continues.push_back(emit(fs, JMP, 0));
+		return true;
+	}
+	case BREAK: {
+		if(fs.loops.empty()) return false;
+		fs.loops.back().breaks.push_back(emit(fs, JMP, 0));
+		return true;
+	}
+	case DEFER: return true; // defers are already moved to their places by TypeAssignPass
+	default: break;
+	}
+	return false;
+}
+bool ComptimeVM::compileBlock(FuncState &fs, StmtBlock *blk)
+{
+	for(auto &s : blk->getStmts()) {
+		if(!compile(fs, s)) return false;
+	}
+	return true;
+}
+bool ComptimeVM::compileCond(FuncState &fs, StmtCond *stmt)
+{
+	if(stmt->isInline()) {
+		if(stmt->getConditionals().empty()) return true;
+		return compileBlock(fs, stmt->getConditionals()[0].getBlk());
+	}
+	Vector<size_t> ends;
+	for(auto &c : stmt->getConditionals()) {
+		if(!c.getCond()) {
+			if(!compileBlock(fs, c.getBlk())) return false;
+			break;
+		}
+		uint32_t reg;
+		bool flt;
+		if(!compileExpr(fs, c.getCond(), reg, flt)) return false;
+		uint32_t next = emit(fs, flt ? FJZ : JZ, reg);
+		if(!compileBlock(fs, c.getBlk())) return false;
+		ends.push_back(emit(fs, JMP, 0));
+		funcs[fs.fnidx].code[next].a = funcs[fs.fnidx].code.size();
+	}
+	Vector<Instr> &code = funcs[fs.fnidx].code;
+	for(auto &e : ends) code[e].a = code.size();
+	return true;
+}
+bool ComptimeVM::compileFor(FuncState &fs, StmtFor *stmt)
+{
+	// inline for loops are unrolled by the TypeAssignPass
+	if(stmt->isInline() || !stmt->getCond() || !stmt->getBlk()) return false;
+	uint32_t reg;
+	bool flt;
+	if(stmt->getInit() && !compile(fs, stmt->getInit())) return false;
+	uint32_t condpos = funcs[fs.fnidx].code.size();
+	if(!compileExpr(fs, stmt->getCond(), reg, flt)) return false;
+	uint32_t exit = emit(fs, flt ? FJZ : JZ, reg);
+	fs.loops.push_back({});
+	if(!compileBlock(fs, stmt->getBlk())) return false;
+	uint32_t incrpos = funcs[fs.fnidx].code.size();
+	if(stmt->getIncr() && !compileExpr(fs, stmt->getIncr(), reg, flt)) return false;
+	emit(fs, JMP, 0, condpos);
+	Vector<Instr> &code = funcs[fs.fnidx].code;
+	code[exit].a	    = code.size();
+	for(auto &b : fs.loops.back().breaks) code[b].a = code.size();
+	for(auto &c : fs.loops.back().continues) code[c].a = incrpos;
+	fs.loops.pop_back();
+	return true;
+}
+bool ComptimeVM::compileExpr(FuncState &fs, Stmt *stmt, uint32_t &res, bool &flt)
+{
+	if(stmt->getDerefCount()) return false;
+	bool ok = false;
+	if(stmt->getStmtType() == SIMPLE) ok = compileSimple(fs, as<StmtSimple>(stmt), res, flt);
+	else if(stmt->getStmtType() == EXPR) ok = compileOper(fs, as<StmtExpr>(stmt), res, flt);
+	if(!ok) return false;
+	// like the ValueAssignPass, casts do not change the values
+	// so only allow those which don't change the kind of value either
+	Type *cast = stmt->getCast();
+	if(cast && (flt ? !cast->isFlt() : !cast->isInt())) return false;
+	return true;
+}
+bool ComptimeVM::compileSimple(FuncState &fs, StmtSimple *stmt, uint32_t &res, bool &flt)
+{
+	Value *val = nullptr;
+	switch(stmt->getLexValue().getTokVal()) {
+	case lex::IDEN: {
+		StmtVar *decl = stmt->getDecl();
+		if(decl) {
+			auto loc = fs.locals.find(decl);
+			if(loc != fs.locals.end()) {
+				res = loc->second.reg;
+				flt = loc->second.flt;
+				return true;
+			}
+			// non-local variables are usable only if they never change
+			val = decl->getVal();
+			if(!val || !val->hasPermaData()) return false;
+		} else {
+			val = stmt->getVal();
+		}
+		break;
+	}
+	case lex::TRUE:	 // fallthrough
+	case lex::FALSE: // fallthrough
+	case lex::NIL:	 // fallthrough
+	case lex::CHAR:	 // fallthrough
+	case lex::INT:	 // fallthrough
+	case lex::FLT: val = stmt->getVal(); break;
+	default: return false;
+	}
+	if(!val || !val->hasData() || (!val->isInt() && !val->isFlt())) return false;
+	Reg r;
+	flt = val->isFlt();
+	if(flt) r.f = as<FltVal>(val)->getVal();
+	else r.i = as<IntVal>(val)->getVal();
+	res = loadConst(fs, r);
+	return true;
+}
+bool ComptimeVM::compileCall(FuncState &fs, StmtFnDef *def, const Vector<Stmt *> &args,
+			     uint32_t &res, bool &flt)
+{
+	size_t fnidx;
+	if(!getFunc(def, fnidx)) return false;
+	Vector<bool> argflt = funcs[fnidx].argflt;
+	bool retflt	    = funcs[fnidx].retflt;
+	if(argflt.size() != args.size()) return false;
+	Vector<uint32_t> argregs;
+	for(size_t i = 0; i < args.size(); ++i) {
+		uint32_t reg;
+		bool aflt;
+		if(!compileExpr(fs, args[i], reg, aflt) || aflt != argflt[i]) return false;
+		argregs.push_back(reg);
+	}
+	// arguments must be in consecutive registers
+	uint32_t base = funcs[fs.fnidx].regcount;
+	for(auto &a : argregs) emit(fs, MOV, newReg(fs), a);
+	res = newReg(fs);
+	flt = retflt;
+	emit(fs, CALL, res, fnidx, base);
+	return true;
+}
+bool ComptimeVM::compileOper(FuncState &fs, StmtExpr *stmt, uint32_t &res, bool &flt)
+{
+	Stmt *lhs	  = stmt->getLHS();
+	Stmt *rhs	  = stmt->getRHS();
+	lex::TokType oper = stmt->getOper().getTokVal();
+	FuncTy *fn	  = nullptr;
+	Vector<Stmt *> args;
+
+	switch(oper) {
+	case lex::FNCALL: {
+		if(!rhs || !rhs->isFnCallInfo()) return false;
+		// values in function bodies are cleared after each evaluation, types stay
+		if(lhs->getVal() && lhs->getVal()->isFunc()) fn = as<FuncVal>(lhs->getVal())->getVal();
+		else if(lhs->getTy() && lhs->getTy()->isFunc()) fn = as<FuncTy>(lhs->getTy());
+		args = as<StmtFnCallInfo>(rhs)->getArgs();
+		break;
+	}
+	case lex::DOT:	 // fallthrough
+	case lex::ARROW: // fallthrough
+	case lex::STCALL: // fallthrough
+	case lex::UAND:	  // fallthrough // fallthrough
+	case lex::UMUL: return false;
+	case lex::SUBS:
+		if(lhs->getTy()->isPtr()) return false;
+	// fallthrough
+	default:
+		fn = stmt->getCalledFn();
+		args.push_back(lhs);
+		if(rhs) args.push_back(rhs);
+		break;
+	}
+	if(!fn) return false;
+	if(!fn->isIntrinsic()) {
+		if(!fn->getVar() || !fn->getVar()->getVVal() || !fn->getVar()->getVVal()->isFnDef())
+		{
+			return false;
+		}
+		return compileCall(fs, as<StmtFnDef>(fn->getVar()->getVVal()), args, res, flt);
+	}
+	const Oper *op = getOper(fn->getIntrinsicFn());
+	if(!op || args.empty()) return false;
+
+	uint32_t a, b;
+	bool aflt, bflt;
+	Local *target = nullptr;
+	switch(op->kind) {
+	case BINARY:
+		if(args.size() != 2 || !compileExpr(fs, args[0], a, aflt) ||
+		   !compileExpr(fs, args[1], b, bflt) || aflt != op->flt || bflt != op->flt)
+		{
+			return false;
+		}
+		res = newReg(fs);
+		emit(fs, op->op, res, a, b);
+		break;
+	case UNARY:
+		if(!compileExpr(fs, args[0], a, aflt) || aflt != op->flt) return false;
+		res = newReg(fs);
+		emit(fs, op->op, res, a);
+		break;
+	case ASSIGN: // fallthrough
+	case ASSIGN_BINARY:
+		target = getTarget(fs, args[0]);
+		if(!target || target->flt != op->flt || args.size() != 2 ||
+		   !compileExpr(fs, args[1], b, bflt) || bflt != op->flt)
+		{
+			return false;
+		}
+		if(op->kind == ASSIGN) emit(fs, MOV, target->reg, b);
+		else emit(fs, op->op, target->reg, target->reg, b);
+		res = newReg(fs);
+		emit(fs, MOV, res, target->reg);
+		break;
+	case PREFIX: // fallthrough
+	case POSTFIX: {
+		target = getTarget(fs, args[0]);
+		if(!target || target->flt) return false;
+		res = newReg(fs);
+		if(op->kind == POSTFIX) emit(fs, MOV, res, target->reg);
+		Reg one;
+		one.i = 1;
+		emit(fs, op->op, target->reg, target->reg, loadConst(fs, one));
+		if(op->kind == PREFIX) emit(fs, MOV, res, target->reg);
+		break;
+	}
+	}
+	flt = op->flt;
+	return true;
+}
+ComptimeVM::Local *ComptimeVM::getTarget(FuncState &fs, Stmt *stmt)
+{
+	if(stmt->getStmtType() != SIMPLE || stmt->getDerefCount() || stmt->getCast()) {
+		return nullptr;
+	}
+	StmtSimple *sim = as<StmtSimple>(stmt);
+	if(sim->getLexValue().getTokVal() != lex::IDEN || !sim->getDecl()) return nullptr;
+	auto loc = fs.locals.find(sim->getDecl());
+	if(loc == fs.locals.end()) return nullptr;
+	return &loc->second;
+}
+
+bool ComptimeVM::exec(size_t fnidx, size_t base, Reg &res)
+{
+	const Func &fn = funcs[fnidx];
+	if(!fn.valid || depth >= MAX_CALL_DEPTH) return false;
+	++depth;
+	if(stack.size() < base + fn.regcount) stack.resize(base + fn.regcount);
+	Reg *r		 = stack.data() + base;
+	const Instr *ins = fn.code.data();
+	size_t pc	 = 0;
+	bool ok		 = false;
+	while(true) {
+		const Instr &i = ins[pc++];
+		switch(i.op) {
+		case MOV: r[i.dst] = r[i.a]; break;
+		case LOADK: r[i.dst] = fn.consts[i.a]; break;
+		// unsigned arithmetic for defined overflow
+		case ADD: r[i.dst].i = (uint64_t)r[i.a].i + (uint64_t)r[i.b].i; break;
+		case SUB: r[i.dst].i = (uint64_t)r[i.a].i - (uint64_t)r[i.b].i; break;
+		case MUL: r[i.dst].i = (uint64_t)r[i.a].i * (uint64_t)r[i.b].i; break;
+		case DIV: // fallthrough
+		case MOD:
+			// let the ValueAssignPass deal with it
+			if(r[i.b].i == 0 || (r[i.a].i == INT64_MIN && r[i.b].i == -1)) goto end;
+			if(i.op == DIV) r[i.dst].i = r[i.a].i / r[i.b].i;
+			else r[i.dst].i = r[i.a].i % r[i.b].i;
+			break;
+		case BAND: r[i.dst].i = r[i.a].i & r[i.b].i; break;
+		case BOR: r[i.dst].i = r[i.a].i | r[i.b].i; break;
+		case BXOR: r[i.dst].i = r[i.a].i ^ r[i.b].i; break;
+		case SHL: r[i.dst].i = (uint64_t)r[i.a].i << r[i.b].i; break;
+		case SHR: r[i.dst].i = r[i.a].i >> r[i.b].i; break;
+		case LAND: r[i.dst].i = r[i.a].i && r[i.b].i; break;
+		case LOR: r[i.dst].i = r[i.a].i || r[i.b].i; break;
+		case EQ: r[i.dst].i = r[i.a].i == r[i.b].i; break;
+		case LT: r[i.dst].i = r[i.a].i < r[i.b].i; break;
+		case GT: r[i.dst].i = r[i.a].i > r[i.b].i; break;
+		case LE: r[i.dst].i = r[i.a].i <= r[i.b].i; break;
+		case GE: r[i.dst].i = r[i.a].i >= r[i.b].i; break;
+		case NE: r[i.dst].i = r[i.a].i != r[i.b].i; break;
+		case NEG: r[i.dst].i = -(uint64_t)r[i.a].i; break;
+		case NOT: r[i.dst].i = !r[i.a].i; break;
+		case BNOT: r[i.dst].i = ~r[i.a].i; break;
+		case FADD: r[i.dst].f = r[i.a].f + r[i.b].f; break;
+		case FSUB: r[i.dst].f = r[i.a].f - r[i.b].f; break;
+		case FMUL: r[i.dst].f = r[i.a].f * r[i.b].f; break;
+		case FDIV: r[i.dst].f = r[i.a].f / r[i.b].f; break;
+		case FLAND: r[i.dst].f = r[i.a].f && r[i.b].f; break;
+		case FLOR: r[i.dst].f = r[i.a].f || r[i.b].f; break;
+		case FEQ: r[i.dst].f = r[i.a].f == r[i.b].f; break;
+		case FLT: r[i.dst].f = r[i.a].f < r[i.b].f; break;
+		case FGT: r[i.dst].f = r[i.a].f > r[i.b].f; break;
+		case FLE: r[i.dst].f = r[i.a].f <= r[i.b].f; break;
+		case FGE: r[i.dst].f = r[i.a].f >= r[i.b].f; break;
+		case FNE: r[i.dst].f = r[i.a].f != r[i.b].f; break;
+		case FNEG: r[i.dst].f = -r[i.a].f; break;
+		case FNOT: r[i.dst].f = !r[i.a].f; break;
+		case JMP: pc = i.a; break;
+		case JZ:
+			if(!r[i.dst].i) pc = i.a;
+			break;
+		case FJZ:
+			if(!r[i.dst].f) pc = i.a;
+			break;
+		case CALL: {
+			const Func &callee = funcs[i.a];
+			size_t calleebase  = base + fn.regcount;
+			if(stack.size() < calleebase + callee.regcount) {
+				stack.resize(calleebase + callee.regcount);
+				r = stack.data() + base;
+			}
+			for(size_t a = 0; a < callee.argflt.size(); ++a) {
+				stack[calleebase + a] = r[i.b + a];
+			}
+			Reg ret;
+			if(!exec(i.a, calleebase, ret)) goto end;
+			r	   = stack.data() + base; // stack may have been reallocated
+			r[i.dst] = ret;
+			break;
+		}
+		case RETURN:
+			res = r[i.dst];
+			ok  = true;
+			goto end;
+		case FAIL: goto end;
+		}
+	}
+end:
+	--depth;
+	return ok;
+}
+
+bool ComptimeVM::call(Context &c, StmtFnDef *def, const Vector<Stmt *> &args, Value *&res)
+{
+	size_t fnidx;
+	if(!getFunc(def, fnidx)) return false;
+	const Func &fn = funcs[fnidx];
+	if(fn.argflt.size() != args.size()) return false;
+	if(stack.size() < fn.regcount) stack.resize(fn.regcount);
+	for(size_t i = 0; i < args.size(); ++i) {
+		Value *v = args[i]->getVal();
+		if(!v || !v->hasData()) return false;
+		if(fn.argflt[i] && v->isFlt()) stack[i].f = as<FltVal>(v)->getVal();
+		else if(!fn.argflt[i] && v->isInt()) stack[i].i = as<IntVal>(v)->getVal();
+		else return false;
+	}
+	Reg out;
+	if(!exec(fnidx, 0, out)) return false;
+	if(fn.retflt) res = FltVal::create(c, CDTRUE, out.f);
+	else res = IntVal::create(c, CDTRUE, out.i);
+	return true;
+}
+} // namespace sc
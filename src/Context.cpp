@@ -5,9 +5,13 @@
 
 // #define MEM_COUNT
 
+#define STMT_CHUNK_SIZE (64 * 1024)
+
 namespace sc
 {
-Context::Context(RAIIParser *parser) : parser(parser) {}
+Context::Context(RAIIParser *parser)
+	: stmtchunkpos(STMT_CHUNK_SIZE), stmtbytes(0), visitepoch(0), parser(parser)
+{}
 Context::~Context()
 {
 #ifdef MEM_COUNT
@@ -23,8 +27,9 @@ Context::~Context()
 #ifdef MEM_COUNT
 		++s2;
 #endif
-		delete s;
+		s->~Stmt();
 	}
+	for(auto &c : stmtchunks) delete[] c;
 	for(auto &t : typemem) {
 #ifdef MEM_COUNT
 		++t1;
@@ -39,8 +44,8 @@ Context::~Context()
 	}
 #ifdef MEM_COUNT
 	printf("Total deallocation:\nStrings: %zu\nModLocs:"
-	       " %zu\nStmts: %zu\nTypes: %zu\nVals: %zu\n",
-	       s1, l1, s2, t1, v1);
+	       " %zu\nStmts: %zu (%zu bytes)\nStmt chunks: %zu\nTypes: %zu\nVals: %zu\n",
+	       s1, l1, s2, stmtbytes, stmtchunks.size(), t1, v1);
 #endif
 }
 
@@ -90,6 +95,18 @@ StringRef Context::strFrom(uint64_t i)
 	return stringmem.front();
 }
 #endif // __APPLE__
+void *Context::allocStmtChunk(size_t sz, size_t align)
+{
+	stmtchunkpos = (stmtchunkpos + align - 1) & ~(align - 1);
+	if(stmtchunkpos + sz > STMT_CHUNK_SIZE) {
+		stmtchunks.push_back(new char[STMT_CHUNK_SIZE]);
+		stmtchunkpos = 0;
+	}
+	void *res = stmtchunks.back() + stmtchunkpos;
+	stmtchunkpos += sz;
+	stmtbytes += sz;
+	return res;
+}
 ModuleLoc *Context::allocModuleLoc(Module *mod, size_t line, size_t col)
 {
 	modlocmem.emplace_front(mod, line, col);
@@ -5,8 +5,10 @@ namespace sc
 DeferStack::DeferStack() {}
 Vector<Stmt *> DeferStack::getTopStmts(Context &c)
 {
-	Vector<Stmt *> res = stack.back().back();
-	for(auto &s : res) s = s->clone(c);
+	// the frame is popped right after its end is reached, so this is the last use of its
+	// statements which can be moved out instead of being cloned
+	Vector<Stmt *> res = std::move(stack.back().back());
+	stack.back().back().clear();
 	return res;
 }
 Vector<Stmt *> DeferStack::getAllStmts(Context &c)
@@ -0,0 +1,155 @@
+#include "IR.hpp"
+
+namespace sc
+{
+const char *getInstrTyCString(InstrTy ty)
+{
+	switch(ty) {
+	case ENTRYPOINT: return "entryPoint";
+	case CONSTDATA: return "constData";
+	case CREATEVAR: return "createVar";
+	case CREATESTRUCT: return "createStruct";
+	case CREATEFN: return "createFn";
+	case CALL: return "call";
+	case BASICBLOCK: return "basicBlock";
+	case INITSTRUCT: return "initStruct";
+	case RETURN: return "return";
+	case DOT: return "dot";
+	case LOOP: return "loop";
+	case JMP: return "jmp";
+	case JMPTRUE: return "jmpTrue";
+	case JMPFALSE: return "jmpFalse";
+	case BINOP: return "binop";
+	case UNOP: return "unop";
+	case MULHI: return "mulhi";
+	case PTR: return "ptr";
+	case REF: return "ref";
+	case CONST: return "const";
+	case IMM: return "imm";
+	case ARG: return "arg";
+	case ADDR: return "addr";
+	case LOAD: return "load";
+	case STORE: return "store";
+	case COPY: return "copy";
+	case CAST: return "cast";
+	case INVALID: return "invalid";
+	}
+	return "";
+}
+
+IRInstr::IRInstr(InstrTy ty)
+	: ty(ty), res(0), blk(0), bits(0), sign(false), indirect(false), variadic(false),
+	  oper(lex::INVALID), imm(0)
+{}
+
+String IRInstr::toStr() const
+{
+	String res;
+	if(ty == BASICBLOCK) {
+		res = ".bb";
+		res += std::to_string(blk);
+		res += ":";
+		return res;
+	}
+	res = "\t";
+	if(this->res) {
+		res += "%";
+		res += std::to_string(this->res);
+		res += " = ";
+	}
+	res += getInstrTyCString(ty);
+	switch(ty) {
+	case BINOP:
+	case UNOP:
+		res += " \"";
+		res += lex::TokStrs[oper];
+		res += "\"";
+		break;
+	case LOAD:
+	case STORE:
+	case CAST:
+		res += sign ? " i" : " u";
+		res += std::to_string(bits);
+		break;
+	case IMM:
+	case DOT:
+	case COPY:
+	case CREATEVAR:
+		res += " ";
+		res += std::to_string(imm);
+		break;
+	case ARG: res += " " + std::to_string(blk); break;
+	case JMP:
+	case JMPTRUE:
+	case JMPFALSE: res += " .bb" + std::to_string(blk); break;
+	case CALL:
+	case ADDR:
+		if(!name.empty()) {
+			res += " ";
+			res += name;
+		}
+		if(variadic) res += " variadic";
+		break;
+	default: break;
+	}
+	for(size_t i = 0; i < args.size(); ++i) {
+		res += i == 0 ? " %" : ", %";
+		res += std::to_string(args[i]);
+	}
+	return res;
+}
+
+String IRGlobal::toStr() const
+{
+	String res = "global ";
+	res += name;
+	res += " [size: " + std::to_string(data.size());
+	res += ", align: " + std::to_string(align) + "]";
+	for(auto &r : relocs) {
+		res += " (";
+		res += std::to_string(r.first);
+		res += " -> ";
+		res += r.second;
+		res += ")";
+	}
+	return res;
+}
+
+IRFunc::IRFunc(StringRef name, bool exported)
+	: name(name), regcount(1), blkcount(0), exported(exported), inlinable(false)
+{}
+
+String IRFunc::toStr() const
+{
+	String res = "createFn ";
+	res += name;
+	if(inlinable) res += " inline";
+	res += " {";
+	for(auto &i : instrs) {
+		res += "\n";
+		res += i.toStr();
+	}
+	res += "\n}";
+	return res;
+}
+
+String IRModule::toStr() const
+{
+	String res;
+	for(auto &g : globals) {
+		res += g.toStr();
+		res += "\n";
+	}
+	if(!globals.empty()) res += "\n";
+	for(auto &f : funcs) {
+		res += f.toStr();
+		res += "\n\n";
+	}
+	if(!entry.empty()) {
+		res += "entryPoint ";
+		res += entry;
+		res += "\n";
+	}
+	return res;
+}
+} // namespace sc
@@ -330,6 +330,8 @@ static size_t SizeOf(Type *ty)
 	if(ty->isFlt()) {
 		return as<FltTy>(ty)->getBits() / 8;
 	}
+	// function pointer
+	if(ty->isFunc()) return sizeof(void *);
 	if(ty->isStruct()) {
 		StructTy *st   = as<StructTy>(ty);
 		size_t sz      = 0;
@@ -355,14 +355,23 @@ bool Tokenizer::tokenize(StringRef data, Vector<Lexeme> &toks)
 						  fltval);
 				continue;
 			}
-			int64_t intval;
 			if(num.size() > 2 && base != 10) {
 				// base of 8: starts with 0 => 0755
 				// everything else: starts with 0 and letter
 				num = num.substr(base == 8 ? 1 : 2);
 			}
-			std::from_chars(num.data(), num.data() + num.size(), intval, base);
-			toks.emplace_back(locAlloc(line, i - line_start - num.size()), intval);
+			// literals are bit patterns, so all 64 bits can be used (0xffffffffffffffff,
+			// 18446744073709551615)
+			uint64_t uintval = 0;
+			std::from_chars_result res =
+			std::from_chars(num.data(), num.data() + num.size(), uintval, base);
+			if(res.ec != std::errc()) {
+				err::out(loc(line, i - line_start - num.size()),
+					 "integer literal does not fit in 64 bits: ", num);
+				return false;
+			}
+			toks.emplace_back(locAlloc(line, i - line_start - num.size()),
+					  (int64_t)uintval);
 			continue;
 		}
 
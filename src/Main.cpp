@@ -1,14 +1,18 @@
+#include <algorithm>
 #include <cstring>
 #include <iostream>
+#include <memory>
 #include <stdexcept>
 
 #include "Args.hpp"
 #include "Builder.hpp"
 #include "CodeGen/C.hpp"
+#include "CodeGen/X86_64.hpp"
 #include "Config.hpp"
 #include "Env.hpp"
 #include "FS.hpp"
 #include "Parser.hpp"
+#include "Passes/TypeAssign.hpp"
 
 using namespace sc;
 
@@ -27,7 +31,9 @@ int main(int argc, char **argv)
 	args.add("opt").setShort("O").setValReqd(true).setHelp("set optimization level");
 	args.add("std").setShort("std").setValReqd(true).setHelp("set C standard");
 	args.add("llir").setShort("llir").setHelp("emit LLVM IR (C backend)");
+	args.add("lines").setShort("L").setHelp("map generated C code to scribe sources (#line)");
 	args.add("verbose").setShort("V").setHelp("show verbose compiler output");
+	args.add("native").setShort("N").setHelp("use native x86_64 backend (cc only assembles + links)");
 	args.parse();
 
 	if(args.has("help")) {
@@ -66,9 +72,11 @@ int BuildRunProj(args::ArgParser &args, bool buildonly)
 	parser.dumpParseTree(false);
 	if(args.has("nofile")) return 0;
 
-	CDriver cdriver(parser);
+	std::unique_ptr<CodeGenDriver> driver;
+	if(args.has("native")) driver.reset(new X86_64Driver(parser));
+	else driver.reset(new CDriver(parser));
 	StringRef outfile = "./build/builder";
-	if(!cdriver.compile(outfile)) return 1;
+	if(!driver->compile(outfile)) return 1;
 	String cmd = "./build/builder .";
 	auto argv  = args.getArgv();
 	// append everything to cmd after build/run
@@ -96,10 +104,29 @@ int CompileFile(args::ArgParser &args, String &file)
 	if(args.has("nofile")) return 0;
 
 	// TODO: make proper log system
-	if(args.has("verbose"))
+	if(args.has("verbose")) {
 		std::cout << "total read lines: " << fs::getLastTotalLines() << "\n";
+		TypeAssignPass *tpass = parser.getContext().getPass<TypeAssignPass>();
+		std::cout << "inline for-loops unrolled: " << tpass->getUnrolledLoops() << " ("
+			  << tpass->getUnrolledIters() << " iterations, " << tpass->getUnrolledStmts()
+			  << " stmts kept, " << tpass->getPrunedStmts() << " stmts pruned)\n";
+		Vector<std::pair<StringRef, CloneStats>> clonestats(tpass->getCloneStats().begin(),
+								    tpass->getCloneStats().end());
+		std::sort(clonestats.begin(), clonestats.end(), [](auto &a, auto &b) {
+			return a.second.bytes > b.second.bytes;
+		});
+		std::cout << "stmt clones (top " << std::min(clonestats.size(), (size_t)10)
+			  << " by bytes):\n";
+		for(size_t i = 0; i < clonestats.size() && i < 10; ++i) {
+			CloneStats &cs = clonestats[i].second;
+			std::cout << "  " << clonestats[i].first << ": " << cs.clones << " clones, "
+				  << cs.stmts << " stmts, " << cs.bytes << " bytes\n";
+		}
+	}
 
-	CDriver cdriver(parser);
+	std::unique_ptr<CodeGenDriver> driver;
+	if(args.has("native")) driver.reset(new X86_64Driver(parser));
+	else driver.reset(new CDriver(parser));
 	String outfile = String(args.get(2));
 	if(outfile.empty()) {
 		char f[2048] = {0};
@@ -108,6 +135,6 @@ int CompileFile(args::ArgParser &args, String &file)
 	}
 	auto ext = outfile.find_last_of('.');
 	if(ext != String::npos) outfile = outfile.substr(0, ext);
-	if(!cdriver.compile(outfile)) return 1;
+	if(!driver->compile(outfile)) return 1;
 	return 0;
 }
\ No newline at end of file
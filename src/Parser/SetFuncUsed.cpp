@@ -6,12 +6,11 @@ namespace sc
 //////////////////////////////////////////// StmtBlock ////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
-void StmtBlock::_setFuncUsed(bool inc, Set<Stmt *> &done)
+void StmtBlock::_setFuncUsed(bool inc, uint32_t epoch)
 {
-	if(done.find(this) != done.end()) return;
-	done.insert(this);
+	if(!markVisited(epoch)) return;
 	for(auto &stmt : stmts) {
-		stmt->_setFuncUsed(inc, done);
+		stmt->_setFuncUsed(inc, epoch);
 	}
 }
 
@@ -19,24 +18,22 @@ void StmtBlock::_setFuncUsed(bool inc, Set<Stmt *> &done)
 //////////////////////////////////////////// StmtType /////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
-void StmtType::_setFuncUsed(bool inc, Set<Stmt *> &done)
+void StmtType::_setFuncUsed(bool inc, uint32_t epoch)
 {
-	if(done.find(this) != done.end()) return;
-	done.insert(this);
-	expr->_setFuncUsed(inc, done);
+	if(!markVisited(epoch)) return;
+	expr->_setFuncUsed(inc, epoch);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////// StmtSimple /////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
-void StmtSimple::_setFuncUsed(bool inc, Set<Stmt *> &done)
+void StmtSimple::_setFuncUsed(bool inc, uint32_t epoch)
 {
-	if(done.find(this) != done.end()) return;
-	done.insert(this);
+	if(!markVisited(epoch)) return;
 	if(getTy() && getTy()->isFunc()) {
 		FuncTy *t = as<FuncTy>(getTy());
-		if(t->getVar()) t->getVar()->_setFuncUsed(inc, done);
+		if(t->getVar()) t->getVar()->_setFuncUsed(inc, epoch);
 	}
 }
 
@@ -44,12 +41,11 @@ void StmtSimple::_setFuncUsed(bool inc, Set<Stmt *> &done)
 //////////////////////////////////////// StmtFnCallInfo ///////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
-void StmtFnCallInfo::_setFuncUsed(bool inc, Set<Stmt *> &done)
+void StmtFnCallInfo::_setFuncUsed(bool inc, uint32_t epoch)
 {
-	if(done.find(this) != done.end()) return;
-	done.insert(this);
+	if(!markVisited(epoch)) return;
 	for(auto &a : args) {
-		a->_setFuncUsed(inc, done);
+		a->_setFuncUsed(inc, epoch);
 	}
 }
 
@@ -57,16 +53,15 @@ void StmtFnCallInfo::_setFuncUsed(bool inc, Set<Stmt *> &done)
 //////////////////////////////////////////// StmtExpr /////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
-void StmtExpr::_setFuncUsed(bool inc, Set<Stmt *> &done)
+void StmtExpr::_setFuncUsed(bool inc, uint32_t epoch)
 {
-	if(done.find(this) != done.end()) return;
-	done.insert(this);
-	lhs->_setFuncUsed(inc, done);
-	if(rhs) rhs->_setFuncUsed(inc, done);
+	if(!markVisited(epoch)) return;
+	lhs->_setFuncUsed(inc, epoch);
+	if(rhs) rhs->_setFuncUsed(inc, epoch);
 	if(calledfn && calledfn->getVar() && calledfn->getVar()->getVVal() &&
 	   calledfn->getVar()->getVVal()->isFnDef())
 	{
-		calledfn->getVar()->_setFuncUsed(inc, done);
+		calledfn->getVar()->_setFuncUsed(inc, epoch);
 	}
 }
 
@@ -74,120 +69,110 @@ void StmtExpr::_setFuncUsed(bool inc, Set<Stmt *> &done)
 //////////////////////////////////////////// StmtVar //////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
-void StmtVar::_setFuncUsed(bool inc, Set<Stmt *> &done)
+void StmtVar::_setFuncUsed(bool inc, uint32_t epoch)
 {
-	if(done.find(this) != done.end()) return;
-	done.insert(this);
-	if(vtype) vtype->_setFuncUsed(inc, done);
-	if(vval) vval->_setFuncUsed(inc, done);
+	if(!markVisited(epoch)) return;
+	if(vtype) vtype->_setFuncUsed(inc, epoch);
+	if(vval) vval->_setFuncUsed(inc, epoch);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////// StmtFnSig ////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
-void StmtFnSig::_setFuncUsed(bool inc, Set<Stmt *> &done)
+void StmtFnSig::_setFuncUsed(bool inc, uint32_t epoch)
 {
-	if(done.find(this) != done.end()) return;
-	done.insert(this);
-	for(auto &a : args) a->_setFuncUsed(inc, done);
-	if(rettype) rettype->_setFuncUsed(inc, done);
+	if(!markVisited(epoch)) return;
+	for(auto &a : args) a->_setFuncUsed(inc, epoch);
+	if(rettype) rettype->_setFuncUsed(inc, epoch);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////// StmtFnDef ////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
-void StmtFnDef::_setFuncUsed(bool inc, Set<Stmt *> &done)
+void StmtFnDef::_setFuncUsed(bool inc, uint32_t epoch)
 {
-	if(done.find(this) != done.end()) return;
-	done.insert(this);
+	if(!markVisited(epoch)) return;
 	if(!inc) {
 		if(used > 0) --used;
 	} else {
 		++used;
 	}
-	sig->_setFuncUsed(inc, done);
-	if(blk) blk->_setFuncUsed(inc, done);
+	sig->_setFuncUsed(inc, epoch);
+	if(blk) blk->_setFuncUsed(inc, epoch);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////// StmtHeader /////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
-void StmtHeader::_setFuncUsed(bool inc, Set<Stmt *> &done)
+void StmtHeader::_setFuncUsed(bool inc, uint32_t epoch)
 {
-	if(done.find(this) != done.end()) return;
-	done.insert(this);
+	if(!markVisited(epoch)) return;
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////// StmtLib //////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
-void StmtLib::_setFuncUsed(bool inc, Set<Stmt *> &done)
+void StmtLib::_setFuncUsed(bool inc, uint32_t epoch)
 {
-	if(done.find(this) != done.end()) return;
-	done.insert(this);
+	if(!markVisited(epoch)) return;
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////// StmtExtern /////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
-void StmtExtern::_setFuncUsed(bool inc, Set<Stmt *> &done)
+void StmtExtern::_setFuncUsed(bool inc, uint32_t epoch)
 {
-	if(done.find(this) != done.end()) return;
-	done.insert(this);
-	if(headers) headers->_setFuncUsed(inc, done);
-	if(libs) libs->_setFuncUsed(inc, done);
-	entity->_setFuncUsed(inc, done);
+	if(!markVisited(epoch)) return;
+	if(headers) headers->_setFuncUsed(inc, epoch);
+	if(libs) libs->_setFuncUsed(inc, epoch);
+	entity->_setFuncUsed(inc, epoch);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 /////////////////////////////////////////// StmtEnum //////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
-void StmtEnum::_setFuncUsed(bool inc, Set<Stmt *> &done)
+void StmtEnum::_setFuncUsed(bool inc, uint32_t epoch)
 {
-	if(done.find(this) != done.end()) return;
-	done.insert(this);
-	if(tagty) tagty->_setFuncUsed(inc, done);
+	if(!markVisited(epoch)) return;
+	if(tagty) tagty->_setFuncUsed(inc, epoch);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////// StmtStruct //////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
-void StmtStruct::_setFuncUsed(bool inc, Set<Stmt *> &done)
+void StmtStruct::_setFuncUsed(bool inc, uint32_t epoch)
 {
-	if(done.find(this) != done.end()) return;
-	done.insert(this);
-	for(auto &f : fields) f->_setFuncUsed(inc, done);
+	if(!markVisited(epoch)) return;
+	for(auto &f : fields) f->_setFuncUsed(inc, epoch);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////// StmtVarDecl /////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
-void StmtVarDecl::_setFuncUsed(bool inc, Set<Stmt *> &done)
+void StmtVarDecl::_setFuncUsed(bool inc, uint32_t epoch)
 {
-	if(done.find(this) != done.end()) return;
-	done.insert(this);
-	for(auto &d : decls) d->_setFuncUsed(inc, done);
+	if(!markVisited(epoch)) return;
+	for(auto &d : decls) d->_setFuncUsed(inc, epoch);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////// StmtCond /////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
-void StmtCond::_setFuncUsed(bool inc, Set<Stmt *> &done)
+void StmtCond::_setFuncUsed(bool inc, uint32_t epoch)
 {
-	if(done.find(this) != done.end()) return;
-	done.insert(this);
+	if(!markVisited(epoch)) return;
 	for(auto &c : conds) {
-		if(c.getCond()) c.getCond()->_setFuncUsed(inc, done);
-		if(c.getBlk()) c.getBlk()->_setFuncUsed(inc, done);
+		if(c.getCond()) c.getCond()->_setFuncUsed(inc, epoch);
+		if(c.getBlk()) c.getBlk()->_setFuncUsed(inc, epoch);
 	}
 }
 
@@ -195,56 +180,51 @@ void StmtCond::_setFuncUsed(bool inc, Set<Stmt *> &done)
 //////////////////////////////////////////// StmtFor //////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
-void StmtFor::_setFuncUsed(bool inc, Set<Stmt *> &done)
+void StmtFor::_setFuncUsed(bool inc, uint32_t epoch)
 {
-	if(done.find(this) != done.end()) return;
-	done.insert(this);
-	if(init) init->_setFuncUsed(inc, done);
-	if(cond) cond->_setFuncUsed(inc, done);
-	if(incr) incr->_setFuncUsed(inc, done);
-	if(blk) blk->_setFuncUsed(inc, done);
+	if(!markVisited(epoch)) return;
+	if(init) init->_setFuncUsed(inc, epoch);
+	if(cond) cond->_setFuncUsed(inc, epoch);
+	if(incr) incr->_setFuncUsed(inc, epoch);
+	if(blk) blk->_setFuncUsed(inc, epoch);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////// StmtRet //////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
-void StmtRet::_setFuncUsed(bool inc, Set<Stmt *> &done)
+void StmtRet::_setFuncUsed(bool inc, uint32_t epoch)
 {
-	if(done.find(this) != done.end()) return;
-	done.insert(this);
-	if(val) val->_setFuncUsed(inc, done);
+	if(!markVisited(epoch)) return;
+	if(val) val->_setFuncUsed(inc, epoch);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////// StmtContinue ///////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
-void StmtContinue::_setFuncUsed(bool inc, Set<Stmt *> &done)
+void StmtContinue::_setFuncUsed(bool inc, uint32_t epoch)
 {
-	if(done.find(this) != done.end()) return;
-	done.insert(this);
+	if(!markVisited(epoch)) return;
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////// StmtBreak ////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
-void StmtBreak::_setFuncUsed(bool inc, Set<Stmt *> &done)
+void StmtBreak::_setFuncUsed(bool inc, uint32_t epoch)
 {
-	if(done.find(this) != done.end()) return;
-	done.insert(this);
+	if(!markVisited(epoch)) return;
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////// StmtDefer ////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
-void StmtDefer::_setFuncUsed(bool inc, Set<Stmt *> &done)
+void StmtDefer::_setFuncUsed(bool inc, uint32_t epoch)
 {
-	if(done.find(this) != done.end()) return;
-	done.insert(this);
-	if(val) val->_setFuncUsed(inc, done);
+	if(!markVisited(epoch)) return;
+	if(val) val->_setFuncUsed(inc, epoch);
 }
 
 } // namespace sc
\ No newline at end of file
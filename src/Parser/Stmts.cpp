@@ -4,32 +4,13 @@
 
 namespace sc
 {
-Map<uint64_t, Value *> values = {{0, nullptr}};
-uint64_t genValueID()
-{
-	static uint64_t vid = 1;
-	return vid++;
-}
-uint64_t createValueIDWith(Value *v)
-{
-	uint64_t id = genValueID();
-	values[id]  = v;
-	return id;
-}
-Value *getValWithID(uint64_t id)
-{
-	auto loc = values.find(id);
-	if(loc == values.end()) return nullptr;
-	return loc->second;
-}
-
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 /////////////////////////////////////////////// Stmt //////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
 Stmt::Stmt(const Stmts &stmt_type, const ModuleLoc *loc)
 	: loc(loc), ty(nullptr), val(nullptr), cast_to(nullptr), derefcount(0), stype(stmt_type),
-	  stmtmask(0), castmask(0)
+	  stmtmask(0), castmask(0), visited(0)
 {}
 Stmt::~Stmt() {}
 
@@ -144,7 +144,7 @@ bool SimplifyPass::visit(StmtVar *stmt, Stmt **source)
 				err::out(stmt, "multiple main functions found");
 				return false;
 			}
-			as<StmtFnDef>(stmt->getVVal())->incUsed();
+			as<StmtFnDef>(stmt->getVVal())->incUsed(ctx);
 			maindone = true;
 			stmt->getName().setDataStr("main");
 			stmt->disableCodeGenMangling();
@@ -9,7 +9,8 @@ namespace sc
 {
 TypeAssignPass::TypeAssignPass(Context &ctx)
 	: Pass(Pass::genPassID<TypeAssignPass>(), ctx), vmgr(ctx), vpass(ctx), valen(0),
-	  disabled_varname_mangling(false)
+	  disabled_varname_mangling(false), unrolled_loops(0), unrolled_iters(0), unrolled_stmts(0),
+	  pruned_stmts(0)
 {}
 TypeAssignPass::~TypeAssignPass() {}
 
@@ -78,7 +79,11 @@ bool TypeAssignPass::visit(StmtBlock *stmt, Stmt **source)
 	bool inserted_defers = false;
 	for(size_t i = 0; i < stmts.size(); ++i) {
 		if(stmts[i]->isReturn() && !inserted_defers) {
+			size_t stmtcount	= ctx.getStmtCount();
+			size_t stmtbytes	= ctx.getStmtBytes();
 			Vector<Stmt *> deferred = deferstack.getAllStmts(ctx);
+			addCloneStats("<defer>", ctx.getStmtCount() - stmtcount,
+				      ctx.getStmtBytes() - stmtbytes);
 			stmts.insert(stmts.begin() + i, deferred.begin(), deferred.end());
 			inserted_defers = true;
 			--i;
@@ -123,9 +128,18 @@ bool TypeAssignPass::visit(StmtBlock *stmt, Stmt **source)
 bool TypeAssignPass::visit(StmtType *stmt, Stmt **source)
 {
 	// TODO: add array type
-	if(!visit(stmt->getExpr(), &stmt->getExpr()) ||
-	   (!stmt->getExpr()->getVal() && !stmt->getExpr()->getTy()))
-	{
+	// arguments of a function type must not leak into the enclosing scope (say, a struct
+	// with multiple function fields) and must not re-enable mangling of the enclosing names
+	bool is_fnsig	     = stmt->getExpr()->isFnSig();
+	bool prev_mangle_off = disabled_varname_mangling;
+	if(is_fnsig) vmgr.pushLayer();
+	bool ok = visit(stmt->getExpr(), &stmt->getExpr()) &&
+		  (stmt->getExpr()->getVal() || stmt->getExpr()->getTy());
+	if(is_fnsig) {
+		vmgr.popLayer();
+		disabled_varname_mangling = prev_mangle_off;
+	}
+	if(!ok) {
 		err::out(stmt, "failed to determine type of type-expr");
 		return false;
 	}
@@ -223,16 +237,17 @@ bool TypeAssignPass::visit(StmtSimple *stmt, Stmt **source)
 		StmtVar *decl  = nullptr;
 		Module *mod    = stmt->getMod();
 		StringRef name = stmt->getLexValue().getDataStr();
-		VarDecl *res   = nullptr;
+		VarDecl res;
+		bool found = false;
 		if(!stmt->isModuleIDManglingDisabled()) {
 			StringRef mangled_name = getMangledName(stmt, name);
-			res		       = vmgr.getAll(mangled_name, false);
-			if(res) stmt->updateLexDataStr(mangled_name);
+			found		       = vmgr.getAll(mangled_name, false, res);
+			if(found) stmt->updateLexDataStr(mangled_name);
 		}
-		if(!res) res = vmgr.getAll(name, false);
-		if(!res) break; // error out - undefined variable
-		stmt->setTyVal(res->ty, res->val);
-		decl = res->decl;
+		if(!found) found = vmgr.getAll(name, false, res);
+		if(!found) break; // error out - undefined variable
+		stmt->setTyVal(res.ty, res.val);
+		decl = res.decl;
 		stmt->disableModuleIDMangling();
 		stmt->setDecl(decl);
 		if(decl) {
@@ -351,6 +366,13 @@ bool TypeAssignPass::visit(StmtExpr *stmt, Stmt **source)
 		assert(lhs->isSimple() && "LHS must be a simple expression for function call");
 		assert(rhs && rhs->isFnCallInfo() &&
 		       "RHS must be function call info for a function call");
+		// a variable of function type which is not bound to a known function
+		// (say, a struct field copied to a local variable) is a function pointer
+		if(!lhs->getVal() && lhs->getTy() && lhs->getTy()->isFunc() &&
+		   !as<FuncTy>(lhs->getTy())->getVar())
+		{
+			lhs->setVal(FuncVal::create(ctx, as<FuncTy>(lhs->getTy())));
+		}
 		// not using getVal() here as a struct def is not contained in it
 		// a struct def = getVal()->isType() && getTy()->isStruct()
 		if(!lhs->getVal() || !(lhs->getVal()->isFunc() ||
@@ -803,9 +825,10 @@ post_mangling:
 		}
 	}
 	if(!stmt->isIn() && vmgr.exists(stmt->getName().getDataStr(), true)) {
-		VarDecl *d = vmgr.getAll(stmt->getName().getDataStr(), true);
-		if(!d->val || !d->val->isType() || !d->ty->isStruct() ||
-		   !(as<StructTy>(d->ty)->getDecl() && as<StructTy>(d->ty)->getDecl()->isDecl()))
+		VarDecl d;
+		vmgr.getAll(stmt->getName().getDataStr(), true, d);
+		if(!d.val || !d.val->isType() || !d.ty->isStruct() ||
+		   !(as<StructTy>(d.ty)->getDecl() && as<StructTy>(d.ty)->getDecl()->isDecl()))
 		{
 			err::out(stmt->getName(), "variable '", stmt->getName().getDataStr(),
 				 "' already exists in scope");
@@ -1136,7 +1159,6 @@ bool TypeAssignPass::visit(StmtFor *stmt, Stmt **source)
 	Stmt *&incr	    = stmt->getIncr();
 	StmtBlock *&blk	    = stmt->getBlk();
 	StmtBlock *finalblk = nullptr;
-	Vector<Stmt *> newblkstmts;
 
 	vmgr.pushLayer();
 	if(init && !visit(init, &init)) {
@@ -1179,14 +1201,36 @@ bool TypeAssignPass::visit(StmtFor *stmt, Stmt **source)
 			       " ensure relevant variables are comptime");
 		return false;
 	}
-	if(init) newblkstmts.push_back(init->clone(ctx));
+	vmgr.popLayer();
+
+	// The body is unrolled (and type assigned) one iteration at a time, so the statements of
+	// dead inline conditionals are discarded right away instead of first being cloned for
+	// every iteration. This replicates what visit(StmtBlock) does for the unrolled block.
+	finalblk		    = blk;
+	stmt->getBlk()		    = nullptr;
+	Vector<Stmt *> &newblkstmts = finalblk->getStmts();
+	Vector<Stmt *> body	    = std::move(newblkstmts);
+	bool inserted_defers	    = false;
+	newblkstmts.clear();
+	vmgr.pushLayer();
+	deferstack.pushFrame();
+	StringRef statname = "<inline for>";
+	if(init && !unrollStmt(stmt, newblkstmts, cloneStmt(init, statname), inserted_defers)) {
+		return false;
+	}
 	while((cond->getVal()->isInt() && as<IntVal>(cond->getVal())->getVal()) ||
 	      (cond->getVal()->isFlt() && as<FltVal>(cond->getVal())->getVal()))
 	{
-		for(auto &s : blk->getStmts()) {
-			newblkstmts.push_back(s->clone(ctx));
+		for(auto &s : body) {
+			if(!unrollStmt(stmt, newblkstmts, cloneStmt(s, statname), inserted_defers)) {
+				return false;
+			}
 		}
-		if(incr) newblkstmts.push_back(incr->clone(ctx));
+		if(incr && !unrollStmt(stmt, newblkstmts, cloneStmt(incr, statname), inserted_defers))
+		{
+			return false;
+		}
+		++unrolled_iters;
 		if(incr && !vpass.visit(incr, &incr)) {
 			err::out(stmt, "failed to determine value of inline for-loop incr");
 			return false;
@@ -1196,16 +1240,41 @@ bool TypeAssignPass::visit(StmtFor *stmt, Stmt **source)
 			return false;
 		}
 	}
-	blk->getStmts() = newblkstmts;
-	finalblk	= blk;
-	stmt->getBlk()	= nullptr;
-	*source		= finalblk;
+	if(!inserted_defers) {
+		for(auto &d : deferstack.getTopStmts(ctx)) {
+			if(!unrollStmt(stmt, newblkstmts, d, inserted_defers)) return false;
+		}
+	}
+	deferstack.popFrame();
 	vmgr.popLayer();
-	if(!visit(*source, source)) {
-		err::out(*source, "failed to determine type of inlined for-loop block");
+	++unrolled_loops;
+	*source = finalblk;
+	(*source)->clearValue();
+	return true;
+}
+bool TypeAssignPass::unrollStmt(StmtFor *loop, Vector<Stmt *> &stmts, Stmt *stmt,
+				bool &inserted_defers)
+{
+	if(stmt->isReturn() && !inserted_defers) {
+		inserted_defers		= true;
+		size_t stmtcount	= ctx.getStmtCount();
+		size_t stmtbytes	= ctx.getStmtBytes();
+		Vector<Stmt *> deferred = deferstack.getAllStmts(ctx);
+		addCloneStats("<defer>", ctx.getStmtCount() - stmtcount, ctx.getStmtBytes() - stmtbytes);
+		for(auto &d : deferred) {
+			if(!unrollStmt(loop, stmts, d, inserted_defers)) return false;
+		}
+	}
+	if(!visit(stmt, &stmt)) {
+		err::out(loop, "failed to determine type of inlined for-loop block");
 		return false;
 	}
-	(*source)->clearValue();
+	if(!stmt) {
+		++pruned_stmts;
+		return true;
+	}
+	stmts.push_back(stmt);
+	++unrolled_stmts;
 	return true;
 }
 bool TypeAssignPass::visit(StmtRet *stmt, Stmt **source)
@@ -1330,6 +1399,30 @@ bool TypeAssignPass::chooseSuperiorPrimitiveType(Type *l, Type *r)
 	return true;
 }
 
+void TypeAssignPass::addCloneStats(StringRef name, size_t stmts, size_t bytes)
+{
+	CloneStats &stats = clonestats[name];
+	++stats.clones;
+	stats.stmts += stmts;
+	stats.bytes += bytes;
+}
+Stmt *TypeAssignPass::cloneCounted(Stmt *stmt, size_t &stmts, size_t &bytes)
+{
+	size_t stmtcount = ctx.getStmtCount();
+	size_t stmtbytes = ctx.getStmtBytes();
+	Stmt *res	 = stmt->clone(ctx);
+	stmts += ctx.getStmtCount() - stmtcount;
+	bytes += ctx.getStmtBytes() - stmtbytes;
+	return res;
+}
+Stmt *TypeAssignPass::cloneStmt(Stmt *stmt, StringRef statname)
+{
+	size_t stmts = 0, bytes = 0;
+	Stmt *res    = cloneCounted(stmt, stmts, bytes);
+	addCloneStats(statname, stmts, bytes);
+	return res;
+}
+
 bool TypeAssignPass::initTemplateFunc(Stmt *caller, FuncTy *&cf, Vector<Stmt *> &args)
 {
 	static Map<StringRef, StmtVar *> alreadytemplated;
@@ -1358,8 +1451,11 @@ bool TypeAssignPass::initTemplateFunc(Stmt *caller, FuncTy *&cf, Vector<Stmt *>
 		cfdef->setBlk(nullptr);
 	}
 	StmtVar *origcfvar = cfvar;
-	cfvar		   = as<StmtVar>(cfvar->clone(ctx)); // template must be cloned
-	StmtFnSig *cfsig   = nullptr;
+	// clone stats only count the stmts allocated by the clones below
+	size_t clonedstmts = 0, clonedbytes = 0;
+	// template must be cloned
+	cfvar		 = as<StmtVar>(cloneCounted(cfvar, clonedstmts, clonedbytes));
+	StmtFnSig *cfsig = nullptr;
 	cf->setVar(cfvar);
 	if(cfvar->getVVal()->isFnDef()) {
 		StmtFnDef *cfdef = as<StmtFnDef>(cfvar->getVVal());
@@ -1383,8 +1479,17 @@ bool TypeAssignPass::initTemplateFunc(Stmt *caller, FuncTy *&cf, Vector<Stmt *>
 		StmtVar *cfa = cfsig->getArg(i);
 		Type *cft    = cf->getArg(i);
 		if(!cft->isVariadic()) {
-			Type *cftc = cft->isAny() ? args[i]->getTy() : cft;
-			cfa->setTyVal(args[i]->getTy(), args[i]->getVal());
+			Type *cftc    = cft->isAny() ? args[i]->getTy() : cft;
+			Value *argval = args[i]->getVal();
+			// the specialization is shared by all calls with the same signature,
+			// so the data of a runtime argument (from this call) must not be used in it
+			if(argval && !cf->isArgComptime(i) && !argval->isType() &&
+			   !argval->isFunc() && !argval->isNamespace())
+			{
+				argval = argval->clone(ctx);
+				argval->clearHasData();
+			}
+			cfa->setTyVal(args[i]->getTy(), argval);
 			if(args[i]->getCast()) {
 				cfa->castTo(args[i]->getCast(), args[i]->getCastStmtMask());
 			}
@@ -1410,7 +1515,7 @@ bool TypeAssignPass::initTemplateFunc(Stmt *caller, FuncTy *&cf, Vector<Stmt *>
 		while(i < args.size()) {
 			StringRef argn =
 			ctx.strFrom({va_name.getDataStr(), "__", ctx.strFrom(va_count)});
-			StmtVar *newv = as<StmtVar>(cfa->clone(ctx));
+			StmtVar *newv = as<StmtVar>(cloneCounted(cfa, clonedstmts, clonedbytes));
 			newv->getVType()->unsetVariadic();
 			newv->getName().setDataStr(argn);
 			Type *t = args[i]->getTy()->specialize(ctx);
@@ -1446,9 +1551,10 @@ bool TypeAssignPass::initTemplateFunc(Stmt *caller, FuncTy *&cf, Vector<Stmt *>
 	}
 	if(cfblk) {
 		as<StmtFnDef>(origcfvar->getVVal())->setBlk(cfblk);
-		cfblk = as<StmtBlock>(cfblk->clone(ctx));
+		cfblk = as<StmtBlock>(cloneCounted(cfblk, clonedstmts, clonedbytes));
 		as<StmtFnDef>(cfvar->getVVal())->setBlk(cfblk);
 	}
+	addCloneStats(origcfvar->getName().getDataStr(), clonedstmts, clonedbytes);
 	if(!cfblk) {
 		err::out(caller, "function definition for specialization has no block");
 		return false;
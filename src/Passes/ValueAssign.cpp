@@ -2,39 +2,52 @@
 
 namespace sc
 {
-static bool break_stmt	  = false;
-static bool continue_stmt = false;
-static bool return_stmt	  = false;
-
-ValueAssignPass::ValueAssignPass(Context &ctx) : Pass(Pass::genPassID<ValueAssignPass>(), ctx) {}
+ValueAssignPass::ValueAssignPass(Context &ctx)
+	: Pass(Pass::genPassID<ValueAssignPass>(), ctx), break_stmt(false), continue_stmt(false),
+	  return_stmt(false)
+{}
 ValueAssignPass::~ValueAssignPass() {}
 
 bool ValueAssignPass::visit(Stmt *stmt, Stmt **source)
 {
+	bool res = false;
 	switch(stmt->getStmtType()) {
-	case BLOCK: return visit(as<StmtBlock>(stmt), source);
-	case TYPE: return visit(as<StmtType>(stmt), source);
-	case SIMPLE: return visit(as<StmtSimple>(stmt), source);
-	case EXPR: return visit(as<StmtExpr>(stmt), source);
-	case FNCALLINFO: return visit(as<StmtFnCallInfo>(stmt), source);
-	case VAR: return visit(as<StmtVar>(stmt), source);
-	case FNSIG: return visit(as<StmtFnSig>(stmt), source);
-	case FNDEF: return visit(as<StmtFnDef>(stmt), source);
-	case HEADER: return visit(as<StmtHeader>(stmt), source);
-	case LIB: return visit(as<StmtLib>(stmt), source);
-	case EXTERN: return visit(as<StmtExtern>(stmt), source);
-	case ENUMDEF: return visit(as<StmtEnum>(stmt), source);
-	case STRUCTDEF: return visit(as<StmtStruct>(stmt), source);
-	case VARDECL: return visit(as<StmtVarDecl>(stmt), source);
-	case COND: return visit(as<StmtCond>(stmt), source);
-	case FOR: return visit(as<StmtFor>(stmt), source);
-	case RET: return visit(as<StmtRet>(stmt), source);
-	case CONTINUE: return visit(as<StmtContinue>(stmt), source);
-	case BREAK: return visit(as<StmtBreak>(stmt), source);
-	case DEFER: return visit(as<StmtDefer>(stmt), source);
+	case BLOCK: res = visit(as<StmtBlock>(stmt), source); break;
+	case TYPE: res = visit(as<StmtType>(stmt), source); break;
+	case SIMPLE: res = visit(as<StmtSimple>(stmt), source); break;
+	case EXPR: res = visit(as<StmtExpr>(stmt), source); break;
+	case FNCALLINFO: res = visit(as<StmtFnCallInfo>(stmt), source); break;
+	case VAR: res = visit(as<StmtVar>(stmt), source); break;
+	case FNSIG: res = visit(as<StmtFnSig>(stmt), source); break;
+	case FNDEF: res = visit(as<StmtFnDef>(stmt), source); break;
+	case HEADER: res = visit(as<StmtHeader>(stmt), source); break;
+	case LIB: res = visit(as<StmtLib>(stmt), source); break;
+	case EXTERN: res = visit(as<StmtExtern>(stmt), source); break;
+	case ENUMDEF: res = visit(as<StmtEnum>(stmt), source); break;
+	case STRUCTDEF: res = visit(as<StmtStruct>(stmt), source); break;
+	case VARDECL: res = visit(as<StmtVarDecl>(stmt), source); break;
+	case COND: res = visit(as<StmtCond>(stmt), source); break;
+	case FOR: res = visit(as<StmtFor>(stmt), source); break;
+	case RET: res = visit(as<StmtRet>(stmt), source); break;
+	case CONTINUE: res = visit(as<StmtContinue>(stmt), source); break;
+	case BREAK: res = visit(as<StmtBreak>(stmt), source); break;
+	case DEFER: res = visit(as<StmtDefer>(stmt), source); break;
+	default:
+		err::out(stmt, "invalid statement found for type assignment: ",
+			 stmt->getStmtTypeCString());
+		return false;
 	}
-	err::out(stmt, "invalid statement found for type assignment: ", stmt->getStmtTypeCString());
-	return false;
+	if(!res) return false;
+	// casts between int and float convert the value (C emits comptime results as constants)
+	Stmt *s = *source;
+	if(!s || !s->getCast() || !s->getVal() || !s->getVal()->hasData()) return true;
+	Value *v = s->getVal();
+	if(s->getCast()->isFlt() && v->isInt()) {
+		s->setVal(FltVal::create(ctx, v->getHasData(), as<IntVal>(v)->getVal()));
+	} else if(s->getCast()->isInt() && v->isFlt()) {
+		s->setVal(IntVal::create(ctx, v->getHasData(), as<FltVal>(v)->getVal()));
+	}
+	return true;
 }
 
 bool ValueAssignPass::visit(StmtBlock *stmt, Stmt **source)
@@ -191,6 +204,11 @@ skip_rhs_val:
 				 defargs.size(), ", call: ", callargs.size(), ")");
 			return false;
 		}
+		Value *vmres = nullptr;
+		if(vm.call(ctx, def, callargs, vmres)) {
+			stmt->setUpdateVal(ctx, vmres);
+			break;
+		}
 		for(size_t i = 0; i < defargs.size(); ++i) {
 			Value *aval = callargs[i]->getVal();
 			def->getSigArg(i)->setUpdateVal(ctx, aval);
@@ -207,7 +225,9 @@ skip_rhs_val:
 			}
 		}
 
-		stmt->setUpdateVal(ctx, def->getBlk()->getVal());
+		// keep the result when the callee's values are cleared (like the comptime VM does)
+		Value *res = def->getBlk()->getVal();
+		stmt->setUpdateVal(ctx, stmt->getVal() ? res : res->clone(ctx));
 		def->clearValue();
 		return_stmt = false;
 		break;
@@ -254,7 +274,7 @@ skip_rhs_val:
 		}
 		VecVal *vaval = as<VecVal>(lhs->getVal());
 		IntVal *iv    = as<IntVal>(rhs->getVal());
-		if(vaval->getVal().size() <= iv->getVal()) {
+		if(vaval->size() <= iv->getVal()) {
 			err::out(stmt, "index out of bounds of pointer/array");
 			return false;
 		}
@@ -328,6 +348,11 @@ skip_rhs_val:
 			err::out(stmt, "function def and call must have same argument count");
 			return false;
 		}
+		Value *vmres = nullptr;
+		if(vm.call(ctx, def, args, vmres)) {
+			stmt->setUpdateVal(ctx, vmres);
+			break;
+		}
 		for(size_t i = 0; i < defargs.size(); ++i) {
 			Value *aval = args[i]->getVal();
 			def->getSigArg(i)->setUpdateVal(ctx, aval);
@@ -343,7 +368,9 @@ skip_rhs_val:
 				aval->updateValue(ctx, def->getSigArg(i)->getVal());
 			}
 		}
-		stmt->setUpdateVal(ctx, def->getBlk()->getVal());
+		// keep the result when the callee's values are cleared (like the comptime VM does)
+		Value *res = def->getBlk()->getVal();
+		stmt->setUpdateVal(ctx, stmt->getVal() ? res : res->clone(ctx));
 		def->clearValue();
 		return_stmt = false;
 		break;
@@ -78,20 +78,44 @@ String toRawString(StringRef data)
 
 String fromRawString(StringRef from)
 {
-	String data(from);
-	for(size_t idx = 0; idx < data.size(); ++idx) {
-		if(data[idx] != '\\') continue;
-		if(idx + 1 >= data.size()) continue;
-		data.erase(data.begin() + idx);
-		if(data[idx] == '0') data[idx] = '\0';
-		else if(data[idx] == 'a') data[idx] = '\a';
-		else if(data[idx] == 'b') data[idx] = '\b';
-		else if(data[idx] == 'e') data[idx] = '\e';
-		else if(data[idx] == 'f') data[idx] = '\f';
-		else if(data[idx] == 'n') data[idx] = '\n';
-		else if(data[idx] == 'r') data[idx] = '\r';
-		else if(data[idx] == 't') data[idx] = '\t';
-		else if(data[idx] == 'v') data[idx] = '\v';
+	String data;
+	data.reserve(from.size());
+	for(size_t idx = 0; idx < from.size(); ++idx) {
+		if(from[idx] != '\\' || idx + 1 >= from.size()) {
+			data += from[idx];
+			continue;
+		}
+		char c = from[++idx];
+		// octal (\033) and hex (\x1b) escapes, as in C
+		if(c >= '0' && c <= '7') {
+			int v = 0;
+			for(size_t i = 0; i < 3 && idx < from.size() && from[idx] >= '0' && from[idx] <= '7';
+			    ++i)
+			{
+				v = v * 8 + (from[idx++] - '0');
+			}
+			--idx;
+			data += (char)v;
+			continue;
+		}
+		if(c == 'x') {
+			int v = 0;
+			while(idx + 1 < from.size() && isxdigit(from[idx + 1])) {
+				char h = from[++idx];
+				v	 = v * 16 + (isdigit(h) ? h - '0' : tolower(h) - 'a' + 10);
+			}
+			data += (char)v;
+			continue;
+		}
+		if(c == 'a') data += '\a';
+		else if(c == 'b') data += '\b';
+		else if(c == 'e') data += '\e';
+		else if(c == 'f') data += '\f';
+		else if(c == 'n') data += '\n';
+		else if(c == 'r') data += '\r';
+		else if(c == 't') data += '\t';
+		else if(c == 'v') data += '\v';
+		else data += c;
 	}
 	return data;
 }
@@ -5,29 +5,40 @@
 namespace sc
 {
 Function::Function(FuncTy *ty) : fty(ty) {}
-bool Function::exists(StringRef name, bool top_only)
+void Function::popLayer()
 {
-	ssize_t i = layers.size() - 1;
-	while(i >= 0) {
-		if(layers[i].exists(name)) return true;
-		if(top_only) break;
-		--i;
+	// the bindings stacks are left in the table (even if empty) as the same names
+	// are usually declared again
+	for(auto &name : layers.back()) {
+		table[name].pop_back();
 	}
-	return false;
+	layers.pop_back();
 }
-VarDecl *Function::getAll(StringRef name, bool top_only)
+bool Function::add(StringRef name, Type *ty, Value *val, StmtVar *decl)
 {
-	ssize_t i = layers.size() - 1;
-	while(i >= 0) {
-		VarDecl *res = layers[i].getAll(name);
-		if(res) return res;
-		if(top_only) break;
-		--i;
-	}
-	return nullptr;
+	Vector<Binding> &bindings = table[name];
+	if(!bindings.empty() && bindings.back().layer == layers.size() - 1) return false;
+	bindings.push_back({{ty, val, decl}, layers.size() - 1});
+	layers.back().push_back(name);
+	return true;
+}
+bool Function::exists(StringRef name, bool top_only)
+{
+	auto loc = table.find(name);
+	if(loc == table.end() || loc->second.empty()) return false;
+	return !top_only || loc->second.back().layer == layers.size() - 1;
+}
+bool Function::getAll(StringRef name, bool top_only, VarDecl &res)
+{
+	auto loc = table.find(name);
+	if(loc == table.end() || loc->second.empty()) return false;
+	Binding &b = loc->second.back();
+	if(top_only && b.layer != layers.size() - 1) return false;
+	res = b.decl;
+	return true;
 }
 
-ValueManager::ValueManager(Context &c) { AddPrimitiveFuncs(c, *this); }
+ValueManager::ValueManager(Context &c) : tyfncache() { AddPrimitiveFuncs(c, *this); }
 bool ValueManager::addVar(StringRef var, Type *ty, Value *val, StmtVar *decl, bool global)
 {
 	if(!funcstack.empty()) return funcstack.back().add(var, ty, val, decl);
@@ -35,9 +46,7 @@ bool ValueManager::addVar(StringRef var, Type *ty, Value *val, StmtVar *decl, bo
 }
 bool ValueManager::addTypeFn(uint32_t id, StringRef name, FuncVal *fn)
 {
-	if(typefuncs.find(id) == typefuncs.end()) {
-		typefuncs[id] = {};
-	}
+	if(id >= typefuncs.size()) typefuncs.resize(id + 1);
 	auto &funcmap = typefuncs[id];
 	if(funcmap.find(name) != funcmap.end()) return false;
 	funcmap[name] = fn;
@@ -51,47 +60,44 @@ bool ValueManager::exists(StringRef var, bool top_only)
 	}
 	return globals.exists(var);
 }
-bool ValueManager::existsTypeFn(Type *ty, StringRef name)
-{
-	uint32_t id = ty->getID();
-	if(typefuncs.find(id) == typefuncs.end()) {
-		typefuncs[id] = {};
-	}
-	auto &funcmap = typefuncs[id];
-	return funcmap.find(name) != funcmap.end();
-}
+bool ValueManager::existsTypeFn(Type *ty, StringRef name) { return getTyFn(ty, name); }
 Type *ValueManager::getTy(StringRef var, bool top_only)
 {
-	VarDecl *decl = getAll(var, top_only);
-	return decl ? decl->ty : nullptr;
+	VarDecl decl;
+	return getAll(var, top_only, decl) ? decl.ty : nullptr;
 }
 Value *ValueManager::getVal(StringRef var, bool top_only)
 {
-	VarDecl *decl = getAll(var, top_only);
-	return decl ? decl->val : nullptr;
+	VarDecl decl;
+	return getAll(var, top_only, decl) ? decl.val : nullptr;
 }
 StmtVar *ValueManager::getDecl(StringRef var, bool top_only)
 {
-	VarDecl *decl = getAll(var, top_only);
-	return decl ? decl->decl : nullptr;
+	VarDecl decl;
+	return getAll(var, top_only, decl) ? decl.decl : nullptr;
 }
-VarDecl *ValueManager::getAll(StringRef var, bool top_only)
+bool ValueManager::getAll(StringRef var, bool top_only, VarDecl &res)
 {
 	if(!funcstack.empty()) {
-		VarDecl *res = funcstack.back().getAll(var, top_only);
-		if(res || top_only) return res;
+		bool found = funcstack.back().getAll(var, top_only, res);
+		if(found || top_only) return found;
 	}
-	return globals.getAll(var);
+	return globals.getAll(var, res);
 }
 FuncVal *ValueManager::getTyFn(Type *ty, StringRef name)
 {
-	uint32_t id = ty->getID();
-	if(typefuncs.find(id) == typefuncs.end()) {
-		typefuncs[id] = {};
+	uint32_t id	      = ty->getID();
+	size_t slot	      = ((uintptr_t)name.data() >> 3 ^ id * 31) % TYFN_CACHE_SIZE;
+	TyFnCacheEntry &entry = tyfncache[slot];
+	if(entry.id == id && entry.name == name.data() && entry.len == name.size()) {
+		return entry.fn;
 	}
+	if(id >= typefuncs.size()) return nullptr;
 	auto &funcmap = typefuncs[id];
 	auto found    = funcmap.find(name);
 	if(found == funcmap.end()) return nullptr;
+	// only hits are cached as a type function cannot be replaced once added
+	entry = {id, name.data(), name.size(), found->second};
 	return found->second;
 }
 } // namespace sc
\ No newline at end of file
@@ -40,8 +40,9 @@ Value *IntVal::clone(Context &c)
 }
 bool IntVal::updateValue(Context &c, Value *v)
 {
-	if(!v->isInt()) return false;
-	data	 = as<IntVal>(v)->getVal();
+	if(v->isFlt()) data = as<FltVal>(v)->getVal();
+	else if(v->isInt()) data = as<IntVal>(v)->getVal();
+	else return false;
 	has_data = v->getHasData() == CDTRUE || v->getHasData() == CDPERMA ? CDTRUE : CDFALSE;
 	return true;
 }
@@ -59,8 +60,9 @@ String FltVal::toStr() { return std::to_string(data); }
 Value *FltVal::clone(Context &c) { return create(c, has_data, data); }
 bool FltVal::updateValue(Context &c, Value *v)
 {
-	if(!v->isFlt()) return false;
-	data	 = as<FltVal>(v)->getVal();
+	if(v->isInt()) data = as<IntVal>(v)->getVal();
+	else if(v->isFlt()) data = as<FltVal>(v)->getVal();
+	else return false;
 	has_data = v->getHasData() == CDTRUE || v->getHasData() == CDPERMA ? CDTRUE : CDFALSE;
 	return true;
 }
@@ -71,34 +73,94 @@ FltVal *FltVal::create(Context &c, ContainsData has_data, const long double &val
 }
 
 VecVal::VecVal(Context &c, ContainsData has_data, const Vector<Value *> &data)
-	: Value(VVEC, has_data), data(data)
+	: Value(VVEC, has_data), ctx(c), data(data), src(nullptr), strcd(CDFALSE), packed(false),
+	  exposed(false)
 {}
+VecVal::VecVal(Context &c, ContainsData has_data, VecVal *src)
+	: Value(VVEC, has_data), ctx(c), src(src), strcd(CDFALSE), packed(false), exposed(false)
+{}
+VecVal::VecVal(Context &c, ContainsData has_data, ContainsData strcd, StringRef str)
+	: Value(VVEC, has_data), ctx(c), src(nullptr), str(str), strcd(strcd), packed(true),
+	  exposed(false)
+{}
+
+const Vector<Value *> &VecVal::view()
+{
+	if(packed) detach();
+	return src ? src->data : data;
+}
+void VecVal::detach()
+{
+	if(packed) {
+		data.reserve(str.size());
+		for(auto &ch : str) {
+			data.push_back(IntVal::create(ctx, strcd, ch));
+		}
+		packed = false;
+		return;
+	}
+	if(src) {
+		data.reserve(src->data.size());
+		for(auto &d : src->data) {
+			data.push_back(d->clone(ctx));
+		}
+		src = nullptr;
+	}
+	// the elements of this value may be modified now, so the lazy clones need their own copy
+	for(auto &lc : lazyclones) {
+		if(lc->src == this) lc->detach();
+	}
+	lazyclones.clear();
+}
 
 String VecVal::toStr()
 {
 	String res = "[";
-	for(size_t i = 0; i < data.size(); ++i) {
-		res += data[i]->toStr();
-		if(i < data.size() - 1) res += ", ";
+	if(packed) {
+		// same as the char values would give
+		for(size_t i = 0; i < str.size(); ++i) {
+			res += std::to_string((int64_t)str[i]);
+			if(i < str.size() - 1) res += ", ";
+		}
+		res += "]";
+		return res;
+	}
+	const Vector<Value *> &elems = view();
+	for(size_t i = 0; i < elems.size(); ++i) {
+		res += elems[i]->toStr();
+		if(i < elems.size() - 1) res += ", ";
 	}
 	res += "]";
 	return res;
 }
 Value *VecVal::clone(Context &c)
 {
-	Vector<Value *> newdata;
-	for(auto &d : data) {
-		newdata.push_back(d->clone(c));
+	ContainsData cd = has_data == CDPERMA ? CDTRUE : has_data;
+	if(packed) return c.allocVal<VecVal>(cd, strcd == CDPERMA ? CDTRUE : strcd, str);
+	if(exposed) {
+		Vector<Value *> elems;
+		elems.reserve(data.size());
+		for(auto &d : data) elems.push_back(d->clone(c));
+		return c.allocVal<VecVal>(cd, elems);
 	}
-	return create(c, has_data == CDPERMA ? CDTRUE : has_data, newdata);
+	VecVal *owner = src ? src : this;
+	VecVal *res   = c.allocVal<VecVal>(cd, owner);
+	owner->lazyclones.push_back(res);
+	return res;
 }
 bool VecVal::updateValue(Context &c, Value *v)
 {
 	if(!v->isVec()) return false;
 	VecVal *vv = as<VecVal>(v);
-	if(data.size() != vv->getVal().size()) return false;
+	if(size() != vv->size()) return false;
+	if(packed && vv->packed) {
+		str   = vv->str;
+		strcd = vv->strcd == CDFALSE ? CDFALSE : CDTRUE;
+		goto end;
+	}
+	detach();
 	for(size_t i = 0; i < data.size(); ++i) {
-		if(!data[i]->updateValue(c, vv->getValAt(i))) return false;
+		if(!data[i]->updateValue(c, vv->view()[i])) return false;
 	}
 end:
 	has_data = v->getHasData() == CDTRUE || v->getHasData() == CDPERMA ? CDTRUE : CDFALSE;
@@ -111,32 +173,47 @@ VecVal *VecVal::create(Context &c, ContainsData has_data, const Vector<Value *>
 }
 VecVal *VecVal::createStr(Context &c, ContainsData has_data, StringRef val)
 {
-	Vector<Value *> chars;
-	for(auto &ch : val) {
-		chars.push_back(IntVal::create(c, has_data, ch));
-	}
-	return create(c, has_data, chars);
+	return c.allocVal<VecVal>(has_data, has_data, c.strFrom({val}));
 }
 String VecVal::getAsString()
 {
+	if(packed) return String(str);
 	String res;
-	for(auto &ch : data) {
+	for(auto &ch : view()) {
 		res.push_back(as<IntVal>(ch)->getVal());
 	}
 	return res;
 }
 
 StructVal::StructVal(Context &c, ContainsData has_data, const Map<StringRef, Value *> &data)
-	: Value(VSTRUCT, has_data), data(data)
+	: Value(VSTRUCT, has_data), ctx(c), data(data), src(nullptr), exposed(false)
 {}
+StructVal::StructVal(Context &c, ContainsData has_data, StructVal *src)
+	: Value(VSTRUCT, has_data), ctx(c), src(src), exposed(false)
+{}
+
+const Map<StringRef, Value *> &StructVal::view() { return src ? src->data : data; }
+void StructVal::detach()
+{
+	if(src) {
+		for(auto &d : src->data) {
+			data[d.first] = d.second->clone(ctx);
+		}
+		src = nullptr;
+	}
+	for(auto &lc : lazyclones) {
+		if(lc->src == this) lc->detach();
+	}
+	lazyclones.clear();
+}
 
 String StructVal::toStr()
 {
 	String res = "{";
-	for(auto &d : data) {
+	for(auto &d : view()) {
 		res += String(d.first) + ": " + d.second->toStr() + ", ";
 	}
-	if(!data.empty()) {
+	if(size() > 0) {
 		res.pop_back();
 		res.pop_back();
 	}
@@ -145,19 +222,27 @@ String StructVal::toStr()
 }
 Value *StructVal::clone(Context &c)
 {
-	Map<StringRef, Value *> newdata;
-	for(auto &d : data) {
-		newdata[d.first] = d.second->clone(c);
+	ContainsData cd = has_data == CDPERMA ? CDTRUE : has_data;
+	if(exposed) {
+		Map<StringRef, Value *> fields;
+		for(auto &d : data) fields[d.first] = d.second->clone(c);
+		return c.allocVal<StructVal>(cd, fields);
 	}
-	return create(c, has_data == CDPERMA ? CDTRUE : has_data, newdata);
+	StructVal *owner = src ? src : this;
+	StructVal *res	 = c.allocVal<StructVal>(cd, owner);
+	owner->lazyclones.push_back(res);
+	return res;
 }
 bool StructVal::updateValue(Context &c, Value *v)
 {
 	if(!v->isStruct()) return false;
 	StructVal *sv = as<StructVal>(v);
-	if(data.size() != sv->getVal().size()) return false;
+	if(size() != sv->size()) return false;
+	detach();
 	for(auto &f : data) {
-		if(!f.second->updateValue(c, sv->getField(f.first))) return false;
+		auto loc = sv->view().find(f.first);
+		if(loc == sv->view().end()) return false;
+		if(!f.second->updateValue(c, loc->second)) return false;
 	}
 	has_data = v->getHasData() == CDTRUE || v->getHasData() == CDPERMA ? CDTRUE : CDFALSE;
 	return true;
@@ -173,7 +258,12 @@ StructVal *StructVal::createStrRef(Context &c, ContainsData has_data, StringRef
 	Map<StringRef, Value *> m = {{"data", s}, {"length", i}};
 	return create(c, has_data, m);
 }
-String StructVal::getStrFromRef() { return as<VecVal>(getField("data"))->getAsString(); }
+String StructVal::getStrFromRef()
+{
+	auto loc = view().find("data");
+	if(loc == view().end()) return "";
+	return as<VecVal>(loc->second)->getAsString();
+}
 
 FuncVal::FuncVal(Context &c, FuncTy *val) : Value(VFUNC, CDPERMA), ty(val) {}
 